@@ -0,0 +1,386 @@
+#pragma once
+
+// ==========================================
+//   [DSA CONCEPT: SPATIAL PARTITION] ARENA
+// ==========================================
+// Thousands of AI snakes and many food items on one big rectangular
+// map. The whole map is one grid of 32-bit cells saying who is there
+// (nothing, a wall, food, or the snake with that id), shared by every
+// snake, so a collision is one lookup however many snakes there are.
+//
+// The map is cut into horizontal strips, each a whole number of food
+// buckets tall, and a tick runs as phases over them on all cores:
+//   1. decide  - per strip, for the snakes whose head is in it: pick a
+//                direction from the grid as it stood at the start of the
+//                tick (read only) and post the move to the strip that
+//                owns the target cell
+//   2. resolve - per strip, for the moves into it: sort by (cell, id);
+//                two or more heads on one cell all die (head-on), a move
+//                into a wall or a body dies, except into the tail of a
+//                snake that is not growing, since that tail moves away
+//                this tick. Every contested cell lands in exactly one
+//                strip, so moves across a strip border need no locks.
+//   3. clear   - per block of snakes: dead bodies and moving tails are
+//                cleared. Each cell belongs to one snake, so no two
+//                writes meet.
+//   4. advance - per strip: surviving heads move in and eat.
+// then, on one thread, eaten food and dead snakes respawn from one
+// seeded generator. Every phase writes only what its task owns and the
+// serial step runs in a fixed order, so a run gives the same result,
+// bit for bit, on any number of threads.
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include "engine.h"
+#include "pool.h"
+
+struct ArenaConfig {
+    int width = 1024, height = 1024;
+    int snakes = 1000;
+    int food = 4000;        // Food items kept on the map
+    int obstacles = 1000;   // Wall cells scattered inside the border
+    int respawnDelay = 10;  // Ticks a dead snake waits before it returns
+    uint32_t seed = 1;
+};
+
+struct ArenaStats {
+    long long ticks = 0;
+    long long eaten = 0;
+    long long hitWall = 0, hitBody = 0, headOn = 0;
+    long long respawns = 0;
+    int alive = 0;
+    int longest = 0;
+};
+
+class Arena {
+public:
+    // Grid values; a snake with id s is stored as SNAKE_BASE + s
+    enum : uint32_t { EMPTY = 0, WALL = 1, FOOD = 2, SNAKE_BASE = 3 };
+    enum { BUCKET = 32 }; // Food bucket side; strips are whole buckets tall
+
+private:
+    enum Fate : uint8_t { MOVE, EAT, DIE_WALL, DIE_BODY, DIE_HEAD_ON };
+
+    struct ArenaSnake {
+        std::vector<int> ring; // Body cells; grows by doubling
+        int head = 0, count = 0, length = 0;
+        Direction dir = UP;
+        int target = -1;       // Food cell it is heading for
+        int next = -1;         // This tick's target cell
+        Fate fate = MOVE;
+        bool alive = false;
+        long long deadSince = 0;
+
+        int at(int k) const { return ring[(head + k) % ring.size()]; }
+        int tail() const { return at(count - 1); }
+        bool growing() const { return count < length; }
+    };
+
+    struct Move {
+        int cell;
+        uint32_t snake;
+        bool operator<(const Move& o) const { return cell != o.cell ? cell < o.cell : snake < o.snake; }
+    };
+
+    // Per-strip work lists and per-strip stats, each touched by one task
+    struct Strip {
+        std::vector<uint32_t> snakes;   // Heads in this strip, by id
+        std::vector<Move> incoming;     // Moves into this strip
+        long long eaten = 0, hitWall = 0, hitBody = 0, headOn = 0;
+    };
+
+    ArenaConfig cfg;
+    int width, height;
+    std::vector<uint32_t> grid;
+    std::vector<int> bucketFood; // Food count per BUCKET x BUCKET block
+    int bucketsX, bucketsY;
+    int stripRows, stripCount;
+    std::vector<ArenaSnake> snakes;
+    std::vector<Strip> strips;
+    std::vector<std::vector<std::vector<Move>>> outbox; // [from strip][to strip]
+    int foodCount;
+    SeededRandom rng;
+    PhasePool pool;
+    ArenaStats stats;
+
+    int stripOf(int cell) const { return cell / width / stripRows; }
+    int bucketOf(int cell) const { return (cell / width / BUCKET) * bucketsX + (cell % width) / BUCKET; }
+
+    static int step(int cell, Direction d, int width) {
+        return d == LEFT ? cell - 1 : d == RIGHT ? cell + 1 : d == UP ? cell - width : cell + width;
+    }
+
+    // Could a head move into `cell` this tick, judging by the grid at
+    // the start of the tick? A non-growing snake's tail moves away.
+    bool enterable(int cell) const {
+        uint32_t v = grid[cell];
+        if (v == EMPTY || v == FOOD) return true;
+        if (v < SNAKE_BASE) return false;
+        const ArenaSnake& s = snakes[v - SNAKE_BASE];
+        return cell == s.tail() && !s.growing();
+    }
+
+    // Is some other snake's head next to `cell`?
+    bool nearHead(int cell, int self) const {
+        int around[4] = {cell - 1, cell + 1, cell - width, cell + width};
+        for (int c : around) {
+            uint32_t v = grid[c];
+            if (c != self && v >= SNAKE_BASE && snakes[v - SNAKE_BASE].at(0) == c) return true;
+        }
+        return false;
+    }
+
+    // Nearest food, searching rings of buckets out from the head's; the
+    // first ring with any food wins, even if a further one is closer
+    int findFood(int from) const {
+        int bx = (from % width) / BUCKET, by = (from / width) / BUCKET;
+        int fx = from % width, fy = from / width;
+        for (int r = 0; r <= 4; r++) {
+            int best = -1, bestDist = 1 << 30;
+            for (int y = by - r; y <= by + r; y++) {
+                for (int x = bx - r; x <= bx + r; x++) {
+                    if (std::max(std::abs(x - bx), std::abs(y - by)) != r) continue;
+                    if (x < 0 || y < 0 || x >= bucketsX || y >= bucketsY || !bucketFood[y * bucketsX + x]) continue;
+                    int y1 = std::min(height, (y + 1) * BUCKET), x1 = std::min(width, (x + 1) * BUCKET);
+                    for (int cy = y * BUCKET; cy < y1; cy++)
+                        for (int cx = x * BUCKET; cx < x1; cx++) {
+                            if (grid[cy * width + cx] != FOOD) continue;
+                            int d = std::abs(cx - fx) + std::abs(cy - fy);
+                            if (d < bestDist) { bestDist = d; best = cy * width + cx; }
+                        }
+                }
+            }
+            if (best >= 0) return best;
+        }
+        return -1;
+    }
+
+    // Toward the target food, else anything open; never backwards
+    Direction choose(ArenaSnake& s) {
+        int h = s.at(0);
+        if (s.target < 0 || grid[s.target] != FOOD) s.target = findFood(h);
+        Direction order[4];
+        int n = 0;
+        if (s.target >= 0) {
+            int dx = s.target % width - h % width, dy = s.target / width - h / width;
+            if (dx < 0) order[n++] = LEFT;
+            if (dx > 0) order[n++] = RIGHT;
+            if (dy < 0) order[n++] = UP;
+            if (dy > 0) order[n++] = DOWN;
+        }
+        // Ties go round from the current direction, so snakes do not all
+        // prefer the same corner
+        static const Direction ring[] = {UP, RIGHT, DOWN, LEFT};
+        int start = s.dir == UP ? 0 : s.dir == RIGHT ? 1 : s.dir == DOWN ? 2 : 3;
+        for (int k = 0; k < 4; k++) {
+            Direction d = ring[(start + k) % 4];
+            if (std::find(order, order + n, d) == order + n) order[n++] = d;
+        }
+        // A cell next to another head may be taken by it this tick: use
+        // one only when nothing else is open
+        Direction risky = STOP;
+        for (int i = 0; i < 4; i++) {
+            Direction d = order[i];
+            if ((s.dir == LEFT && d == RIGHT) || (s.dir == RIGHT && d == LEFT) ||
+                (s.dir == UP && d == DOWN) || (s.dir == DOWN && d == UP)) continue;
+            int c = step(h, d, width);
+            if (!enterable(c)) continue;
+            if (!nearHead(c, h)) return d;
+            if (risky == STOP) risky = d;
+        }
+        return risky != STOP ? risky : s.dir; // Boxed in: keep going
+    }
+
+    void placeFood(int cell) {
+        grid[cell] = FOOD;
+        bucketFood[bucketOf(cell)]++;
+        foodCount++;
+    }
+
+    // Three free cells in a column: head on top, facing up
+    bool placeSnake(uint32_t id) {
+        for (int attempt = 0; attempt < 16; attempt++) {
+            int x = 1 + rng.next(width - 2), y = 1 + rng.next(height - 4);
+            int c = y * width + x;
+            if (grid[c] != EMPTY || grid[c + width] != EMPTY || grid[c + 2 * width] != EMPTY) continue;
+            ArenaSnake& s = snakes[id];
+            if (s.ring.size() < 4) s.ring.assign(4, 0);
+            s.head = 0;
+            s.count = s.length = 3;
+            for (int k = 0; k < 3; k++) {
+                s.ring[k] = c + k * width;
+                grid[c + k * width] = SNAKE_BASE + id;
+            }
+            s.dir = UP;
+            s.target = -1;
+            s.alive = true;
+            return true;
+        }
+        return false;
+    }
+
+    void decide(int strip) {
+        for (uint32_t id : strips[strip].snakes) {
+            ArenaSnake& s = snakes[id];
+            s.dir = choose(s);
+            s.next = step(s.at(0), s.dir, width);
+            outbox[strip][stripOf(s.next)].push_back({s.next, id});
+        }
+    }
+
+    void resolve(int strip) {
+        Strip& st = strips[strip];
+        st.incoming.clear();
+        for (int from = 0; from < stripCount; from++) {
+            std::vector<Move>& box = outbox[from][strip];
+            st.incoming.insert(st.incoming.end(), box.begin(), box.end());
+            box.clear();
+        }
+        std::sort(st.incoming.begin(), st.incoming.end());
+        for (size_t i = 0; i < st.incoming.size();) {
+            size_t j = i + 1;
+            while (j < st.incoming.size() && st.incoming[j].cell == st.incoming[i].cell) j++;
+            int cell = st.incoming[i].cell;
+            Fate fate;
+            if (j - i > 1) fate = DIE_HEAD_ON;
+            else if (grid[cell] == WALL) fate = DIE_WALL;
+            else if (grid[cell] == FOOD) fate = EAT;
+            else if (!enterable(cell)) fate = DIE_BODY;
+            else fate = MOVE;
+            for (size_t k = i; k < j; k++) snakes[st.incoming[k].snake].fate = fate;
+            if (fate == DIE_HEAD_ON) st.headOn += j - i;
+            else if (fate == DIE_WALL) st.hitWall++;
+            else if (fate == DIE_BODY) st.hitBody++;
+            i = j;
+        }
+    }
+
+    void clear(int block, int blocks) {
+        size_t n = snakes.size();
+        size_t lo = n * block / blocks, hi = n * (block + 1) / blocks;
+        for (size_t id = lo; id < hi; id++) {
+            ArenaSnake& s = snakes[id];
+            if (!s.alive) continue;
+            if (s.fate >= DIE_WALL) {
+                for (int k = 0; k < s.count; k++) grid[s.at(k)] = EMPTY;
+                s.alive = false;
+                s.deadSince = stats.ticks;
+            } else if (!s.growing()) {
+                grid[s.tail()] = EMPTY;
+                s.count--;
+            }
+        }
+    }
+
+    void advance(int strip) {
+        Strip& st = strips[strip];
+        for (const Move& m : st.incoming) {
+            ArenaSnake& s = snakes[m.snake];
+            if (s.fate >= DIE_WALL) continue;
+            if (s.fate == EAT) {
+                bucketFood[bucketOf(m.cell)]--;
+                st.eaten++;
+                s.length++;
+            }
+            if (s.count == (int)s.ring.size()) {
+                // Unroll the ring into a bigger one, head at slot 0
+                std::vector<int> bigger(s.ring.size() * 2);
+                for (int k = 0; k < s.count; k++) bigger[k] = s.at(k);
+                s.ring.swap(bigger);
+                s.head = 0;
+            }
+            s.head = (s.head == 0 ? (int)s.ring.size() : s.head) - 1;
+            s.ring[s.head] = m.cell;
+            s.count++;
+            grid[m.cell] = SNAKE_BASE + m.snake;
+        }
+    }
+
+    // Serial: respawns, then regroup the snakes by head strip
+    void settle() {
+        long long eaten = 0;
+        for (Strip& st : strips) {
+            eaten += st.eaten;
+            stats.hitWall += st.hitWall;
+            stats.hitBody += st.hitBody;
+            stats.headOn += st.headOn;
+            st.eaten = st.hitWall = st.hitBody = st.headOn = 0;
+            st.snakes.clear();
+        }
+        stats.eaten += eaten;
+        foodCount -= (int)eaten;
+        for (int tries = 0; foodCount < cfg.food && tries < 4 * cfg.food; tries++) {
+            int c = rng.next(width * height);
+            if (grid[c] == EMPTY) placeFood(c);
+        }
+
+        stats.alive = 0;
+        stats.longest = 0;
+        for (uint32_t id = 0; id < snakes.size(); id++) {
+            ArenaSnake& s = snakes[id];
+            if (!s.alive && stats.ticks - s.deadSince >= cfg.respawnDelay && placeSnake(id)) stats.respawns++;
+            if (!s.alive) continue;
+            stats.alive++;
+            stats.longest = std::max(stats.longest, s.length);
+            strips[stripOf(s.at(0))].snakes.push_back(id);
+        }
+    }
+
+public:
+    Arena(const ArenaConfig& config, int threads)
+        : cfg(config), width(std::max(config.width, 8)), height(std::max(config.height, 8)),
+          foodCount(0), rng(config.seed), pool(threads) {
+        grid.assign((size_t)width * height, EMPTY);
+        for (int x = 0; x < width; x++) grid[x] = grid[(size_t)(height - 1) * width + x] = WALL;
+        for (int y = 0; y < height; y++) grid[(size_t)y * width] = grid[(size_t)y * width + width - 1] = WALL;
+        bucketsX = (width + BUCKET - 1) / BUCKET;
+        bucketsY = (height + BUCKET - 1) / BUCKET;
+        bucketFood.assign((size_t)bucketsX * bucketsY, 0);
+
+        // A few strips per thread so a crowded one does not hold up the tick
+        int want = std::max(1, 4 * pool.getThreads());
+        stripRows = BUCKET * std::max(1, bucketsY / want);
+        stripCount = (height + stripRows - 1) / stripRows;
+        strips.resize(stripCount);
+        outbox.assign(stripCount, std::vector<std::vector<Move>>(stripCount));
+
+        for (int i = 0; i < cfg.obstacles; i++) {
+            int c = rng.next(width * height);
+            if (grid[c] == EMPTY) grid[c] = WALL;
+        }
+        snakes.resize(cfg.snakes);
+        for (uint32_t id = 0; id < snakes.size(); id++) placeSnake(id);
+        settle();
+    }
+
+    void tick() {
+        pool.run(stripCount, [this](int s) { decide(s); });
+        pool.run(stripCount, [this](int s) { resolve(s); });
+        int blocks = std::min(stripCount, std::max(1, (int)snakes.size() / 256));
+        pool.run(blocks, [this, blocks](int b) { clear(b, blocks); });
+        pool.run(stripCount, [this](int s) { advance(s); });
+        stats.ticks++;
+        settle();
+    }
+
+    // FNV-1a over the grid and every snake: equal hashes, equal arenas
+    uint64_t hash() const {
+        uint64_t h = 1469598103934665603ULL;
+        auto mix = [&h](uint64_t v) { h = (h ^ v) * 1099511628211ULL; };
+        for (uint32_t v : grid) mix(v);
+        for (const ArenaSnake& s : snakes) {
+            mix(s.alive);
+            mix((uint64_t)s.length);
+            if (s.alive) mix((uint64_t)s.at(0));
+        }
+        return h;
+    }
+
+    const ArenaStats& getStats() { return stats; }
+    int getThreads() { return pool.getThreads(); }
+    int getStrips() { return stripCount; }
+    int getWidth() { return width; }
+    int getHeight() { return height; }
+};
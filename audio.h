@@ -0,0 +1,166 @@
+#pragma once
+
+// ==========================================
+//      ASYNCHRONOUS SOUND EVENT QUEUE
+// ==========================================
+// The tick posts a sound as one byte into a lock-free ring and carries
+// on; a worker thread plays it through an AudioSink. A tone holds the
+// worker for as long as it sounds (Beep blocks), so whatever is posted
+// meanwhile piles up in the ring. The worker then takes the whole pile
+// as one batch and plays each distinct sound in it once, in the order
+// first posted: five pickups during one beep become one more beep, not
+// half a second of backlog. A full ring drops the sound instead of
+// making the tick wait.
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include "ring.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+enum Sound { SOUND_FOOD = 0, SOUND_GAMEOVER, SOUND_COUNT };
+
+struct Tone {
+    int hz, ms;
+};
+
+inline Tone toneOf(Sound s) {
+    static const Tone tones[SOUND_COUNT] = {{1000, 100}, {300, 400}};
+    return tones[s];
+}
+
+// Plays one sound to the end. Runs on the audio worker, so blocking for
+// the length of the tone is expected.
+class AudioSink {
+public:
+    virtual ~AudioSink() {}
+    virtual void play(Sound s) = 0;
+};
+
+#ifdef _WIN32
+// The PC speaker tone the game always made
+class BeepSink : public AudioSink {
+public:
+    void play(Sound s) override {
+        Tone t = toneOf(s);
+        Beep(t.hz, t.ms);
+    }
+};
+#else
+// Terminals have no tone generator: ring the bell, then hold the worker
+// for the tone's length so sounds coalesce the way Beep makes them
+class BellSink : public AudioSink {
+private:
+    int fd;
+
+public:
+    explicit BellSink(int fd = STDERR_FILENO) : fd(fd) {}
+
+    void play(Sound s) override {
+        if (write(fd, "\a", 1) != 1) return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(toneOf(s).ms));
+    }
+};
+#endif
+
+class NullSink : public AudioSink {
+public:
+    void play(Sound) override {}
+};
+
+// Remembers what was played, for checks. With `realTime` each sound
+// takes as long as its tone, like Beep.
+class RecordingSink : public AudioSink {
+private:
+    bool realTime;
+    std::mutex lock;
+    std::vector<Sound> played;
+
+public:
+    explicit RecordingSink(bool realTime = false) : realTime(realTime) {}
+
+    void play(Sound s) override {
+        if (realTime) std::this_thread::sleep_for(std::chrono::milliseconds(toneOf(s).ms));
+        std::lock_guard<std::mutex> hold(lock);
+        played.push_back(s);
+    }
+
+    std::vector<Sound> getPlayed() {
+        std::lock_guard<std::mutex> hold(lock);
+        return played;
+    }
+};
+
+class AudioQueue {
+private:
+    AudioSink& sink;
+    SpscRing<uint8_t, 64> ring;
+    std::thread worker;
+    std::atomic<bool> running;
+    std::atomic<long long> posted, played, coalesced, dropped;
+
+    void loop() {
+        for (;;) {
+            uint8_t s;
+            if (!ring.pop(s)) {
+                if (!running.load(std::memory_order_relaxed)) break; // Stopped and nothing left
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            // Everything posted while the last batch played is one batch
+            Sound batch[SOUND_COUNT];
+            bool queued[SOUND_COUNT] = {};
+            int n = 0;
+            do {
+                if (s >= SOUND_COUNT) continue;
+                if (queued[s]) { coalesced++; continue; }
+                queued[s] = true;
+                batch[n++] = (Sound)s;
+            } while (ring.pop(s));
+            for (int i = 0; i < n; i++) {
+                sink.play(batch[i]);
+                played++;
+            }
+        }
+    }
+
+public:
+    explicit AudioQueue(AudioSink& sink) : sink(sink), running(false), posted(0), played(0), coalesced(0), dropped(0) {}
+
+    ~AudioQueue() { stop(); }
+
+    AudioQueue(const AudioQueue&) = delete;
+    AudioQueue& operator=(const AudioQueue&) = delete;
+
+    void start() {
+        if (running) return;
+        running = true;
+        worker = std::thread(&AudioQueue::loop, this);
+    }
+
+    // Plays what is still queued, then joins the worker
+    void stop() {
+        if (!running) return;
+        running = false;
+        worker.join();
+    }
+
+    // Producer side (one thread, normally the tick): never blocks
+    void post(Sound s) {
+        posted.fetch_add(1, std::memory_order_relaxed);
+        if (!ring.push((uint8_t)s)) dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    long long getPosted() { return posted; }
+    long long getPlayed() { return played; }       // Sounds the sink played
+    long long getCoalesced() { return coalesced; } // Repeats merged into a batch
+    long long getDropped() { return dropped; }     // Lost to a full ring
+};
@@ -0,0 +1,300 @@
+#pragma once
+
+// ==========================================
+//   [DSA CONCEPT: A* SEARCH] AUTOPILOT
+// ==========================================
+// Steers the snake with A* over the Board (Manhattan heuristic). Body
+// cells are not walls for good: the segment k places from the head
+// leaves after (length - k) moves, so the search lets the head into a
+// body cell when it can only get there after that segment has gone. A
+// path to the food is taken only if, once the snake has followed it and
+// grown, the head could still reach its own tail. Otherwise the snake
+// wanders: it takes the move that keeps its tail in reach along the
+// longest path, and with no such move it heads into the largest open
+// region. A snake that wanders for as many ticks as the board has cells
+// is circling (or the food sits in a dead end) and takes the risk.
+//
+// A plan is kept and replayed while it still holds (the head is where
+// the plan expects, the food is where it was), so most ticks cost a
+// couple of lookups. Nothing else on the board moves, so a plan that was
+// safe when it was made stays safe. Searches run under a per-tick time
+// budget checked every few dozen expansions; one that runs out falls
+// back to any open move, without the region floods, instead of holding
+// up the tick.
+
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include "engine.h"
+#include "histogram.h"
+
+class Autopilot {
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    static const int CHECK_EVERY = 32; // Expansions between clock reads
+
+    struct Node {
+        int f, g, cell;
+    };
+    // Heap order: lowest f first, deeper (higher g) first on ties
+    struct Worse {
+        bool operator()(const Node& a, const Node& b) const { return a.f != b.f ? a.f > b.f : a.g < b.g; }
+    };
+
+    int width, height;
+    int avoid; // Cell the search must not enter (-1 for none)
+    Clock::duration budget;
+    Clock::time_point deadline;
+    bool outOfTime;
+
+    // Body the search is planning around: the moves until each cell is
+    // vacated, valid where bodyMark matches the current generation
+    std::vector<int> freeAfter;
+    std::vector<uint32_t> bodyMark;
+    uint32_t bodyGen;
+
+    // A* scratch, reused across searches via a generation stamp
+    std::vector<int> bestG, parent;
+    std::vector<uint32_t> seen;
+    uint32_t seenGen;
+    std::vector<Node> heap;
+    std::vector<int> path;       // Last search's cells, start excluded
+    std::vector<int> futureBody; // Body cells, head first, for markBody()
+
+    // The cached plan: the cells to walk, the next one and where the
+    // head must be for it to still apply
+    std::vector<int> plan;
+    size_t planPos;
+    int planHead, planFood;
+
+    long long wandering; // Ticks since the last food plan
+
+    Histogram decideTimes; // Nanoseconds per decide()
+    long long plans, reuses, fallbacks, overBudget;
+
+    static void bump(std::vector<uint32_t>& marks, uint32_t& gen) {
+        if (++gen == 0) { std::fill(marks.begin(), marks.end(), 0); gen = 1; }
+    }
+
+    // Segment k of a snake `length` long leaves after length - k moves
+    void markBody(int count, int length) {
+        bump(bodyMark, bodyGen);
+        for (int k = 0; k < count; k++) {
+            bodyMark[futureBody[k]] = bodyGen;
+            freeAfter[futureBody[k]] = length - k;
+        }
+    }
+
+    void markSnake(const BodyView& body, int length) {
+        futureBody.clear();
+        for (const Point& p : body) futureBody.push_back(p.y * width + p.x);
+        markBody(body.size(), length);
+    }
+
+    // Can the head enter `cell` on move t? Food counts as open.
+    bool enterable(const Board& board, int cell, int t) const {
+        Cell c = board.at(cell % width, cell / width);
+        if (c == CELL_VOID || c == CELL_OBSTACLE || cell == avoid) return false;
+        return bodyMark[cell] != bodyGen || t >= freeAfter[cell];
+    }
+
+    // Shortest time-aware path from `start` to `goal` around the marked
+    // body. Fills `path` (start excluded) and returns true when found.
+    bool search(const Board& board, int start, int goal) {
+        bump(seen, seenGen);
+        heap.clear();
+        path.clear();
+        int gx = goal % width, gy = goal / width;
+        auto h = [&](int c) { return std::abs(c % width - gx) + std::abs(c / width - gy); };
+
+        seen[start] = seenGen;
+        bestG[start] = 0;
+        parent[start] = -1;
+        heap.push_back({h(start), 0, start});
+        int expansions = 0;
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), Worse());
+            Node n = heap.back();
+            heap.pop_back();
+            if (n.g > bestG[n.cell]) continue; // Stale entry
+            if (n.cell == goal) {
+                for (int c = goal; c != start; c = parent[c]) path.push_back(c);
+                std::reverse(path.begin(), path.end());
+                return true;
+            }
+            if (++expansions % CHECK_EVERY == 0 && Clock::now() > deadline) {
+                outOfTime = true;
+                return false;
+            }
+            int x = n.cell % width, y = n.cell / width;
+            int next[4] = {x > 0 ? n.cell - 1 : -1, x + 1 < width ? n.cell + 1 : -1,
+                           y > 0 ? n.cell - width : -1, y + 1 < height ? n.cell + width : -1};
+            for (int c : next) {
+                if (c < 0 || !enterable(board, c, n.g + 1)) continue;
+                if (seen[c] == seenGen && bestG[c] <= n.g + 1) continue;
+                seen[c] = seenGen;
+                bestG[c] = n.g + 1;
+                parent[c] = n.cell;
+                heap.push_back({n.g + 1 + h(c), n.g + 1, c});
+                std::push_heap(heap.begin(), heap.end(), Worse());
+            }
+        }
+        return false;
+    }
+
+    // After walking `plan` to the food and growing by one, could the
+    // head still reach the tail?
+    bool safeAfterPlan(const Board& board, const BodyView& body, int length) {
+        int count = std::min(length, body.size() + (int)plan.size());
+        futureBody.clear();
+        for (size_t i = plan.size(); i-- > 0 && (int)futureBody.size() < count;) futureBody.push_back(plan[i]);
+        for (int k = 0; (int)futureBody.size() < count; k++) futureBody.push_back(body[k].y * width + body[k].x);
+        markBody(count, length + 1);
+        return search(board, futureBody[0], futureBody[count - 1]);
+    }
+
+    Direction toward(int from, int to) const {
+        if (to == from - 1) return LEFT;
+        if (to == from + 1) return RIGHT;
+        if (to == from - width) return UP;
+        return DOWN;
+    }
+
+    // No safe food path: take the move after which the tail is still in
+    // reach and furthest away, so the snake uncoils instead of circling
+    // in place; with no such move, the open neighbour with the most room.
+    // The food is off limits to the safe moves, since eating makes the
+    // tail wait. Each room is a whole-board flood, so none is started
+    // past the deadline: out of time, any open move will do, the current
+    // direction first.
+    Direction wander(Board& board, const BodyView& body, int length, int food, Direction cur) {
+        static const Direction dirs[] = {UP, RIGHT, DOWN, LEFT};
+        const Point& head = body[0];
+        int count = std::min(length, body.size() + 1);
+
+        // Open neighbours, judged against the snake as it stands (the
+        // tail searches below mark a moved one); -1 where blocked
+        int cells[4];
+        Direction cheap = cur == STOP ? UP : cur;
+        bool curOpen = false;
+        markSnake(body, length);
+        for (int i = 3; i >= 0; i--) {
+            int nx = head.x + (dirs[i] == LEFT ? -1 : dirs[i] == RIGHT ? 1 : 0);
+            int ny = head.y + (dirs[i] == UP ? -1 : dirs[i] == DOWN ? 1 : 0);
+            bool inside = (unsigned)nx < (unsigned)width && (unsigned)ny < (unsigned)height;
+            cells[i] = inside && enterable(board, ny * width + nx, 1) ? ny * width + nx : -1;
+            if (cells[i] < 0) continue;
+            if (!curOpen) cheap = dirs[i];
+            if (dirs[i] == cur) curOpen = true;
+        }
+
+        Direction safest = STOP, roomiest = STOP;
+        long long furthest = -1, most = -1;
+        for (int i = 0; i < 4; i++) {
+            int cell = cells[i];
+            if (cell < 0) continue;
+            if (!outOfTime && Clock::now() > deadline) outOfTime = true;
+            if (outOfTime) break;
+            long long room = board.regionSize({cell % width, cell / width});
+            if (room > most) { most = room; roomiest = dirs[i]; }
+            if (cell == food) continue;
+
+            futureBody.clear();
+            futureBody.push_back(cell);
+            for (int k = 0; k + 1 < count; k++) futureBody.push_back(body[k].y * width + body[k].x);
+            markBody(count, length);
+            avoid = food;
+            if (search(board, cell, futureBody[count - 1]) && (long long)path.size() > furthest) {
+                furthest = (long long)path.size();
+                safest = dirs[i];
+            }
+            avoid = -1;
+        }
+        return safest != STOP ? safest : roomiest != STOP ? roomiest : cheap;
+    }
+
+    Direction choose(Game& game) {
+        Board& board = *game.getBoard();
+        Snake* snake = game.getSnake();
+        const Point& head = snake->getHead();
+        Food* food = game.getFood();
+        int hc = head.y * width + head.x;
+        int fc = food->y * width + food->x;
+
+        if (planPos < plan.size() && planHead == hc && planFood == fc) {
+            reuses++;
+            planHead = plan[planPos++];
+            return toward(hc, planHead);
+        }
+        plan.clear();
+        planPos = 0;
+
+        BodyView body = snake->getBody();
+        int length = snake->getLength();
+        outOfTime = false;
+
+        // Food walled off by the body as it stands (one union-find
+        // query): it can only open up as the tail moves, so follow it
+        if (food->x >= 0 && game.getReachability()->isReachable(head, {food->x, food->y})) {
+            plans++;
+            markSnake(body, length);
+            if (search(board, hc, fc)) {
+                plan = path;
+                // Wandering for a whole board's worth of ticks means a
+                // loop (or food in a dead end): take the risk
+                bool stuck = wandering > (long long)width * height;
+                if (stuck || safeAfterPlan(board, body, length)) {
+                    wandering = 0;
+                    planPos = 1;
+                    planHead = plan[0];
+                    planFood = fc;
+                    return toward(hc, planHead);
+                }
+                plan.clear();
+            }
+        }
+
+        if (outOfTime) overBudget++;
+        fallbacks++;
+        wandering++;
+        return wander(board, body, length, fc, snake->getDirection());
+    }
+
+public:
+    // `budgetMicros` bounds the planning done in one decide() call
+    Autopilot(Game& game, double budgetMicros)
+        : width(game.getBoard()->getWidth()), height(game.getBoard()->getHeight()), avoid(-1),
+          budget(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::micro>(budgetMicros))),
+          outOfTime(false), bodyGen(0), seenGen(0), planPos(0), planHead(-1), planFood(-1), wandering(0),
+          plans(0), reuses(0), fallbacks(0), overBudget(0) {
+        size_t cells = (size_t)width * height;
+        freeAfter.assign(cells, 0);
+        bodyMark.assign(cells, 0);
+        bestG.assign(cells, 0);
+        parent.assign(cells, -1);
+        seen.assign(cells, 0);
+        heap.reserve(4 * cells);
+        path.reserve(cells);
+        futureBody.reserve(cells);
+        plan.reserve(cells);
+    }
+
+    // The direction for this tick
+    Direction decide(Game& game) {
+        Clock::time_point start = Clock::now();
+        deadline = start + budget;
+        Direction d = choose(game);
+        decideTimes.record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+        return d;
+    }
+
+    // Drop the cached plan (after a load or rewind)
+    void forget() { plan.clear(); planPos = 0; }
+
+    const Histogram& getDecideTimes() { return decideTimes; }
+    long long getPlans() { return plans; }       // Food searches started
+    long long getReuses() { return reuses; }     // Ticks served from the cache
+    long long getFallbacks() { return fallbacks; } // Tail or region moves
+    long long getOverBudget() { return overBudget; } // Searches cut short
+};
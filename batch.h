@@ -0,0 +1,287 @@
+#pragma once
+
+// ==========================================
+//   [DSA CONCEPT: WORK STEALING] BATCH SIM
+// ==========================================
+// Runs many independent games across all cores. Each worker owns a
+// range of game indices packed into one 64-bit atomic (begin | end):
+// the owner takes games off the front with a CAS, an idle worker steals
+// the back half of a victim's range with a CAS. Games never share state
+// (each has its own seeded RNG, clock and board), and every worker
+// counts into its own cache-line-aligned stats, merged once at the end,
+// so the tick loop never touches a lock or a shared counter.
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <functional>
+#include "engine.h"
+#include "histogram.h"
+
+struct GameSpec {
+    uint32_t seed;
+    MapType map;
+    int difficulty;
+    GameMode mode;
+    const MapData* layout = NULL; // A loaded map to play instead of `map`
+};
+
+// The game a spec describes (the caller deletes it)
+inline Game* newGame(const GameSpec& spec, RandomSource& rng, GameClock& clock) {
+    if (spec.layout) return new Game(spec.mode, *spec.layout, spec.difficulty, rng, clock);
+    return new Game(spec.mode, spec.map, spec.difficulty, rng, clock);
+}
+
+// Picks the direction for the next tick
+typedef Direction (*Policy)(Game& game);
+
+// Head toward the food, but never step onto a blocked cell if any
+// other move is open. Ties keep the snake moving rather than stopping.
+// `blocked(x, y)` says whether moving there is fatal, so a server client
+// can run it on its own copy of the board.
+template <class Blocked>
+Direction greedyToward(const Point& h, const Point& food, Direction cur, Blocked blocked) {
+    Direction order[4];
+    int n = 0;
+    if (food.x < h.x) order[n++] = LEFT;
+    if (food.x > h.x) order[n++] = RIGHT;
+    if (food.y < h.y) order[n++] = UP;
+    if (food.y > h.y) order[n++] = DOWN;
+    Direction all[] = {UP, RIGHT, DOWN, LEFT};
+    for (Direction d : all) {
+        bool seen = false;
+        for (int i = 0; i < n; i++) if (order[i] == d) seen = true;
+        if (!seen) order[n++] = d;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        Direction d = order[i];
+        if ((cur == LEFT && d == RIGHT) || (cur == RIGHT && d == LEFT) ||
+            (cur == UP && d == DOWN) || (cur == DOWN && d == UP)) continue;
+        int nx = h.x + (d == LEFT ? -1 : d == RIGHT ? 1 : 0);
+        int ny = h.y + (d == UP ? -1 : d == DOWN ? 1 : 0);
+        if (!blocked(nx, ny)) return d;
+    }
+    return cur == STOP ? UP : cur; // Boxed in
+}
+
+// The simple Policy the sim and the benchmarks play with
+inline Direction greedyTurn(Game& game) {
+    Food* f = game.getFood();
+    return greedyToward(game.getSnake()->getHead(), Point{f->x, f->y}, game.getSnake()->getDirection(),
+                        [&game](int x, int y) { return game.isBlocked(x, y); });
+}
+
+struct alignas(64) BatchStats {
+    long long games = 0;
+    long long ticks = 0;
+    long long scoreSum = 0;
+    long long lengthSum = 0;
+    int bestScore = 0;
+    long long deaths[WON + 1] = {}; // By DeathCause; ALIVE = hit the tick cap
+    long long steals = 0;
+    uint64_t digest = 0; // Sum of a hash of every game's end state: the same for any thread count
+    long long mapGames[CUSTOM + 1] = {};
+    long long mapWins[CUSTOM + 1] = {};
+
+    // Filled in by controllers that plan (see Controller::report)
+    Histogram decideNanos[CUSTOM + 1]; // Per map type
+    long long plans = 0, planReuses = 0, fallbacks = 0, overBudget = 0;
+
+    Metrics metrics; // Per-phase timings, when the runner collects them
+
+    void add(Game& game) {
+        games++;
+        ticks += game.getTicks();
+        scoreSum += game.getScore();
+        lengthSum += game.getSnake()->getLength();
+        if (game.getScore() > bestScore) bestScore = game.getScore();
+        deaths[game.getDeathCause()]++;
+        mapGames[game.getMapType()]++;
+        if (game.getDeathCause() == WON) mapWins[game.getMapType()]++;
+
+        // Addition commutes, so the order games finish in does not matter
+        const Point& h = game.getSnake()->getHead();
+        Food* f = game.getFood();
+        uint64_t hash = 1469598103934665603ULL;
+        for (long long v : {game.getTicks(), (long long)game.getScore(), (long long)game.getSnake()->getLength(),
+                            (long long)game.getDeathCause(), (long long)game.getMapType(), (long long)h.x,
+                            (long long)h.y, (long long)f->x, (long long)f->y})
+            hash = (hash ^ (uint64_t)v) * 1099511628211ULL;
+        digest += hash;
+    }
+
+    void merge(const BatchStats& o) {
+        games += o.games;
+        ticks += o.ticks;
+        scoreSum += o.scoreSum;
+        lengthSum += o.lengthSum;
+        if (o.bestScore > bestScore) bestScore = o.bestScore;
+        for (int i = 0; i <= WON; i++) deaths[i] += o.deaths[i];
+        steals += o.steals;
+        digest += o.digest;
+        for (int m = 0; m <= CUSTOM; m++) {
+            mapGames[m] += o.mapGames[m];
+            mapWins[m] += o.mapWins[m];
+            decideNanos[m].merge(o.decideNanos[m]);
+        }
+        plans += o.plans;
+        planReuses += o.planReuses;
+        fallbacks += o.fallbacks;
+        overBudget += o.overBudget;
+        metrics.merge(o.metrics);
+    }
+};
+
+// Steers one game. A fresh controller is made for every game, so it may
+// keep state between ticks (a cached plan); report() adds whatever it
+// measured to the worker's stats once the game is over.
+class Controller {
+public:
+    virtual ~Controller() {}
+    virtual Direction decide(Game& game) = 0;
+    virtual void report(Game& game, BatchStats& stats) { (void)game; (void)stats; }
+};
+
+// Makes the controller for a game that is about to start
+typedef std::function<std::unique_ptr<Controller>(Game& game)> ControllerFactory;
+
+// A stateless Policy as a Controller
+class PolicyController : public Controller {
+private:
+    Policy policy;
+
+public:
+    explicit PolicyController(Policy policy) : policy(policy) {}
+    Direction decide(Game& game) override { return policy(game); }
+};
+
+class BatchRunner {
+private:
+    // One worker's share of the game indices: begin in the low 32 bits,
+    // end in the high 32 bits, so both move together in a single CAS
+    struct alignas(64) WorkRange {
+        std::atomic<uint64_t> range;
+    };
+
+    static uint64_t pack(uint32_t begin, uint32_t end) { return ((uint64_t)end << 32) | begin; }
+    static uint32_t beginOf(uint64_t r) { return (uint32_t)r; }
+    static uint32_t endOf(uint64_t r) { return (uint32_t)(r >> 32); }
+
+    const std::vector<GameSpec>& specs;
+    ControllerFactory factory;
+    long long maxTicks;
+    int threads;
+    bool collectMetrics;
+    std::vector<WorkRange> ranges;
+    std::vector<BatchStats> perThread;
+    double elapsed;
+
+    // Owner side: take the next game from the front of our own range
+    bool takeOwn(int self, uint32_t& index) {
+        uint64_t r = ranges[self].range.load(std::memory_order_acquire);
+        while (beginOf(r) < endOf(r)) {
+            if (ranges[self].range.compare_exchange_weak(r, pack(beginOf(r) + 1, endOf(r)),
+                                                         std::memory_order_acq_rel)) {
+                index = beginOf(r);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Thief side: move the back half of some victim's range into ours
+    bool steal(int self, SeededRandom& pick) {
+        for (int attempt = 0; attempt < threads; attempt++) {
+            int victim = (self + 1 + pick.next(threads - 1)) % threads;
+            for (int i = 0; i < threads; i++, victim = (victim + 1) % threads) {
+                if (victim == self) continue;
+                uint64_t r = ranges[victim].range.load(std::memory_order_acquire);
+                while (beginOf(r) < endOf(r)) {
+                    uint32_t b = beginOf(r), e = endOf(r);
+                    uint32_t mid = b + (e - b) / 2;
+                    if (ranges[victim].range.compare_exchange_weak(r, pack(b, mid),
+                                                                   std::memory_order_acq_rel)) {
+                        // Our range is empty, so nobody else is writing it
+                        ranges[self].range.store(pack(mid, e), std::memory_order_release);
+                        perThread[self].steals++;
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    void playOne(const GameSpec& spec, BatchStats& stats) {
+        SeededRandom rng(spec.seed);
+        ManualClock clock;
+        std::unique_ptr<Game> owned(newGame(spec, rng, clock));
+        Game& game = *owned;
+        std::unique_ptr<Controller> controller = factory(game);
+        double dt = game.getTickPeriodMs() / 1000.0;
+        while (!game.isOver() && game.getTicks() < maxTicks) {
+            clock.advance(dt);
+            game.step(controller->decide(game));
+        }
+        stats.add(game);
+        controller->report(game, stats);
+    }
+
+    void worker(int self) {
+        SeededRandom pick(0x51ED + self);
+        BatchStats& stats = perThread[self];
+        std::unique_ptr<MetricsSession> session;
+        if (collectMetrics) session.reset(new MetricsSession(stats.metrics));
+        uint32_t index;
+        for (;;) {
+            while (takeOwn(self, index)) playOne(specs[index], stats);
+            if (threads == 1 || !steal(self, pick)) break; // Nothing left anywhere
+        }
+    }
+
+public:
+    // threads <= 0 means one per hardware thread
+    BatchRunner(const std::vector<GameSpec>& specs, ControllerFactory factory, long long maxTicks, int threads)
+        : specs(specs), factory(factory), maxTicks(maxTicks), threads(threads), collectMetrics(false), elapsed(0) {
+        if (this->threads <= 0) this->threads = (int)std::thread::hardware_concurrency();
+        if (this->threads <= 0) this->threads = 1;
+    }
+
+    BatchRunner(const std::vector<GameSpec>& specs, Policy policy, long long maxTicks, int threads)
+        : BatchRunner(specs, [policy](Game&) { return std::unique_ptr<Controller>(new PolicyController(policy)); },
+                      maxTicks, threads) {}
+
+    BatchStats run() {
+        ranges = std::vector<WorkRange>(threads);
+        perThread.assign(threads, BatchStats());
+
+        // Even split up front; stealing evens out games of uneven length
+        uint32_t n = (uint32_t)specs.size();
+        for (int t = 0; t < threads; t++) {
+            uint32_t b = (uint32_t)((uint64_t)n * t / threads);
+            uint32_t e = (uint32_t)((uint64_t)n * (t + 1) / threads);
+            ranges[t].range.store(pack(b, e));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; t++) pool.emplace_back(&BatchRunner::worker, this, t);
+        worker(0);
+        for (auto& th : pool) th.join();
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        BatchStats total;
+        for (auto& s : perThread) total.merge(s);
+        return total;
+    }
+
+    // Time the engine's phases into BatchStats::metrics (off by default:
+    // it reads the clock several times per tick)
+    void setMetrics(bool on) { collectMetrics = on; }
+
+    int getThreads() { return threads; }
+    double getElapsed() { return elapsed; }
+};
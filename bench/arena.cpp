@@ -0,0 +1,76 @@
+// ==========================================
+//    BENCHMARK: ARENA TICK SCALING
+// ==========================================
+// Runs the many-snake Arena on a 2048 x 2048 map with 1000 to 64000
+// snakes (four food items per snake) on 1, 2, 4, ... threads up to the
+// core count, and prints ms per tick, the speedup over one thread and
+// whether the final state hash matches the one-thread run. Each run
+// warms up for WARMUP ticks and then times TICKS.
+//
+//   bench_arena [--quick] [--size S] [--threads N]
+//
+// --quick stops at 16000 snakes; --threads N caps the thread counts.
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "../arena.h"
+
+using namespace std;
+
+static const int WARMUP = 20;
+static const int TICKS = 100;
+
+int main(int argc, char** argv) {
+    int size = 2048;
+    int maxThreads = (int)thread::hardware_concurrency();
+    bool quick = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--quick")) quick = true;
+        else if (!strcmp(argv[i], "--size") && i + 1 < argc) size = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) maxThreads = atoi(argv[++i]);
+        else {
+            cerr << "usage: " << argv[0] << " [--quick] [--size S] [--threads N]\n";
+            return 1;
+        }
+    }
+    if (maxThreads < 1) maxThreads = 1;
+
+    vector<int> threadCounts;
+    for (int t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    cout << "map " << size << "x" << size << ", " << TICKS << " ticks after " << WARMUP << " warm-up\n";
+    cout << setw(8) << "snakes" << setw(9) << "threads" << setw(11) << "ms/tick" << setw(9) << "speedup"
+         << setw(8) << "alive" << setw(7) << "hash" << "\n";
+    bool allSame = true;
+    for (int snakes : {1000, 4000, 16000, 64000}) {
+        if (quick && snakes > 16000) break;
+        ArenaConfig cfg;
+        cfg.width = cfg.height = size;
+        cfg.snakes = snakes;
+        cfg.food = 4 * snakes;
+        cfg.obstacles = size * size / 1000;
+
+        double base = 0;
+        uint64_t baseHash = 0;
+        for (int threads : threadCounts) {
+            Arena arena(cfg, threads);
+            for (int t = 0; t < WARMUP; t++) arena.tick();
+            auto t0 = chrono::steady_clock::now();
+            for (int t = 0; t < TICKS; t++) arena.tick();
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count() / TICKS;
+            uint64_t h = arena.hash();
+            if (threads == threadCounts[0]) { base = ms; baseHash = h; }
+            bool same = h == baseHash;
+            allSame = allSame && same;
+            cout << setw(8) << snakes << setw(9) << threads << setw(11) << fixed << setprecision(3) << ms
+                 << setw(8) << setprecision(2) << base / ms << "x" << setw(8) << arena.getStats().alive
+                 << setw(7) << (same ? "same" : "DIFF") << "\n";
+        }
+    }
+    return allSame ? 0 : 1;
+}
@@ -0,0 +1,405 @@
+// ==========================================
+//    BENCHMARK SUITE: ENGINE HOT PATHS
+// ==========================================
+// Times the engine's hot paths over a grid of map sizes and snake
+// lengths and prints one JSON document, so runs from two releases can
+// be compared (here with --compare, or by any tool that reads JSON):
+//   snake_move      Snake::move around a Hamiltonian cycle
+//   self_collision  Snake::isCollidingWithSelf after a move
+//   food_respawn    Food::respawn, then clearing the food again
+//   food_reachable  Food::isReachable from the head to a free cell
+//   generate_map    GameMap::generateMap for each shape
+//   draw            Renderer::present into a null sink, per frame:
+//                   "diff" as a game draws, "full" repainting everything
+//   tick            Game::step plus a greedy policy, per tick
+// Every result has an id (name/shape/WxH/Llength) that stays the same
+// between runs. A result is the median of 5 rounds, each long enough to
+// average out the clock; the fastest round is reported as well.
+//
+//   bench_engine [--quick] [--filter TEXT] [--out FILE]
+//                [--compare OLD.json [--threshold PCT]]
+//
+// --quick runs the standard map size and short rounds (a smoke run).
+// --compare reads an earlier run and lists every id that is more than
+// PCT percent (default 10) slower now; the exit status is 2 if any is.
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include "../engine.h"
+#include "../render.h"
+
+using namespace std;
+
+struct Result {
+    string id, name, shape, variant;
+    int width, height, length; // length 0: not a snake benchmark
+    long long ops;             // Per round
+    double ns, minNs;          // Median and fastest round, per op
+};
+
+static vector<Result> results;
+static string filter;
+static double roundSeconds = 0.02;
+static volatile long long sink; // Keeps results alive past the optimizer
+
+static string makeId(const string& name, const string& shape, const string& variant, int w, int h, int length) {
+    string id = name + "/" + shape;
+    if (!variant.empty()) id += "/" + variant;
+    id += "/" + to_string(w) + "x" + to_string(h);
+    if (length) id += "/L" + to_string(length);
+    return id;
+}
+
+static bool wanted(const string& id) { return filter.empty() || id.find(filter) != string::npos; }
+
+// `batch(n)` runs the operation n times and returns the nanoseconds it
+// spent on them (so a benchmark can leave its own setup out)
+template <class Batch>
+static void run(const string& name, const string& shape, const string& variant, int w, int h, int length,
+                Batch batch) {
+    Result r = {makeId(name, shape, variant, w, h, length), name, shape, variant, w, h, length, 1, 0, 0};
+    if (!wanted(r.id)) return;
+
+    // Grow the batch until one takes a full round
+    double target = roundSeconds * 1e9;
+    for (;;) {
+        double ns = batch(r.ops);
+        if (ns >= target || r.ops >= (1LL << 40)) break;
+        r.ops = ns > target / 64 ? (long long)(r.ops * target / ns) + 1 : r.ops * 64;
+    }
+    double rounds[5];
+    for (double& ns : rounds) ns = batch(r.ops) / r.ops;
+    sort(rounds, rounds + 5);
+    r.ns = rounds[2];
+    r.minNs = rounds[0];
+    results.push_back(r);
+    cerr << left << setw(44) << r.id << right << fixed << setprecision(2) << setw(12) << r.ns << " ns\n";
+}
+
+static double since(chrono::steady_clock::time_point t0) {
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+}
+
+// ==========================================
+//   FIXTURE: SNAKE ON A HAMILTONIAN CYCLE
+// ==========================================
+// A rectangular board (h even) and a snake of the given length that
+// follows a closed tour of every cell: right along row 0, zig-zag down
+// over columns 1..w-1, back up column 0. It never dies, so a move costs
+// the same however long the benchmark runs.
+struct CycleSnake {
+    RectangularMap map;
+    Board board;
+    Snake snake;
+    vector<Point> cycle;
+    int pos;
+
+    static GameMap* built(GameMap* m) {
+        m->generateMap();
+        return m;
+    }
+
+    CycleSnake(int w, int h, int length) : map(w, h), board(built(&map)), snake(0, 1, w * h, &board) {
+        for (int x = 0; x < w; x++) cycle.push_back({x, 0});
+        for (int y = 1; y < h; y++) {
+            if (y % 2 == 1) for (int x = w - 1; x >= 1; x--) cycle.push_back({x, y});
+            else for (int x = 1; x < w; x++) cycle.push_back({x, y});
+        }
+        for (int y = h - 1; y >= 1; y--) cycle.push_back({0, y});
+        // The snake starts at (0,1) hanging down column 0: the last three
+        // cells of the tour, so the next step is cycle[0]
+        pos = (int)cycle.size() - 1;
+        for (int i = 3; i < length; i++) snake.grow();
+        for (int i = 0; i < length; i++) advance();
+    }
+
+    Cell advance() {
+        int next = pos + 1 == (int)cycle.size() ? 0 : pos + 1;
+        const Point& a = cycle[pos];
+        const Point& b = cycle[next];
+        snake.setDirection(b.x < a.x ? LEFT : b.x > a.x ? RIGHT : b.y < a.y ? UP : DOWN);
+        pos = next;
+        return snake.move();
+    }
+};
+
+// Head toward the food without stepping onto a blocked cell
+static Direction greedy(Game& game) {
+    const Point& h = game.getSnake()->getHead();
+    Food* f = game.getFood();
+    Direction cur = game.getSnake()->getDirection();
+    Direction order[] = {f->x < h.x ? LEFT : RIGHT, f->y < h.y ? UP : DOWN, UP, RIGHT, DOWN, LEFT};
+    for (Direction d : order) {
+        if ((cur == LEFT && d == RIGHT) || (cur == RIGHT && d == LEFT) ||
+            (cur == UP && d == DOWN) || (cur == DOWN && d == UP)) continue;
+        int nx = h.x + (d == LEFT ? -1 : d == RIGHT ? 1 : 0);
+        int ny = h.y + (d == UP ? -1 : d == DOWN ? 1 : 0);
+        if (!game.isBlocked(nx, ny)) return d;
+    }
+    return cur == STOP ? UP : cur;
+}
+
+// A game that starts over (next seed) whenever it ends
+struct LoopingGame {
+    MapType type;
+    int w, h;
+    uint32_t seed;
+    SeededRandom rng;
+    ManualClock clock;
+    Game* game;
+
+    LoopingGame(MapType type, int w, int h) : type(type), w(w), h(h), seed(1), rng(1), game(NULL) { restart(); }
+    ~LoopingGame() { delete game; }
+
+    void restart() {
+        delete game;
+        rng = SeededRandom(seed++);
+        game = new Game(CLASSIC, type, 2, rng, clock, w, h);
+    }
+
+    // One tick; false when the game just ended
+    bool tick() {
+        clock.advance(game->getTickPeriodMs() / 1000.0);
+        game->step(greedy(*game));
+        return !game->isOver();
+    }
+};
+
+// ==========================================
+//             THE BENCHMARKS
+// ==========================================
+
+static void snakeBenches(int w, int h, int length) {
+    CycleSnake f(w, h, length);
+    run("snake_move", "rect", "", w, h, length, [&](long long n) {
+        long long hits = 0;
+        auto t0 = chrono::steady_clock::now();
+        for (long long i = 0; i < n; i++) hits += f.advance() == CELL_BODY;
+        double ns = since(t0);
+        sink = hits;
+        return ns;
+    });
+    run("self_collision", "rect", "", w, h, length, [&](long long n) {
+        long long hits = 0;
+        double ns = 0;
+        // Checked after each move, as Game::step does; moves are not timed
+        for (long long i = 0; i < n; i += 256) {
+            f.advance();
+            long long m = min(256LL, n - i);
+            auto t0 = chrono::steady_clock::now();
+            for (long long j = 0; j < m; j++) hits += f.snake.isCollidingWithSelf();
+            ns += since(t0);
+        }
+        sink = hits;
+        return ns;
+    });
+
+    // One unbiased bounded draw, the kind every respawn makes
+    SeededRandom rng(7);
+    run("rng_next", "rect", "", w, h, length, [&](long long n) {
+        long long sum = 0;
+        auto t0 = chrono::steady_clock::now();
+        for (long long i = 0; i < n; i++) sum += rng.next(w * h);
+        double ns = since(t0);
+        sink = sum;
+        return ns;
+    });
+
+    Reachability reach(f.board);
+    Food food;
+    run("food_respawn", "rect", "", w, h, length, [&](long long n) {
+        long long sum = 0;
+        auto t0 = chrono::steady_clock::now();
+        for (long long i = 0; i < n; i++) {
+            food.respawn(f.board, reach, &f.snake, rng);
+            sum += food.x;
+            f.board.set(food.x, food.y, CELL_FREE);
+        }
+        double ns = since(t0);
+        sink = sum;
+        return ns;
+    });
+
+    vector<Point> targets;
+    for (int i = 0; i < 1024; i++) targets.push_back(f.board.randomFree(rng));
+    const Point& head = f.snake.getHead();
+    run("food_reachable", "rect", "", w, h, length, [&](long long n) {
+        long long yes = 0;
+        auto t0 = chrono::steady_clock::now();
+        for (long long i = 0; i < n; i++) {
+            const Point& t = targets[i & 1023];
+            yes += food.isReachable(head.x, head.y, t.x, t.y, f.board);
+        }
+        double ns = since(t0);
+        sink = yes;
+        return ns;
+    });
+}
+
+template <class Shape>
+static void mapBench(const string& shape, int w, int h) {
+    ShapedMap<Shape> map(w, h);
+    run("generate_map", shape, "", w, h, 0, [&](long long n) {
+        auto t0 = chrono::steady_clock::now();
+        for (long long i = 0; i < n; i++) map.generateMap();
+        double ns = since(t0);
+        sink = map.isValid(w / 2, h / 2);
+        return ns;
+    });
+}
+
+static void gameBenches(MapType type, const string& shape, int w, int h) {
+    LoopingGame g(type, w, h);
+    run("tick", shape, "", w, h, 0, [&](long long n) {
+        double ns = 0;
+        auto t0 = chrono::steady_clock::now();
+        for (long long i = 0; i < n; i++) {
+            if (g.tick()) continue;
+            ns += since(t0); // Setting up the next game is not a tick
+            g.restart();
+            t0 = chrono::steady_clock::now();
+        }
+        return ns + since(t0);
+    });
+
+    for (int full = 0; full < 2; full++) {
+        LoopingGame d(type, w, h);
+        AnsiBackend nullSink(NULL);
+        Renderer* renderer = new Renderer(*d.game, nullSink);
+        run("draw", shape, full ? "full" : "diff", w, h, 0, [&](long long n) {
+            double ns = 0;
+            for (long long i = 0; i < n; i++) {
+                if (!d.tick()) {
+                    d.restart();
+                    delete renderer;
+                    renderer = new Renderer(*d.game, nullSink);
+                }
+                if (full) renderer->invalidate();
+                auto t0 = chrono::steady_clock::now();
+                renderer->present(*d.game);
+                ns += since(t0);
+            }
+            return ns;
+        });
+        delete renderer;
+    }
+}
+
+// ==========================================
+//                JSON OUT / IN
+// ==========================================
+
+static void writeJson(ostream& out) {
+    out << "{\n  \"suite\": \"engine\",\n";
+#if defined(__clang__)
+    out << "  \"compiler\": \"clang " << __clang_major__ << "." << __clang_minor__ << "\",\n";
+#elif defined(__GNUC__)
+    out << "  \"compiler\": \"gcc " << __GNUC__ << "." << __GNUC_MINOR__ << "\",\n";
+#elif defined(_MSC_VER)
+    out << "  \"compiler\": \"msvc " << _MSC_VER << "\",\n";
+#endif
+    out << "  \"avx2\": " << (BitFlood::useAvx2() ? "true" : "false") << ",\n";
+    out << "  \"round_seconds\": " << roundSeconds << ",\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        out << "    {\"id\": \"" << r.id << "\", \"name\": \"" << r.name << "\", \"shape\": \"" << r.shape << "\"";
+        if (!r.variant.empty()) out << ", \"variant\": \"" << r.variant << "\"";
+        out << ", \"width\": " << r.width << ", \"height\": " << r.height;
+        if (r.length) out << ", \"length\": " << r.length;
+        out << fixed << setprecision(3) << ", \"ops\": " << r.ops << ", \"ns_per_op\": " << r.ns
+            << ", \"min_ns_per_op\": " << r.minNs << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        out.unsetf(ios::fixed);
+    }
+    out << "  ]\n}\n";
+}
+
+// id -> ns_per_op from a file written by writeJson(). Not a general
+// JSON reader: it relies on each result sitting on its own line.
+static bool readJson(const char* path, map<string, double>& out) {
+    ifstream in(path);
+    if (!in) return false;
+    string line;
+    while (getline(in, line)) {
+        size_t id = line.find("\"id\": \"");
+        size_t ns = line.find("\"ns_per_op\": ");
+        if (id == string::npos || ns == string::npos) continue;
+        id += 7;
+        out[line.substr(id, line.find('"', id) - id)] = atof(line.c_str() + ns + 13);
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    bool quick = false;
+    const char* outPath = NULL;
+    const char* comparePath = NULL;
+    double threshold = 10;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--quick") quick = true;
+        else if (arg == "--filter" && hasValue) filter = argv[++i];
+        else if (arg == "--out" && hasValue) outPath = argv[++i];
+        else if (arg == "--compare" && hasValue) comparePath = argv[++i];
+        else if (arg == "--threshold" && hasValue) threshold = atof(argv[++i]);
+        else {
+            cerr << "usage: " << argv[0] << " [--quick] [--filter TEXT] [--out FILE]"
+                 << " [--compare OLD.json [--threshold PCT]]\n";
+            return 1;
+        }
+    }
+    if (quick) roundSeconds = 0.002;
+
+    vector<pair<int, int>> sizes = {{STANDARD_MAP_WIDTH, STANDARD_MAP_HEIGHT}};
+    if (!quick) { sizes.push_back({100, 50}); sizes.push_back({200, 100}); }
+    vector<int> lengths = {4, 64};
+    if (!quick) lengths.push_back(1024);
+
+    for (auto& s : sizes) {
+        int w = s.first, h = s.second & ~1; // The cycle needs an even height
+        for (int length : lengths)
+            if (length < w * h / 2) snakeBenches(w, h, length);
+    }
+    for (auto& s : sizes) {
+        mapBench<RectShape>("rect", s.first, s.second);
+        mapBench<CircleShape>("circle", s.first, s.second);
+        mapBench<TriangleShape>("triangle", s.first, s.second);
+    }
+    for (auto& s : sizes) {
+        gameBenches(RECTANGLE, "rect", s.first, s.second);
+        gameBenches(CIRCLE, "circle", s.first, s.second);
+        gameBenches(TRIANGLE, "triangle", s.first, s.second);
+    }
+
+    if (outPath) {
+        ofstream out(outPath);
+        writeJson(out);
+        if (!out) { cerr << "cannot write " << outPath << "\n"; return 1; }
+    } else {
+        writeJson(cout);
+    }
+
+    if (!comparePath) return 0;
+    map<string, double> old;
+    if (!readJson(comparePath, old)) { cerr << "cannot read " << comparePath << "\n"; return 1; }
+    int slower = 0;
+    for (const Result& r : results) {
+        auto it = old.find(r.id);
+        if (it == old.end() || it->second <= 0) continue;
+        double change = (r.ns / it->second - 1) * 100;
+        if (change > threshold) {
+            cerr << "slower: " << r.id << " " << it->second << " -> " << r.ns << " ns (+" << change << "%)\n";
+            slower++;
+        }
+    }
+    cerr << slower << " of " << results.size() << " results more than " << threshold << "% slower than "
+         << comparePath << "\n";
+    return slower ? 2 : 0;
+}
@@ -0,0 +1,125 @@
+// ==========================================
+//    BENCHMARK: LEADERBOARD
+// ==========================================
+// Fills a fresh leaderboard with N entries (1M by default) of random
+// players, categories and scores, then times:
+//   insert     - add() per entry (log append + index update)
+//   reopen     - opening with a current index (no log records read)
+//   rebuild    - opening after the index is deleted (whole log read)
+//   torn tail  - opening after half a record was appended, as a crash
+//                mid-append leaves it (the torn bytes are cut off)
+//   top-10     - top() per query
+//   percentile - standing() per query
+// and checks every top list and standing against a plain sort of the
+// same scores. The files are <base>.log / <base>.idx and are removed.
+//
+//   bench_leaderboard [--entries N] [--base PATH]
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include "../leaderboard.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static double micros(Clock::time_point since) {
+    return chrono::duration<double, micro>(Clock::now() - since).count();
+}
+
+struct Entry {
+    int cat, score;
+};
+
+static GameMode modeOf(int cat) { return (GameMode)(1 + cat / 9); }
+static MapType mapOf(int cat) { return (MapType)(1 + cat / 3 % 3); }
+static int difficultyOf(int cat) { return 1 + cat % 3; }
+
+int main(int argc, char** argv) {
+    long long entries = 1000000;
+    string base = "bench_leaderboard";
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--entries") && i + 1 < argc) entries = atoll(argv[++i]);
+        else if (!strcmp(argv[i], "--base") && i + 1 < argc) base = argv[++i];
+        else {
+            cerr << "usage: " << argv[0] << " [--entries N] [--base PATH]\n";
+            return 1;
+        }
+    }
+    string logPath = base + ".log", indexPath = base + ".idx";
+    remove(logPath.c_str());
+    remove(indexPath.c_str());
+
+    SeededRandom rng(7);
+    vector<Entry> all;
+    all.reserve(entries);
+    bool ok = true;
+    {
+        Leaderboard board(base);
+        if (!board.isOpen()) { cerr << "cannot open " << base << "\n"; return 1; }
+        auto t0 = Clock::now();
+        for (long long i = 0; i < entries; i++) {
+            // Mostly low scores with a long tail, like real games
+            int cat = rng.next(Leaderboard::CATEGORIES);
+            int score = 10 * (rng.next(40) + (rng.next(8) == 0 ? rng.next(1200) : 0));
+            string name = "player" + to_string(rng.next(100000));
+            ok = board.add(name, modeOf(cat), mapOf(cat), difficultyOf(cat), score, i) && ok;
+            all.push_back({cat, score});
+        }
+        cout << "insert:     " << fixed << setprecision(3) << micros(t0) / entries << " us/entry ("
+             << entries << " entries)\n";
+    }
+
+    auto t0 = Clock::now();
+    { Leaderboard board(base); cout << "reopen:     " << micros(t0) / 1e3 << " ms, " << board.getReplayed() << " log records read\n"; }
+    remove(indexPath.c_str());
+    t0 = Clock::now();
+    { Leaderboard board(base); cout << "rebuild:    " << micros(t0) / 1e3 << " ms, " << board.getReplayed() << " log records read\n"; }
+
+    // Half a record at the end, as a crash mid-append leaves it
+    if (FILE* f = fopen(logPath.c_str(), "ab")) { fwrite("\x03\x05\0\0\x10\0\0\0", 1, 8, f); fclose(f); }
+    t0 = Clock::now();
+    Leaderboard board(base);
+    cout << "torn tail:  " << micros(t0) / 1e3 << " ms, " << board.getReplayed() << " log records read, "
+         << (board.isOpen() ? "open" : "NOT OPEN") << "\n";
+    ok = ok && board.isOpen();
+
+    // Reference: every category's scores sorted high to low
+    vector<vector<int>> sorted(Leaderboard::CATEGORIES);
+    for (const Entry& e : all) sorted[e.cat].push_back(e.score);
+    for (auto& v : sorted) sort(v.rbegin(), v.rend());
+
+    const int QUERIES = 100000;
+    t0 = Clock::now();
+    long long checksum = 0;
+    for (int q = 0; q < QUERIES; q++) {
+        int cat = q % Leaderboard::CATEGORIES;
+        for (const LeaderboardEntry& e : board.top(modeOf(cat), mapOf(cat), difficultyOf(cat), 10)) checksum += e.score;
+    }
+    cout << "top-10:     " << micros(t0) * 1e3 / QUERIES << " ns/query\n";
+    t0 = Clock::now();
+    for (int q = 0; q < QUERIES; q++) {
+        int cat = q % Leaderboard::CATEGORIES;
+        checksum += board.standing(modeOf(cat), mapOf(cat), difficultyOf(cat), 10 * (q % 1300)).rank;
+    }
+    cout << "percentile: " << micros(t0) * 1e3 / QUERIES << " ns/query (checksum " << checksum << ")\n";
+
+    for (int cat = 0; cat < Leaderboard::CATEGORIES && ok; cat++) {
+        const vector<int>& v = sorted[cat];
+        vector<LeaderboardEntry> top = board.top(modeOf(cat), mapOf(cat), difficultyOf(cat), Leaderboard::TOP_KEEP);
+        for (size_t i = 0; i < top.size() && ok; i++) ok = top[i].score == v[i];
+        for (int score = 0; score <= 12500 && ok; score += 250) {
+            Standing s = board.standing(modeOf(cat), mapOf(cat), difficultyOf(cat), score);
+            long long higher = lower_bound(v.begin(), v.end(), score, greater<int>()) - v.begin();
+            ok = s.rank == higher + 1 && s.total == (long long)v.size();
+        }
+    }
+    cout << "check:      " << (ok ? "top lists and standings match a sort" : "MISMATCH") << "\n";
+    remove(logPath.c_str());
+    remove(indexPath.c_str());
+    return ok ? 0 : 1;
+}
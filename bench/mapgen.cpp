@@ -0,0 +1,103 @@
+// ==========================================
+//    BENCHMARK: OBSTACLE GENERATION AT SCALE
+// ==========================================
+// Fills square rectangular maps from 256x256 up to 4096x4096 with
+// obstacles on 5% to 30% of the playable cells:
+//   gen      - ObstacleGenerator: clusters and walls that keep the open
+//              area in one piece (what Game uses)
+//   scatter  - the original scheme: that many random cells, duplicates
+//              and all, with no regard for what they cut off
+//   load     - reading the generated map back from a map file
+// "regions" counts the separate open areas each leaves (union-find over
+// row runs); the generator must always leave exactly one.
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdio>
+#include "../mapfile.h"
+
+using namespace std;
+
+static const char* TMP_PATH = "bench_mapgen.tmp.map";
+
+static double msSince(chrono::steady_clock::time_point t0) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
+
+struct Result {
+    long long placed;
+    double genMs, scatterMs, loadMs;
+    int regions, scatterRegions;
+    bool loadOk;
+};
+
+static Result measure(int size, double density) {
+    RectangularMap map(size, size);
+    map.generateMap();
+    int count = (int)(density * map.countValid());
+    Point spawn = {size / 2, size / 2};
+    Result r = {};
+
+    MapData data;
+    data.width = data.height = size;
+    data.valid = map.getMask();
+    data.spawn = spawn;
+    SeededRandom rng(7);
+    ObstacleGenerator gen;
+    auto t0 = chrono::steady_clock::now();
+    gen.reset(data.valid, data.obstacles);
+    r.placed = gen.generate(count, spawn, 5, rng, data.obstacles);
+    r.genMs = msSince(t0);
+    r.regions = gen.regions();
+
+    // The original rejection sampling, over the same mask
+    vector<Point> scattered;
+    SeededRandom rng2(7);
+    t0 = chrono::steady_clock::now();
+    for (int placed = 0, attempts = 0; placed < count && attempts < 8 * count; attempts++) {
+        int x = rng2.next(size), y = rng2.next(size);
+        if (map.isValid(x, y) && (abs(x - spawn.x) > 5 || abs(y - spawn.y) > 5)) {
+            scattered.push_back({x, y});
+            placed++;
+        }
+    }
+    r.scatterMs = msSince(t0);
+    ObstacleGenerator check;
+    check.reset(data.valid, scattered);
+    r.scatterRegions = check.regions();
+
+    saveMapFile(TMP_PATH, data);
+    MapData loaded;
+    string error;
+    long long sealed = -1;
+    t0 = chrono::steady_clock::now();
+    r.loadOk = loadMapFile(TMP_PATH, loaded, error, &sealed);
+    r.loadMs = msSince(t0);
+    r.loadOk = r.loadOk && sealed == 0 && loaded.obstacles.size() == data.obstacles.size();
+    remove(TMP_PATH);
+    return r;
+}
+
+int main() {
+    int sizes[] = {256, 1024, 2048, 4096};
+    double densities[] = {0.05, 0.10, 0.20, 0.30};
+
+    cout << "ms per map\n";
+    cout << setw(11) << "map" << setw(9) << "density" << setw(11) << "obstacles" << setw(10) << "gen"
+         << setw(9) << "regions" << setw(10) << "scatter" << setw(9) << "regions" << setw(10) << "load"
+         << setw(6) << "ok" << "\n";
+    int failures = 0;
+    for (int size : sizes) {
+        for (double d : densities) {
+            Result r = measure(size, d);
+            bool ok = r.regions == 1 && r.loadOk;
+            failures += !ok;
+            cout << setw(5) << size << "x" << setw(5) << left << size << right << fixed << setprecision(2)
+                 << setw(9) << d << setw(11) << r.placed << setw(10) << r.genMs << setw(9) << r.regions
+                 << setw(10) << r.scatterMs << setw(9) << r.scatterRegions << setw(10) << r.loadMs
+                 << setw(6) << (ok ? "yes" : "NO") << "\n";
+        }
+    }
+    return failures ? 2 : 0;
+}
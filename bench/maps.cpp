@@ -0,0 +1,147 @@
+// ==========================================
+//    BENCHMARK: MAP VALIDITY CHECKS
+// ==========================================
+// Plays greedy games on each built-in shape at the standard size and
+// records every head position. Then it replays the map checks one tick
+// makes (the four cells the policy looks at plus the head) through each
+// way of asking "is this cell on the map?":
+//   virtual  - GameMap* with a virtual shape test and bounds checks
+//   nested   - vector<vector<bool>> lookup (the original table)
+//   template - Shape::contains inlined, closed form, no table
+//   table    - the compile-time ShapeMask, one bit test
+//   board    - Board::at, what a tick uses now (walls read as VOID)
+// For scale, "step" is a whole Game::step plus the policy on the same
+// games. All columns are ns per tick; every path must agree with the
+// table on every check.
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <memory>
+#include "../engine.h"
+
+using namespace std;
+
+static const int W = STANDARD_MAP_WIDTH;
+static const int H = STANDARD_MAP_HEIGHT;
+static const int GAMES = 400;
+static const int REPEAT = 20;
+
+struct VirtualMap {
+    virtual ~VirtualMap() {}
+    virtual bool isValid(int x, int y) = 0;
+};
+
+template <class Shape>
+struct VirtualShapeMap : VirtualMap {
+    bool isValid(int x, int y) override {
+        if (x < 0 || x >= W || y < 0 || y >= H) return false;
+        return Shape::contains(x, y, W, H);
+    }
+};
+
+template <class Shape>
+struct InlineCheck {
+    bool operator()(int x, int y) const {
+        return (unsigned)x < (unsigned)W && (unsigned)y < (unsigned)H && Shape::contains(x, y, W, H);
+    }
+};
+
+template <class Shape>
+struct TableCheck {
+    bool operator()(int x, int y) const {
+        typedef ShapeMask<Shape, W, H> Mask;
+        if ((unsigned)x >= (unsigned)W || (unsigned)y >= (unsigned)H) return false;
+        return (StandardMask<Shape>::table.words[y * Mask::STRIDE + (x >> 6)] >> (x & 63)) & 1;
+    }
+};
+
+// Head toward the food without stepping onto a blocked cell
+static Direction greedy(Game& game) {
+    const Point& h = game.getSnake()->getHead();
+    Food* f = game.getFood();
+    Direction cur = game.getSnake()->getDirection();
+    Direction order[] = {f->x < h.x ? LEFT : RIGHT, f->y < h.y ? UP : DOWN, UP, RIGHT, DOWN, LEFT};
+    for (Direction d : order) {
+        if ((cur == LEFT && d == RIGHT) || (cur == RIGHT && d == LEFT) ||
+            (cur == UP && d == DOWN) || (cur == DOWN && d == UP)) continue;
+        int nx = h.x + (d == LEFT ? -1 : d == RIGHT ? 1 : 0);
+        int ny = h.y + (d == UP ? -1 : d == DOWN ? 1 : 0);
+        if (!game.isBlocked(nx, ny)) return d;
+    }
+    return cur == STOP ? UP : cur;
+}
+
+template <class Check>
+static double timeChecks(const vector<Point>& heads, Check check, long long& hits) {
+    auto t0 = chrono::steady_clock::now();
+    long long n = 0;
+    for (int r = 0; r < REPEAT; r++) {
+        for (const Point& p : heads) {
+            n += check(p.x, p.y) + check(p.x + 1, p.y) + check(p.x - 1, p.y) +
+                 check(p.x, p.y + 1) + check(p.x, p.y - 1);
+        }
+    }
+    hits = n;
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count() / (REPEAT * heads.size());
+}
+
+template <class Shape>
+static void measure(MapType type, const char* label) {
+    vector<Point> heads;
+    double stepNs = 0;
+    for (int g = 0; g < GAMES; g++) {
+        SeededRandom rng(g + 1);
+        ManualClock clock;
+        Game game(CLASSIC, type, 2, rng, clock);
+        auto t0 = chrono::steady_clock::now();
+        while (!game.isOver() && game.getTicks() < 20000) {
+            game.step(greedy(game));
+            heads.push_back(game.getSnake()->getHead());
+        }
+        stepNs += chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+    }
+    stepNs /= heads.size();
+
+    // The virtual map is picked at run time, as Game used to pick it
+    unique_ptr<VirtualMap> vmap;
+    if (type == RECTANGLE) vmap.reset(new VirtualShapeMap<RectShape>());
+    else if (type == CIRCLE) vmap.reset(new VirtualShapeMap<CircleShape>());
+    else vmap.reset(new VirtualShapeMap<TriangleShape>());
+    VirtualMap* vm = vmap.get();
+
+    vector<vector<bool>> nested(H, vector<bool>(W, false));
+    for (int y = 0; y < H; y++)
+        for (int x = 0; x < W; x++) nested[y][x] = Shape::contains(x, y, W, H);
+
+    // The board with just the map on it, so it only answers "wall or not"
+    ShapedMap<Shape> map(W, H);
+    map.generateMap();
+    Board board(&map);
+
+    long long want, got[4];
+    double tableNs = timeChecks(heads, TableCheck<Shape>(), want);
+    double virtualNs = timeChecks(heads, [vm](int x, int y) { return vm->isValid(x, y); }, got[0]);
+    double nestedNs = timeChecks(heads, [&nested](int x, int y) {
+        if (x < 0 || x >= W || y < 0 || y >= H) return false;
+        return (bool)nested[y][x];
+    }, got[1]);
+    double inlineNs = timeChecks(heads, InlineCheck<Shape>(), got[2]);
+    double boardNs = timeChecks(heads, [&board](int x, int y) { return board.at(x, y) != CELL_VOID; }, got[3]);
+    bool agree = got[0] == want && got[1] == want && got[2] == want && got[3] == want;
+
+    cout << setw(10) << label << setw(10) << heads.size() << fixed << setprecision(2)
+         << setw(10) << virtualNs << setw(10) << nestedNs << setw(10) << inlineNs
+         << setw(10) << tableNs << setw(10) << boardNs << setw(10) << stepNs
+         << (agree ? "" : "  MISMATCH") << "\n";
+}
+
+int main() {
+    cout << "ns per tick (5 checks), " << W << "x" << H << " maps\n";
+    cout << setw(10) << "map" << setw(10) << "ticks" << setw(10) << "virtual" << setw(10) << "nested"
+         << setw(10) << "template" << setw(10) << "table" << setw(10) << "board" << setw(10) << "step" << "\n";
+    measure<RectShape>(RECTANGLE, "rect");
+    measure<CircleShape>(CIRCLE, "circle");
+    measure<TriangleShape>(TRIANGLE, "triangle");
+    return 0;
+}
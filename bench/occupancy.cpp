@@ -0,0 +1,113 @@
+// ==========================================
+//    BENCHMARK: OCCUPANCY GRID COLLISIONS
+// ==========================================
+// Drives a snake around a Hamiltonian cycle on a large rectangular map
+// while obstacles sit in a separate band, and times one tick (move +
+// wall/self/obstacle check). The "grid" column is the engine's Board
+// lookup; the "scan" column replays the old per-tick scans over the
+// body and the obstacle list for comparison. Grid cost should stay flat
+// as both counts grow; scan cost grows linearly.
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include "../engine.h"
+
+using namespace std;
+
+static const int COLS = 256; // Cycle area: columns 1..COLS
+static const int ROWS = 256; // Cycle area: rows 1..ROWS (must be even)
+static const int BAND = 256; // Obstacle band below the cycle area
+
+// Closed tour of the cycle area: right along row 1, zig-zag down over
+// columns 2..COLS, then back up column 1.
+static vector<Point> buildCycle() {
+    vector<Point> cycle;
+    for (int x = 1; x <= COLS; x++) cycle.push_back({x, 1});
+    for (int y = 2; y <= ROWS; y++) {
+        if (y % 2 == 0) for (int x = COLS; x >= 2; x--) cycle.push_back({x, y});
+        else for (int x = 2; x <= COLS; x++) cycle.push_back({x, y});
+    }
+    for (int y = ROWS; y >= 2; y--) cycle.push_back({1, y});
+    return cycle;
+}
+
+static Direction towards(const Point& from, const Point& to) {
+    if (to.x < from.x) return LEFT;
+    if (to.x > from.x) return RIGHT;
+    if (to.y < from.y) return UP;
+    return DOWN;
+}
+
+struct Result { double gridNs, scanNs; };
+
+static Result measure(const vector<Point>& cycle, int length, int obstacleCount) {
+    RectangularMap map(COLS + 2, ROWS + BAND + 2);
+    map.generateMap();
+    Board board(&map);
+
+    SeededRandom rng(7);
+    vector<Point> obstacles;
+    for (int i = 0; i < obstacleCount; i++) {
+        Point o = {1 + rng.next(COLS), ROWS + 1 + rng.next(BAND)};
+        obstacles.push_back(o);
+        board.set(o.x, o.y, CELL_OBSTACLE);
+    }
+
+    // Head starts at (1,2) hanging down column 1, i.e. on the last three
+    // cells of the tour, so the next step is cycle[0].
+    int n = (int)cycle.size();
+    Snake snake(1, 2, map.countValid(), &board);
+    for (int i = 3; i < length; i++) snake.grow();
+    int pos = n - 1;
+
+    auto advance = [&]() -> Cell {
+        int next = (pos + 1) % n;
+        snake.setDirection(towards(cycle[pos], cycle[next]));
+        pos = next;
+        return snake.move();
+    };
+    for (int i = 0; i < length; i++) advance(); // Warm-up: reach full length
+
+    volatile int deaths = 0;
+    long long ticks = 2000000;
+    auto t0 = chrono::steady_clock::now();
+    for (long long i = 0; i < ticks; i++) {
+        Cell hit = advance();
+        if (hit == CELL_VOID || hit == CELL_BODY || hit == CELL_OBSTACLE) deaths = deaths + 1;
+    }
+    double gridNs = chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count() / ticks;
+
+    // Old engine: walk the body for self hits, the obstacle list for
+    // obstacle hits (the move itself is the same O(1) ring push)
+    long long scanTicks = 200000000LL / (length + obstacleCount);
+    if (scanTicks > ticks) scanTicks = ticks;
+    t0 = chrono::steady_clock::now();
+    for (long long i = 0; i < scanTicks; i++) {
+        advance();
+        BodyView body = snake.getBody();
+        const Point& h = body[0];
+        bool dead = !map.isValid(h.x, h.y);
+        for (int j = 1; j < body.size(); j++) if (body[j] == h) dead = true;
+        for (auto& o : obstacles) if (o == h) dead = true;
+        if (dead) deaths = deaths + 1;
+    }
+    double scanNs = chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count() / scanTicks;
+
+    if (deaths) cerr << "warning: snake died " << deaths << " times\n";
+    return {gridNs, scanNs};
+}
+
+int main() {
+    vector<Point> cycle = buildCycle();
+    int sizes[] = {3, 30, 300, 3000, 30000, 60000};
+
+    cout << setw(8) << "length" << setw(12) << "obstacles"
+         << setw(16) << "grid ns/tick" << setw(16) << "scan ns/tick" << "\n";
+    for (int s : sizes) {
+        Result r = measure(cycle, s, s);
+        cout << setw(8) << s << setw(12) << s << fixed << setprecision(1)
+             << setw(16) << r.gridNs << setw(16) << r.scanNs << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,186 @@
+// ==========================================
+//   BENCHMARK: INCREMENTAL REACHABILITY
+// ==========================================
+// A snake wanders a rectangular map with ~2% obstacles, growing to a
+// length of cells/20 (capped at 5000) so its body keeps cutting the
+// free space into pockets. Every 20 ticks, as after eating, we ask
+// whether a random free cell is reachable from the head:
+//   bfs    - a cell-by-cell BFS with a fresh visited grid per call (the
+//            engine's original Food::isReachable)
+//   bits   - bitboard flood fill (Food::isReachable now), scalar words
+//   avx2   - the same fill with the AVX2 kernels
+//   incr   - the Reachability service, including its upkeep on every
+//            tick in between (amortized into the per-query figure)
+// All answers are cross-checked against the BFS.
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include "../engine.h"
+
+using namespace std;
+
+static const int QUERY_EVERY = 20;
+
+// The original per-call BFS, kept here as the baseline
+static bool bfsReachable(int startX, int startY, int targetX, int targetY, const Board& board) {
+    vector<vector<bool>> visited(board.getHeight(), vector<bool>(board.getWidth(), false));
+    if (board.at(targetX, targetY) != CELL_FREE) return false;
+    queue<Point> q;
+    q.push({startX, startY});
+    visited[startY][startX] = true;
+    int dx[] = {0, 0, 1, -1};
+    int dy[] = {1, -1, 0, 0};
+    while (!q.empty()) {
+        Point curr = q.front(); q.pop();
+        if (curr.x == targetX && curr.y == targetY) return true;
+        for (int i = 0; i < 4; i++) {
+            int nx = curr.x + dx[i], ny = curr.y + dy[i];
+            Cell c = board.at(nx, ny);
+            if ((c == CELL_FREE || c == CELL_FOOD) && !visited[ny][nx]) {
+                visited[ny][nx] = true;
+                q.push({nx, ny});
+            }
+        }
+    }
+    return false;
+}
+
+// Open cells reachable from (x, y), counting up to `limit`. Only used to
+// steer the snake away from dead ends; not part of any timing.
+static int regionSize(Board& board, int x, int y, int limit, vector<uint32_t>& seen, uint32_t& gen, vector<int>& work) {
+    static const int dx[] = {0, 0, 1, -1};
+    static const int dy[] = {1, -1, 0, 0};
+    int w = board.getWidth();
+    gen++;
+    work.clear();
+    work.push_back(y * w + x);
+    seen[y * w + x] = gen;
+    for (size_t head = 0; head < work.size() && (int)work.size() < limit; head++) {
+        int cx = work[head] % w, cy = work[head] / w;
+        for (int k = 0; k < 4; k++) {
+            int nx = cx + dx[k], ny = cy + dy[k];
+            Cell c = board.at(nx, ny);
+            if ((c != CELL_FREE && c != CELL_FOOD) || seen[ny * w + nx] == gen) continue;
+            seen[ny * w + nx] = gen;
+            work.push_back(ny * w + nx);
+        }
+    }
+    return (int)work.size();
+}
+
+struct Result { double bfsUs, bitsUs, avxUs, incrUs; long long queries, bfsQueries, relabels, mismatches; };
+
+static Result measure(int w, int h) {
+    RectangularMap map(w, h);
+    map.generateMap();
+    Board board(&map);
+    SeededRandom rng(11);
+
+    int obstacles = w * h / 50;
+    for (int i = 0; i < obstacles; i++) {
+        Point p = board.randomFree(rng);
+        if (abs(p.x - w / 2) > 5 || abs(p.y - h / 2) > 5) board.set(p.x, p.y, CELL_OBSTACLE);
+    }
+
+    Reachability reach(board);
+    Snake snake(w / 2, h / 2, map.countValid(), &board);
+    int length = min(5000, w * h / 20);
+    for (int i = 3; i < length; i++) snake.grow();
+
+    Food food;
+    Direction dirs[] = {UP, RIGHT, DOWN, LEFT};
+    int safeRoom = min(length, 2000);
+    vector<uint32_t> seen((size_t)w * h, 0);
+    vector<int> work;
+    uint32_t gen = 0;
+    long long ticks = 200000;
+    long long bfsEvery = max(1LL, (long long)w * h / 200000); // Keep BFS runs affordable
+    Result r = {0, 0, 0, 0, 0, 0, 0, 0};
+    double incrNs = 0, bfsNs = 0, bitsNs = 0, avxNs = 0;
+    bool hasAvx2 = BitFlood::useAvx2();
+
+    for (long long t = 0; t < ticks; t++) {
+        // Wander: mostly straight, random turns, and only into space big
+        // enough to hold the body; the biggest pocket if nothing is
+        const Point& head = snake.getHead();
+        Direction pick = STOP;
+        int best = 0;
+        Direction order[4];
+        int r0 = rng.next(4);
+        for (int k = 0; k < 4; k++) order[k] = dirs[(r0 + k) % 4];
+        if (snake.getDirection() != STOP && rng.next(6) != 0) {
+            for (int k = 1; k < 4; k++) if (order[k] == snake.getDirection()) swap(order[0], order[k]);
+        }
+        for (int k = 0; k < 4; k++) {
+            Direction d = order[k];
+            int nx = head.x + (d == LEFT ? -1 : d == RIGHT ? 1 : 0);
+            int ny = head.y + (d == UP ? -1 : d == DOWN ? 1 : 0);
+            Cell c = board.at(nx, ny);
+            if (c != CELL_FREE && c != CELL_FOOD) continue;
+            int room = regionSize(board, nx, ny, safeRoom, seen, gen, work);
+            if (room > best) { best = room; pick = d; }
+            if (room >= safeRoom) break;
+        }
+        if (pick == STOP) break; // Boxed in
+
+        auto t0 = chrono::steady_clock::now();
+        snake.setDirection(pick);
+        snake.move();
+        incrNs += chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+
+        if (t % QUERY_EVERY != 0) continue;
+        Point target = board.randomFree(rng);
+        if (target.x < 0) break;
+        const Point& hd = snake.getHead();
+
+        t0 = chrono::steady_clock::now();
+        bool fast = reach.isReachable(hd, target);
+        incrNs += chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+        r.queries++;
+
+        if (r.queries % bfsEvery == 0) {
+            t0 = chrono::steady_clock::now();
+            bool slow = bfsReachable(hd.x, hd.y, target.x, target.y, board);
+            bfsNs += chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+
+            BitFlood::useAvx2() = false;
+            t0 = chrono::steady_clock::now();
+            bool bits = food.isReachable(hd.x, hd.y, target.x, target.y, board);
+            bitsNs += chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+            BitFlood::useAvx2() = hasAvx2;
+
+            t0 = chrono::steady_clock::now();
+            bool avx = food.isReachable(hd.x, hd.y, target.x, target.y, board);
+            avxNs += chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+
+            r.bfsQueries++;
+            if (slow != fast || slow != bits || slow != avx) r.mismatches++;
+        }
+    }
+
+    // The move itself is timed on the incremental side: it is the work
+    // the service adds to every tick
+    r.incrUs = r.queries ? incrNs / r.queries / 1000.0 : 0;
+    r.bfsUs = r.bfsQueries ? bfsNs / r.bfsQueries / 1000.0 : 0;
+    r.bitsUs = r.bfsQueries ? bitsNs / r.bfsQueries / 1000.0 : 0;
+    r.avxUs = r.bfsQueries ? avxNs / r.bfsQueries / 1000.0 : 0;
+    r.relabels = reach.getRelabels();
+    return r;
+}
+
+int main() {
+    int sizes[][2] = {{50, 25}, {200, 100}, {500, 500}, {1000, 1000}, {2000, 2000}};
+
+    cout << "us per query" << (BitFlood::useAvx2() ? "" : " (no AVX2 on this CPU: avx2 column is scalar)") << "\n";
+    cout << setw(11) << "map" << setw(10) << "queries" << setw(11) << "bfs" << setw(10) << "bits"
+         << setw(10) << "avx2" << setw(10) << "incr" << setw(10) << "relabels" << setw(12) << "mismatches" << "\n";
+    for (auto& s : sizes) {
+        Result r = measure(s[0], s[1]);
+        cout << setw(5) << s[0] << "x" << setw(5) << left << s[1] << right
+             << setw(10) << r.queries << fixed << setprecision(2)
+             << setw(11) << r.bfsUs << setw(10) << r.bitsUs << setw(10) << r.avxUs << setw(10) << r.incrUs
+             << setw(10) << r.relabels << setw(12) << r.mismatches << "\n";
+    }
+    return 0;
+}
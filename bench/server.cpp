@@ -0,0 +1,70 @@
+// ==========================================
+//    BENCHMARK: SESSION SERVER TICK LATENESS
+// ==========================================
+// Runs the SessionServer with 1000 to 32000 greedy bot sessions (all
+// three difficulties, so 30, 60 and 100 ms ticks, on all three maps) for
+// a few seconds each and prints how late ticks started: percentiles of
+// tick start minus deadline, the share that was a full period or more
+// late, and the ticks dropped by sessions that fell too far behind.
+// "busy" is the share of the run spent in ticking passes; as it nears
+// 100% the server saturates and lateness climbs.
+//
+//   bench_server [--quick] [--seconds S] [--threads N]
+//
+// --quick stops at 4000 sessions and runs one second each.
+
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include <thread>
+#include "../server.h"
+
+using namespace std;
+
+int main(int argc, char** argv) {
+    double seconds = 3;
+    int threads = (int)thread::hardware_concurrency();
+    bool quick = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--quick")) quick = true;
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) threads = atoi(argv[++i]);
+        else {
+            cerr << "usage: " << argv[0] << " [--quick] [--seconds S] [--threads N]\n";
+            return 1;
+        }
+    }
+    if (quick) seconds = 1;
+    ControllerFactory greedy = [](Game&) { return unique_ptr<Controller>(new PolicyController(greedyTurn)); };
+
+    cout << seconds << " s per row, lateness in ms\n";
+    cout << setw(9) << "sessions" << setw(9) << "threads" << setw(11) << "ticks/s" << setw(7) << "busy"
+         << setw(9) << "p50" << setw(9) << "p90" << setw(9) << "p99" << setw(9) << "p99.9" << setw(9) << "max"
+         << setw(10) << "overrun" << setw(9) << "dropped" << "\n";
+    for (int sessions : {1000, 2000, 4000, 8000, 16000, 32000}) {
+        if (quick && sessions > 4000) break;
+        ServerConfig cfg;
+        cfg.threads = threads;
+        cfg.maxSessions = sessions;
+        SessionServer server(cfg, greedy);
+        for (int s = 0; s < sessions; s++) {
+            GameSpec spec;
+            spec.seed = 1 + s;
+            spec.map = (MapType)(1 + s % 3);
+            spec.difficulty = 1 + s / 3 % 3;
+            spec.mode = CLASSIC;
+            server.addBot(spec);
+        }
+        server.run(seconds);
+
+        const ServerStats& st = server.getStats();
+        const Histogram& late = st.lateNanos;
+        cout << setw(9) << sessions << setw(9) << server.getThreads() << setw(11)
+             << (long long)(st.ticks / st.seconds) << setw(6) << fixed << setprecision(0)
+             << 100 * st.busySeconds / st.seconds << "%" << setprecision(3);
+        for (double p : {0.50, 0.90, 0.99, 0.999}) cout << setw(9) << late.percentile(p) / 1e6;
+        cout << setw(9) << late.max() / 1e6 << setw(9) << setprecision(2)
+             << (st.ticks ? 100.0 * st.overruns / st.ticks : 0) << "%" << setw(9) << st.dropped << "\n";
+    }
+    return 0;
+}
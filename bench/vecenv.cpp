@@ -0,0 +1,137 @@
+// ==========================================
+//    BENCHMARK: VECTORIZED ENVIRONMENT STEPS
+// ==========================================
+// Steps K envs (64 to 4096) in lockstep on 1, 2, 4, ... threads up to
+// the core count with a random policy (a random turn one tick in four),
+// and prints env-steps per second and the episodes finished. Then it
+// checks the incremental observations against a full redraw, and
+// counts the allocations made by a run of single-threaded steps after
+// warm-up (this thread does all the work then). --shm NAME puts the
+// observations in a POSIX shared memory segment instead of the heap.
+//
+//   bench_vecenv [--quick] [--threads N] [--shm NAME]
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <memory>
+#include "../vecenv.h"
+#include "../metrics.h"
+
+using namespace std;
+
+SNAKE_DEFINE_ALLOCATION_COUNTER()
+
+static const int WARMUP = 200;
+static const int STEPS = 2000;
+
+// Cheap per-bench action source: a random turn one tick in four
+struct RandomActions {
+    uint32_t state = 12345;
+    void fill(vector<uint8_t>& actions) {
+        for (uint8_t& a : actions) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            a = (state & 3) ? (uint8_t)STOP : (uint8_t)(LEFT + (state >> 2) % 4);
+        }
+    }
+};
+
+struct Buffer {
+    vector<uint8_t> heap;
+    unique_ptr<SharedObservations> shm;
+    uint8_t* data = NULL;
+};
+
+static bool allocate(Buffer& b, size_t bytes, const char* shmName) {
+    if (shmName) {
+        b.shm.reset(new SharedObservations(shmName, bytes, true));
+        if (!b.shm->isOpen()) return false;
+        b.data = b.shm->data();
+    } else {
+        b.heap.assign(bytes, 0);
+        b.data = b.heap.data();
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int maxThreads = (int)thread::hardware_concurrency();
+    bool quick = false;
+    const char* shmName = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--quick")) quick = true;
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) maxThreads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--shm") && i + 1 < argc) shmName = argv[++i];
+        else {
+            cerr << "usage: " << argv[0] << " [--quick] [--threads N] [--shm NAME]\n";
+            return 1;
+        }
+    }
+    if (maxThreads < 1) maxThreads = 1;
+    vector<int> threadCounts;
+    for (int t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    EnvConfig cfg;
+    RandomActions policy;
+    cout << "map " << cfg.width << "x" << cfg.height << ", " << VecEnv::PLANE_COUNT << " planes, "
+         << (shmName ? "shared memory" : "heap") << " observations\n";
+    cout << setw(6) << "envs" << setw(9) << "threads" << setw(14) << "steps/sec" << setw(11) << "episodes" << "\n";
+    for (int count : {64, 256, 1024, 4096}) {
+        if (quick && count > 1024) break;
+        for (int threads : threadCounts) {
+            Buffer obs;
+            if (!allocate(obs, VecEnv::observationBytes(count, cfg), shmName)) {
+                cerr << "cannot create shared memory " << shmName << "\n";
+                return 1;
+            }
+            VecEnv env(count, cfg, obs.data, threads);
+            vector<uint32_t> seeds(count);
+            for (int k = 0; k < count; k++) seeds[k] = 1 + k;
+            env.reset(seeds.data());
+
+            vector<uint8_t> actions(count), dones(count);
+            vector<float> rewards(count);
+            int steps = quick ? STEPS / 4 : STEPS;
+            for (int s = 0; s < WARMUP; s++) { policy.fill(actions); env.step(actions.data(), rewards.data(), dones.data()); }
+            long long episodes = 0;
+            auto t0 = chrono::steady_clock::now();
+            for (int s = 0; s < steps; s++) {
+                policy.fill(actions);
+                env.step(actions.data(), rewards.data(), dones.data());
+                for (uint8_t d : dones) episodes += d != 0;
+            }
+            double secs = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+            cout << setw(6) << count << setw(9) << env.getThreads() << setw(14) << (long long)(count * (double)steps / secs)
+                 << setw(11) << episodes << "\n";
+        }
+    }
+
+    // Incremental observations must match a full redraw; then count what
+    // warmed-up single-threaded steps still allocate
+    const int count = 256;
+    Buffer obs;
+    if (!allocate(obs, VecEnv::observationBytes(count, cfg), shmName)) return 1;
+    VecEnv env(count, cfg, obs.data, 1);
+    vector<uint32_t> seeds(count);
+    for (int k = 0; k < count; k++) seeds[k] = 1000 + k;
+    env.reset(seeds.data());
+    vector<uint8_t> actions(count), dones(count);
+    vector<float> rewards(count);
+    for (int s = 0; s < 5 * WARMUP; s++) { policy.fill(actions); env.step(actions.data(), rewards.data(), dones.data()); }
+    long long before = threadAllocations;
+    for (int s = 0; s < STEPS; s++) { policy.fill(actions); env.step(actions.data(), rewards.data(), dones.data()); }
+    long long allocations = threadAllocations - before;
+
+    vector<uint8_t> incremental(obs.data, obs.data + VecEnv::observationBytes(count, cfg));
+    env.refresh();
+    bool same = memcmp(incremental.data(), obs.data, incremental.size()) == 0;
+    cout << "observations: " << (same ? "match" : "DIFFER FROM") << " a full redraw\n";
+    cout << "allocations:  " << allocations << " in " << (long long)count * STEPS << " env-steps\n";
+    return same ? 0 : 1;
+}
@@ -0,0 +1,255 @@
+#pragma once
+
+// ==========================================
+//    [DSA CONCEPT: BITBOARD] PACKED GRIDS
+// ==========================================
+// One bit per cell, rows packed into 64-bit words. Row strides are
+// rounded up to whole 256-bit blocks so the AVX2 kernels never need a
+// tail loop. A flood fill over a BitGrid works on whole words: a row is
+// saturated sideways with shift/and/or (Kogge-Stone fill, carries passed
+// between words), then rows feed their neighbours above and below, and
+// sweeps repeat until nothing new is added. That is a few thousand word
+// operations where a BFS would do millions of queue pushes.
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SNAKE_AVX2_DISPATCH 1
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+inline int popcount64(uint64_t w) { return (int)__popcnt64(w); }
+inline int lowestBit64(uint64_t w) { unsigned long i; _BitScanForward64(&i, w); return (int)i; }
+inline int highestBit64(uint64_t w) { unsigned long i; _BitScanReverse64(&i, w); return (int)i; }
+#else
+inline int popcount64(uint64_t w) { return __builtin_popcountll(w); }
+inline int lowestBit64(uint64_t w) { return __builtin_ctzll(w); }
+inline int highestBit64(uint64_t w) { return 63 - __builtin_clzll(w); }
+#endif
+
+class BitGrid {
+private:
+    int width, height;
+    int stride; // Words per row, a multiple of 4
+    std::vector<uint64_t> bits;
+
+public:
+    BitGrid() : width(0), height(0), stride(0) {}
+    BitGrid(int w, int h) { resize(w, h); }
+
+    void resize(int w, int h) {
+        width = w;
+        height = h;
+        stride = (((w + 63) / 64) + 3) & ~3;
+        bits.assign((size_t)stride * h, 0);
+    }
+
+    bool test(int x, int y) const {
+        if ((unsigned)x >= (unsigned)width || (unsigned)y >= (unsigned)height) return false;
+        return (bits[(size_t)y * stride + (x >> 6)] >> (x & 63)) & 1;
+    }
+    void set(int x, int y) { bits[(size_t)y * stride + (x >> 6)] |= 1ULL << (x & 63); }
+    void reset(int x, int y) { bits[(size_t)y * stride + (x >> 6)] &= ~(1ULL << (x & 63)); }
+
+    void clear() { std::fill(bits.begin(), bits.end(), 0); }
+
+    long long count() const {
+        long long n = 0;
+        for (uint64_t w : bits) n += popcount64(w);
+        return n;
+    }
+
+    uint64_t* row(int y) { return &bits[(size_t)y * stride]; }
+    const uint64_t* row(int y) const { return &bits[(size_t)y * stride]; }
+    uint64_t* data() { return bits.data(); }
+    const uint64_t* data() const { return bits.data(); }
+    size_t words() const { return bits.size(); }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getStride() const { return stride; }
+};
+
+// Flood fill over packed grids. Keeps its scratch grids between calls,
+// so one instance per owner means fills never allocate after the first.
+class BitFlood {
+private:
+    BitGrid open;   // Cells the fill may enter
+    BitGrid region; // Cells reached so far
+    long long sweeps;
+
+    // --- Kogge-Stone occluded fills inside one word ---
+    static uint64_t fillUp(uint64_t gen, uint64_t pro) {
+        gen |= pro & (gen << 1);  pro &= pro << 1;
+        gen |= pro & (gen << 2);  pro &= pro << 2;
+        gen |= pro & (gen << 4);  pro &= pro << 4;
+        gen |= pro & (gen << 8);  pro &= pro << 8;
+        gen |= pro & (gen << 16); pro &= pro << 16;
+        gen |= pro & (gen << 32);
+        return gen;
+    }
+
+    static uint64_t fillDown(uint64_t gen, uint64_t pro) {
+        gen |= pro & (gen >> 1);  pro &= pro >> 1;
+        gen |= pro & (gen >> 2);  pro &= pro >> 2;
+        gen |= pro & (gen >> 4);  pro &= pro >> 4;
+        gen |= pro & (gen >> 8);  pro &= pro >> 8;
+        gen |= pro & (gen >> 16); pro &= pro >> 16;
+        gen |= pro & (gen >> 32);
+        return gen;
+    }
+
+    // Saturate a row sideways: one pass toward high bits, one back
+    static void fillRow(uint64_t* row, const uint64_t* mask, int stride) {
+        uint64_t carry = 0;
+        for (int w = 0; w < stride; w++) {
+            uint64_t g = fillUp(row[w] | (carry & mask[w]), mask[w]);
+            row[w] = g;
+            carry = g >> 63;
+        }
+        carry = 0;
+        for (int w = stride - 1; w >= 0; w--) {
+            uint64_t g = fillDown(row[w] | (carry & mask[w]), mask[w]);
+            row[w] = g;
+            carry = (g & 1) << 63;
+        }
+    }
+
+    // dst |= src & mask; true if that added anything
+    static bool mergeRowScalar(uint64_t* dst, const uint64_t* src, const uint64_t* mask, int stride) {
+        uint64_t added = 0;
+        for (int w = 0; w < stride; w++) {
+            uint64_t n = src[w] & mask[w] & ~dst[w];
+            dst[w] |= n;
+            added |= n;
+        }
+        return added != 0;
+    }
+
+    // out = a & ~b & ~c
+    static void andNot2Scalar(uint64_t* out, const uint64_t* a, const uint64_t* b, const uint64_t* c, size_t n) {
+        for (size_t i = 0; i < n; i++) out[i] = a[i] & ~b[i] & ~c[i];
+    }
+
+#ifdef SNAKE_AVX2_DISPATCH
+    __attribute__((target("avx2")))
+    static bool mergeRowAvx2(uint64_t* dst, const uint64_t* src, const uint64_t* mask, int stride) {
+        __m256i added = _mm256_setzero_si256();
+        for (int w = 0; w < stride; w += 4) {
+            __m256i d = _mm256_loadu_si256((const __m256i*)(dst + w));
+            __m256i s = _mm256_loadu_si256((const __m256i*)(src + w));
+            __m256i m = _mm256_loadu_si256((const __m256i*)(mask + w));
+            __m256i n = _mm256_andnot_si256(d, _mm256_and_si256(s, m));
+            _mm256_storeu_si256((__m256i*)(dst + w), _mm256_or_si256(d, n));
+            added = _mm256_or_si256(added, n);
+        }
+        return !_mm256_testz_si256(added, added);
+    }
+
+    __attribute__((target("avx2")))
+    static void andNot2Avx2(uint64_t* out, const uint64_t* a, const uint64_t* b, const uint64_t* c, size_t n) {
+        for (size_t i = 0; i < n; i += 4) {
+            __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+            __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+            __m256i vc = _mm256_loadu_si256((const __m256i*)(c + i));
+            __m256i r = _mm256_andnot_si256(_mm256_or_si256(vb, vc), va);
+            _mm256_storeu_si256((__m256i*)(out + i), r);
+        }
+    }
+#endif
+
+    static bool mergeRow(uint64_t* dst, const uint64_t* src, const uint64_t* mask, int stride) {
+#ifdef SNAKE_AVX2_DISPATCH
+        if (useAvx2()) return mergeRowAvx2(dst, src, mask, stride);
+#endif
+        return mergeRowScalar(dst, src, mask, stride);
+    }
+
+public:
+    BitFlood() : sweeps(0) {}
+
+    // Runtime switch for the AVX2 kernels; on by default when the CPU
+    // has them. Benchmarks flip it to compare against the scalar path.
+    static bool& useAvx2() {
+#ifdef SNAKE_AVX2_DISPATCH
+        static bool on = __builtin_cpu_supports("avx2");
+#else
+        static bool on = false;
+#endif
+        return on;
+    }
+
+    // Size the scratch grids ahead of the first fill, which would
+    // otherwise do it
+    void resize(int w, int h) {
+        open.resize(w, h);
+        region.resize(w, h);
+    }
+
+    // open = a & ~b & ~c, sized like `a` (e.g. map & ~obstacles & ~body)
+    void composeOpen(const BitGrid& a, const BitGrid& b, const BitGrid& c) {
+        if (open.getWidth() != a.getWidth() || open.getHeight() != a.getHeight())
+            open.resize(a.getWidth(), a.getHeight());
+#ifdef SNAKE_AVX2_DISPATCH
+        if (useAvx2()) { andNot2Avx2(open.data(), a.data(), b.data(), c.data(), a.words()); return; }
+#endif
+        andNot2Scalar(open.data(), a.data(), b.data(), c.data(), a.words());
+    }
+
+    BitGrid& getOpen() { return open; }
+    const BitGrid& getRegion() const { return region; }
+    long long getSweeps() const { return sweeps; }
+
+    // Fill the open cells 4-connected to any of the seeds (anything with
+    // .x/.y). Seeds that are not open are ignored. With a target, stops as
+    // soon as it is reached and returns 1/0; otherwise returns the
+    // region's cell count.
+    template <class P>
+    long long fill(const P* seeds, int n, const P* target = NULL) {
+        int h = open.getHeight(), stride = open.getStride();
+        if (region.getWidth() != open.getWidth() || region.getHeight() != h)
+            region.resize(open.getWidth(), h);
+        else
+            region.clear();
+
+        int lo = h, hi = -1; // Rows that may hold region bits
+        for (int i = 0; i < n; i++) {
+            if (!open.test(seeds[i].x, seeds[i].y)) continue;
+            region.set(seeds[i].x, seeds[i].y);
+            lo = std::min(lo, seeds[i].y);
+            hi = std::max(hi, seeds[i].y);
+        }
+        if (hi < 0) return 0;
+        for (int y = lo; y <= hi; y++) fillRow(region.row(y), open.row(y), stride);
+
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            sweeps++;
+            if (target && region.test(target->x, target->y)) return 1;
+            // Downward: each row picks up what the row above reached
+            for (int y = lo + 1; y < h && y <= hi + 1; y++) {
+                if (mergeRow(region.row(y), region.row(y - 1), open.row(y), stride)) {
+                    fillRow(region.row(y), open.row(y), stride);
+                    hi = std::max(hi, y);
+                    changed = true;
+                }
+            }
+            // Upward
+            for (int y = hi - 1; y >= 0 && y >= lo - 1; y--) {
+                if (mergeRow(region.row(y), region.row(y + 1), open.row(y), stride)) {
+                    fillRow(region.row(y), open.row(y), stride);
+                    lo = std::min(lo, y);
+                    changed = true;
+                }
+            }
+        }
+        if (target) return region.test(target->x, target->y) ? 1 : 0;
+        return region.count();
+    }
+};
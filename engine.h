@@ -0,0 +1,1414 @@
+#pragma once
+
+// ==========================================
+//     HEADLESS SNAKE ENGINE (NO CONSOLE)
+// ==========================================
+// Everything needed to simulate a game lives here: maps, snake, food,
+// obstacles, scoring and the TIME_ATTACK timer. Nothing in this header
+// touches <conio.h> or <windows.h>, so it builds on any platform and a
+// tick can run without drawing or sleeping. Frontends drive it through
+// Game::step() and read the state back for rendering.
+
+#include <vector>
+#include <string>
+#include <queue>
+#include <cmath>
+#include <ctime>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include "bitboard.h"
+#include "metrics.h"
+
+// ==========================================
+//        DATA STRUCTURES & UTILS
+// ==========================================
+
+struct Point {
+    int x, y;
+    bool operator==(const Point& other) const { return x == other.x && y == other.y; }
+};
+
+enum Direction { STOP = 0, LEFT, RIGHT, UP, DOWN };
+enum GameMode { CLASSIC = 1, TIME_ATTACK = 2 };
+enum MapType { RECTANGLE = 1, CIRCLE = 2, TRIANGLE = 3, CUSTOM = 4 }; // CUSTOM: loaded from a map file
+enum DeathCause { ALIVE = 0, HIT_WALL, HIT_SELF, HIT_OBSTACLE, TIME_OUT, QUIT, WON };
+
+// ==========================================
+//    INJECTED SOURCES: RANDOMNESS & TIME
+// ==========================================
+// The engine never calls rand() or clock() itself. Drivers plug in a
+// seeded generator and a clock they advance by one tick period per
+// step (the console's tick scheduler keeps those steps on wall-clock
+// time), so the TIME_ATTACK timer runs on game time and runs are
+// reproducible.
+
+class RandomSource {
+public:
+    virtual ~RandomSource() {}
+    virtual int next(int bound) = 0; // Value in [0, bound)
+};
+
+// The generator state: four words, all saved with the game
+struct RandomState {
+    uint32_t s[4];
+    bool operator==(const RandomState& o) const {
+        return s[0] == o.s[0] && s[1] == o.s[1] && s[2] == o.s[2] && s[3] == o.s[3];
+    }
+    bool operator!=(const RandomState& o) const { return !(*this == o); }
+};
+
+// xoshiro128**, one instance per game. The 32-bit seed is spread over
+// the 128-bit state by SplitMix64, so neighbouring seeds (game g of a
+// batch plays seed S+g) start unrelated streams. Bounded draws use
+// Lemire's multiply-and-reject, so every value in [0, bound) is equally
+// likely; `% bound` favours the low values.
+class SeededRandom final : public RandomSource {
+private:
+    RandomState st;
+
+    static uint32_t rotl(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+
+public:
+    explicit SeededRandom(uint32_t seed) {
+        uint64_t z = seed;
+        for (int i = 0; i < 4; i += 2) {
+            uint64_t v = (z += 0x9E3779B97F4A7C15ULL);
+            v = (v ^ (v >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            v = (v ^ (v >> 27)) * 0x94D049BB133111EBULL;
+            v ^= v >> 31;
+            st.s[i] = (uint32_t)v;
+            st.s[i + 1] = (uint32_t)(v >> 32);
+        }
+    }
+
+    uint32_t nextU32() {
+        uint32_t* s = st.s;
+        uint32_t result = rotl(s[1] * 5, 7) * 9;
+        uint32_t t = s[1] << 9;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 11);
+        return result;
+    }
+
+    int next(int bound) override {
+        uint32_t range = (uint32_t)bound;
+        uint64_t m = (uint64_t)nextU32() * range;
+        if ((uint32_t)m < range) {
+            uint32_t threshold = (0u - range) % range; // 2^32 mod range
+            while ((uint32_t)m < threshold) m = (uint64_t)nextU32() * range;
+        }
+        return (int)(m >> 32);
+    }
+
+    // Skip 2^64 draws: streams a jump apart never overlap in practice
+    void jump() {
+        static const uint32_t JUMP[] = {0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b};
+        RandomState acc = {{0, 0, 0, 0}};
+        for (uint32_t word : JUMP) {
+            for (int b = 0; b < 32; b++) {
+                if (word & (1u << b))
+                    for (int i = 0; i < 4; i++) acc.s[i] ^= st.s[i];
+                nextU32();
+            }
+        }
+        st = acc;
+    }
+
+    // A generator for an independent stream: this one's current stream,
+    // while this one jumps ahead to the next
+    SeededRandom split() {
+        SeededRandom child = *this;
+        jump();
+        return child;
+    }
+
+    // Replays save and restore the generator along with the game
+    const RandomState& getState() const { return st; }
+    void setState(const RandomState& s) { st = s; }
+};
+
+class GameClock {
+public:
+    virtual ~GameClock() {}
+    virtual double now() = 0; // Seconds
+};
+
+// Simulated time that only moves when the driver advances it
+class ManualClock : public GameClock {
+private:
+    double t = 0.0;
+
+public:
+    double now() override { return t; }
+    void advance(double seconds) { t += seconds; }
+};
+
+// ==========================================
+//    [DSA CONCEPT: LOOKUP TABLE] MAPS
+// ==========================================
+class GameMap {
+protected:
+    int width, height;
+    BitGrid validArea; // The Lookup Table, one bit per cell
+
+public:
+    GameMap(int w, int h) : width(w), height(h) {
+        validArea.resize(width, height);
+    }
+    virtual ~GameMap() {}
+    virtual void generateMap() = 0;
+    virtual std::string getName() = 0;
+
+    // O(1) Access
+    bool isValid(int x, int y) {
+        if (x < 0 || x >= width || y < 0 || y >= height) return false;
+        return validArea.test(x, y);
+    }
+    int getWidth() { return width; }
+    int getHeight() { return height; }
+
+    // Number of playable cells (sizes the snake's body buffer)
+    int countValid() { return (int)validArea.count(); }
+
+    const BitGrid& getMask() { return validArea; }
+};
+
+// The size every built-in game uses; masks for it are built at compile
+// time below
+const int STANDARD_MAP_WIDTH = 50;
+const int STANDARD_MAP_HEIGHT = 25;
+
+// --- Shapes: closed-form membership, usable at compile time ---
+
+struct RectShape {
+    static constexpr bool contains(int x, int y, int w, int h) {
+        return x >= 1 && x < w - 1 && y >= 1 && y < h - 1;
+    }
+    static const char* name() { return "Classic Box"; }
+};
+
+struct CircleShape {
+    static constexpr bool contains(int x, int y, int w, int h) {
+        double a = (w / 2.0) - 2, b = (h / 2.0) - 1;
+        double dx = x - w / 2.0, dy = y - h / 2.0;
+        return (dx * dx) / (a * a) + (dy * dy) / (b * b) <= 1.0;
+    }
+    static const char* name() { return " The Colosseum "; }
+};
+
+struct TriangleShape {
+    static constexpr bool contains(int x, int y, int w, int h) {
+        double x1 = w / 2.0, y1 = 1;     // Top
+        double x2 = 2, y2 = h - 2;       // Bottom Left
+        double x3 = w - 3, y3 = h - 2;   // Bottom Right
+        // Simple slope check for a upward pointing triangle
+        double slopeL = (y2 - y1) / (x2 - x1);
+        double slopeR = (y3 - y1) / (x3 - x1);
+        return x >= (x1 + (y - y1) / slopeL) && x <= (x1 + (y - y1) / slopeR) && y <= y2 && y > 0;
+    }
+    static const char* name() { return "Pyramid of Doom"; }
+};
+
+// A shape's mask in BitGrid layout (rows padded to 4 words), filled in
+// by the compiler, so a standard map costs one copy to generate
+template <class Shape, int W, int H>
+struct ShapeMask {
+    static const int STRIDE = (((W + 63) / 64) + 3) & ~3;
+    uint64_t words[STRIDE * H];
+
+    constexpr ShapeMask() : words() {
+        for (int y = 0; y < H; y++)
+            for (int x = 0; x < W; x++)
+                if (Shape::contains(x, y, W, H)) words[y * STRIDE + x / 64] |= 1ULL << (x % 64);
+    }
+};
+
+template <class Shape>
+struct StandardMask {
+    static constexpr ShapeMask<Shape, STANDARD_MAP_WIDTH, STANDARD_MAP_HEIGHT> table = {};
+};
+
+// One class per shape, picked once per game. Nothing in a tick calls
+// into the map: collisions read the Board, and isValid() above is a
+// plain bit test.
+template <class Shape>
+class ShapedMap : public GameMap {
+public:
+    ShapedMap(int w, int h) : GameMap(w, h) {}
+    void generateMap() override {
+        if (width == STANDARD_MAP_WIDTH && height == STANDARD_MAP_HEIGHT) {
+            const uint64_t* table = StandardMask<Shape>::table.words;
+            std::copy(table, table + validArea.words(), validArea.data());
+            return;
+        }
+        for(int y=0; y<height; y++)
+            for(int x=0; x<width; x++)
+                if (Shape::contains(x, y, width, height)) validArea.set(x, y);
+    }
+    std::string getName() override { return Shape::name(); }
+};
+
+typedef ShapedMap<RectShape> RectangularMap;
+typedef ShapedMap<CircleShape> CircularMap;
+typedef ShapedMap<TriangleShape> TriangularMap;
+
+// A map read from a file (mapfile.h), with its playable cells as drawn
+struct MapData {
+    int width = 0, height = 0;
+    BitGrid valid;                // Playable cells, obstacles included
+    std::vector<Point> obstacles;
+    Point spawn = {-1, -1};       // Head; the body hangs down from it
+};
+
+class LoadedMap : public GameMap {
+private:
+    const BitGrid& mask;
+
+public:
+    explicit LoadedMap(const MapData& data) : GameMap(data.width, data.height), mask(data.valid) {}
+    void generateMap() override { std::copy(mask.data(), mask.data() + mask.words(), validArea.data()); }
+    std::string getName() override { return "Custom Map"; }
+};
+
+// ==========================================
+//    [DSA CONCEPT: GRID] OCCUPANCY BOARD
+// ==========================================
+// One byte per cell saying what is there right now. The snake updates
+// it as the head is pushed and the tail popped, obstacles and food tag
+// their own cells, so every collision or placement question is a single
+// lookup instead of a scan over the body or the obstacle list.
+//
+// [DSA CONCEPT: FENWICK TREE] The FREE cells are also kept as one bit
+// per cell, with a Fenwick tree of per-word counts on top, so drawing a
+// uniformly random free cell (the k-th in cell order) is O(log cells) no
+// matter how full the board is. The pick depends only on what is on the
+// board, not on the order cells were freed, so a board rebuilt from a
+// saved state draws exactly the same food as the original.
+enum Cell : uint8_t { CELL_VOID = 0, CELL_FREE, CELL_OBSTACLE, CELL_BODY, CELL_FOOD };
+
+// Told about every tag change, after the Board has been updated
+class BoardListener {
+public:
+    virtual ~BoardListener() {}
+    virtual void onCellChanged(int index, Cell from, Cell to) = 0;
+};
+
+class Board {
+private:
+    int width, height;
+    std::vector<uint8_t> cells;
+
+    // Cells retagged since the last clearDirty(), each listed once, so a
+    // renderer can repaint just what changed this tick
+    std::vector<int> dirty;
+    std::vector<uint8_t> dirtyFlag;
+
+    std::vector<uint64_t> freeBits; // Bit i set when cell i is FREE
+    std::vector<int> freeTree;      // Fenwick tree of popcounts per word, 1-based
+    int freeTotal;
+    int freeStep;                   // Highest power of two <= word count
+
+    BoardListener* listener;
+
+    // Packed copies for word-parallel flood fills
+    BitGrid mapMask, obstacleMask, bodyMask;
+    BitFlood flood;
+
+    // Seed a fill from `from` and its 4 neighbours (the head is body, so
+    // its neighbours are what actually starts the walk)
+    long long fillAround(const Point& from, const Point* target) {
+        SNAKE_PHASE(PHASE_BFS);
+        Point seeds[5] = {from, {from.x + 1, from.y}, {from.x - 1, from.y},
+                          {from.x, from.y + 1}, {from.x, from.y - 1}};
+        flood.composeOpen(mapMask, obstacleMask, bodyMask);
+        long long n = flood.fill(seeds, 5, target);
+        SNAKE_COUNT(COUNT_BFS_NODES, flood.getRegion().count());
+        return n;
+    }
+
+    void addFree(int i) {
+        freeBits[i >> 6] |= 1ULL << (i & 63);
+        for (int w = (i >> 6) + 1; w < (int)freeTree.size(); w += w & -w) freeTree[w]++;
+        freeTotal++;
+    }
+
+    void removeFree(int i) {
+        freeBits[i >> 6] &= ~(1ULL << (i & 63));
+        for (int w = (i >> 6) + 1; w < (int)freeTree.size(); w += w & -w) freeTree[w]--;
+        freeTotal--;
+    }
+
+public:
+    // Starts as the map shape: playable cells FREE, the rest VOID
+    explicit Board(GameMap* map)
+        : width(map->getWidth()), height(map->getHeight()), listener(NULL), mapMask(map->getMask()) {
+        obstacleMask.resize(width, height);
+        bodyMask.resize(width, height);
+        cells.resize((size_t)width * height, CELL_VOID);
+        dirtyFlag.resize(cells.size(), 0);
+        dirty.reserve(cells.size());
+        flood.resize(width, height);
+        freeBits.assign((cells.size() + 63) / 64, 0);
+        freeTree.assign(freeBits.size() + 1, 0);
+        freeTotal = 0;
+        for (freeStep = 1; freeStep * 2 <= (int)freeBits.size(); freeStep *= 2) {}
+        for(int y=0; y<height; y++) {
+            for(int x=0; x<width; x++) {
+                if(map->isValid(x, y)) {
+                    cells[(size_t)y * width + x] = CELL_FREE;
+                    addFree(y * width + x);
+                }
+            }
+        }
+    }
+
+    // Anything outside the grid reads as VOID
+    Cell at(int x, int y) const {
+        if ((unsigned)x >= (unsigned)width || (unsigned)y >= (unsigned)height) return CELL_VOID;
+        return (Cell)cells[(size_t)y * width + x];
+    }
+
+    // Caller guarantees (x, y) is inside the grid
+    void set(int x, int y, Cell c) {
+        int i = y * width + x;
+        Cell old = (Cell)cells[i];
+        if (old == CELL_FREE && c != CELL_FREE) removeFree(i);
+        else if (old != CELL_FREE && c == CELL_FREE) addFree(i);
+        if (old == CELL_OBSTACLE) obstacleMask.reset(x, y);
+        else if (old == CELL_BODY) bodyMask.reset(x, y);
+        if (c == CELL_OBSTACLE) obstacleMask.set(x, y);
+        else if (c == CELL_BODY) bodyMask.set(x, y);
+        cells[i] = c;
+        if (!dirtyFlag[i]) { dirtyFlag[i] = 1; dirty.push_back(i); }
+        if (listener && old != c) listener->onCellChanged(i, old, c);
+    }
+
+    // --- Bitboard region queries (walls, obstacles and body block) ---
+
+    // Open cells reachable from `from`
+    long long regionSize(const Point& from) { return fillAround(from, NULL); }
+
+    bool canReach(const Point& from, const Point& target) { return fillAround(from, &target) != 0; }
+
+    // Uniform FREE cell among those reachable from `from`; {-1, -1} if none
+    Point randomFreeInRegion(const Point& from, RandomSource& rng) {
+        long long n = fillAround(from, NULL);
+        const BitGrid& region = flood.getRegion();
+        int stride = region.getStride();
+        // The region may hold food cells too: retry those, then scan
+        for (int tries = 0; n > 0 && tries < 8; tries++) {
+            long long k = rng.next((int)std::min<long long>(n, 0x7fffffff));
+            for (size_t w = 0; w < region.words(); w++) {
+                uint64_t bits = region.data()[w];
+                int c = popcount64(bits);
+                if (k >= c) { k -= c; continue; }
+                while (k-- > 0) bits &= bits - 1;
+                int x = (int)(w % stride) * 64 + lowestBit64(bits), y = (int)(w / stride);
+                if (at(x, y) == CELL_FREE) return {x, y};
+                break;
+            }
+        }
+        for (int y = 0; n > 0 && y < height; y++)
+            for (int x = 0; x < width; x++)
+                if (region.test(x, y) && at(x, y) == CELL_FREE) return {x, y};
+        return {-1, -1};
+    }
+
+    void setListener(BoardListener* l) { listener = l; }
+
+    int freeCount() const { return freeTotal; }
+
+    // Uniform random FREE cell; {-1, -1} when none is left
+    Point randomFree(RandomSource& rng) const {
+        if (freeTotal == 0) return {-1, -1};
+        int k = rng.next(freeTotal);
+        // Walk down the tree to the word holding the k-th free cell
+        int w = 0;
+        for (int step = freeStep; step > 0; step >>= 1) {
+            if (w + step < (int)freeTree.size() && freeTree[w + step] <= k) {
+                w += step;
+                k -= freeTree[w];
+            }
+        }
+        uint64_t bits = freeBits[w];
+        while (k-- > 0) bits &= bits - 1;
+        int i = w * 64 + lowestBit64(bits);
+        return {i % width, i / width};
+    }
+
+    const std::vector<int>& getDirty() const { return dirty; }
+    void clearDirty() {
+        for (int i : dirty) dirtyFlag[i] = 0;
+        dirty.clear();
+    }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+};
+
+// ==========================================
+//  [DSA CONCEPT: UNION-FIND] REACHABILITY
+// ==========================================
+// Connected regions of passable cells (FREE or FOOD), kept current as
+// the Board changes. Opening a cell (tail pop) can only merge regions,
+// which union-find does in near O(1). Closing a cell (head push,
+// obstacle) can split one: a look at the cell's 8 neighbours proves most
+// closings harmless, and for the rest a lock-step search from each side
+// relabels just the piece that got cut off. Only a search that runs past
+// its budget marks the labels stale, so the next query pays for one full
+// relabel. "Can the head reach this cell?" is then a pair of find()
+// calls instead of a BFS over the whole map.
+class Reachability : public BoardListener {
+private:
+    Board& board;
+    int width, height;
+    std::vector<int> nodeOf;  // Cell -> union-find node, -1 if blocked
+    std::vector<int> parent;  // Nodes are never reused; relabel compacts at nodeLimit()
+    std::vector<int> setSize;
+    bool stale;
+
+    // Scratch for searches, reused so queries never allocate
+    std::vector<uint32_t> seen;
+    uint32_t seenGen;
+    std::vector<int> piece[4];   // Per-side cells of a split search
+    std::vector<uint8_t> owner;  // Which side reached a cell first
+
+    long long relabels;
+
+    static bool passable(Cell c) { return c == CELL_FREE || c == CELL_FOOD; }
+    bool passableAt(int x, int y) const { return passable(board.at(x, y)); }
+
+    // Dead nodes pile up to here before a relabel compacts them; one
+    // split on top of that adds at most a node per cell
+    size_t nodeLimit() const { return 4 * nodeOf.size() + 64; }
+
+    // Expansions a split search may spend before it gives up
+    long long splitBudget() const { return std::max<long long>(4096, (long long)nodeOf.size() / 8); }
+
+    int newNode() {
+        parent.push_back((int)parent.size());
+        setSize.push_back(1);
+        return (int)parent.size() - 1;
+    }
+
+    int find(int a) {
+        while (parent[a] != a) {
+            parent[a] = parent[parent[a]]; // Path halving
+            a = parent[a];
+        }
+        return a;
+    }
+
+    void unite(int a, int b) {
+        a = find(a); b = find(b);
+        if (a == b) return;
+        if (setSize[a] < setSize[b]) std::swap(a, b);
+        parent[b] = a;
+        setSize[a] += setSize[b];
+    }
+
+    void relabel() {
+        SNAKE_PHASE(PHASE_BFS);
+        SNAKE_COUNT(COUNT_BFS_NODES, (long long)width * height);
+        parent.clear();
+        setSize.clear();
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                int i = y * width + x;
+                if (!passableAt(x, y)) { nodeOf[i] = -1; continue; }
+                nodeOf[i] = newNode();
+                if (x > 0 && nodeOf[i - 1] >= 0) unite(nodeOf[i], nodeOf[i - 1]);
+                if (y > 0 && nodeOf[i - width] >= 0) unite(nodeOf[i], nodeOf[i - width]);
+            }
+        }
+        stale = false;
+        relabels++;
+    }
+
+    // Could blocking (x, y) cut its passable 4-neighbours apart? They stay
+    // together if each consecutive pair around the ring is joined by a
+    // passable corner cell.
+    bool maySplit(int x, int y) const {
+        // Ring order: N, NE, E, SE, S, SW, W, NW (even = edge, odd = corner)
+        static const int rx[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+        static const int ry[8] = {-1, -1, 0, 1, 1, 1, 0, -1};
+        bool p[8];
+        for (int k = 0; k < 8; k++) p[k] = passableAt(x + rx[k], y + ry[k]);
+
+        int groups = 0;
+        for (int k = 0; k < 8; k += 2) {
+            if (!p[k]) continue;
+            // A group starts at every edge not joined to the previous edge
+            if (!(p[(k + 7) % 8] && p[(k + 6) % 8])) groups++;
+        }
+        return groups > 1;
+    }
+
+    // Blocking (x, y) may have cut its region in pieces. Search outward
+    // from every passable neighbour in lock-step; searches that meet are
+    // the same piece. A piece whose search runs dry while others are still
+    // going has been cut off, and only its cells get fresh labels, so the
+    // cost is the size of the smaller pieces, not of the map. Returns
+    // false if it gave up (the caller then relabels everything).
+    bool splitOff(int x, int y) {
+        SNAKE_PHASE(PHASE_BFS);
+        static const int dx[] = {0, 0, 1, -1};
+        static const int dy[] = {1, -1, 0, 0};
+        int seeds = 0;
+        size_t next[4];
+        int link[4];    // Tiny union-find over the searches
+        bool done[4];   // Piece already split off
+        nextSearch();
+        for (int k = 0; k < 4; k++) {
+            int nx = x + dx[k], ny = y + dy[k];
+            if (!passableAt(nx, ny)) continue;
+            int c = ny * width + nx;
+            piece[seeds].clear();
+            piece[seeds].push_back(c);
+            seen[c] = seenGen;
+            owner[c] = (uint8_t)seeds;
+            next[seeds] = 0;
+            link[seeds] = seeds;
+            done[seeds] = false;
+            seeds++;
+        }
+        auto root = [&](int g) { while (link[g] != g) g = link[g]; return g; };
+
+        int alive = seeds;
+        const long long allowed = splitBudget();
+        long long budget = allowed;
+        while (alive > 1) {
+            for (int g = 0; g < seeds && alive > 1; g++) {
+                if (next[g] >= piece[g].size()) continue;
+                int c = piece[g][next[g]++];
+                int cx = c % width, cy = c / width;
+                for (int k = 0; k < 4; k++) {
+                    int nx = cx + dx[k], ny = cy + dy[k];
+                    if (!passableAt(nx, ny)) continue;
+                    int n = ny * width + nx;
+                    if (seen[n] != seenGen) {
+                        seen[n] = seenGen;
+                        owner[n] = (uint8_t)g;
+                        piece[g].push_back(n);
+                    } else if (root(owner[n]) != root(g)) {
+                        link[root(owner[n])] = root(g); // Met: same piece
+                        alive--;
+                    }
+                }
+                if (--budget < 0) {
+                    SNAKE_COUNT(COUNT_BFS_NODES, allowed);
+                    return false;
+                }
+            }
+
+            // Any piece whose searches have all run dry is sealed off
+            for (int r = 0; r < seeds && alive > 1; r++) {
+                if (root(r) != r || done[r]) continue;
+                bool dry = true;
+                for (int g = 0; g < seeds; g++)
+                    if (root(g) == r && next[g] < piece[g].size()) dry = false;
+                if (!dry) continue;
+                int label = -1;
+                for (int g = 0; g < seeds; g++) {
+                    if (root(g) != r) continue;
+                    for (int c : piece[g]) {
+                        nodeOf[c] = newNode();
+                        if (label < 0) label = nodeOf[c];
+                        else unite(label, nodeOf[c]);
+                    }
+                }
+                done[r] = true;
+                alive--;
+            }
+        }
+        SNAKE_COUNT(COUNT_BFS_NODES, allowed - budget);
+        return true;
+    }
+
+    void nextSearch() {
+        if (++seenGen == 0) { std::fill(seen.begin(), seen.end(), 0); seenGen = 1; }
+    }
+
+    // Root of a passable cell, -1 for anything else
+    int rootAt(int x, int y) {
+        if (!passableAt(x, y)) return -1;
+        return find(nodeOf[y * width + x]);
+    }
+
+public:
+    explicit Reachability(Board& board)
+        : board(board), width(board.getWidth()), height(board.getHeight()),
+          stale(true), seenGen(0), relabels(0) {
+        nodeOf.assign((size_t)width * height, -1);
+        seen.assign(nodeOf.size(), 0);
+        owner.assign(nodeOf.size(), 0);
+        // Everything a tick can grow, sized once so updates never allocate
+        parent.reserve(nodeLimit() + nodeOf.size() + 1);
+        setSize.reserve(parent.capacity());
+        size_t pieceMax = std::min<size_t>(nodeOf.size(), 4 * splitBudget() + 8);
+        for (auto& p : piece) p.reserve(pieceMax);
+        board.setListener(this);
+    }
+
+    ~Reachability() { board.setListener(NULL); }
+
+    void onCellChanged(int i, Cell from, Cell to) override {
+        bool was = passable(from), now = passable(to);
+        if (was == now || stale) return; // Stale labels get rebuilt anyway
+        int x = i % width, y = i / width;
+
+        // Compact once dead nodes pile up; relabel is O(cells)
+        if (parent.size() > nodeLimit()) { stale = true; return; }
+        if (now) {
+            nodeOf[i] = newNode();
+            static const int dx[] = {0, 0, 1, -1};
+            static const int dy[] = {1, -1, 0, 0};
+            for (int k = 0; k < 4; k++) {
+                int nx = x + dx[k], ny = y + dy[k];
+                if (passableAt(nx, ny)) unite(nodeOf[i], nodeOf[ny * width + nx]);
+            }
+        } else {
+            nodeOf[i] = -1;
+            if (maySplit(x, y) && !splitOff(x, y)) stale = true;
+        }
+    }
+
+    // Can a snake whose head sits on `from` walk to `target`? The head
+    // cell itself is body, so this asks via its four neighbours.
+    bool isReachable(const Point& from, const Point& target) {
+        if (stale) relabel();
+        int rt = rootAt(target.x, target.y);
+        if (rt < 0) return false;
+        return rootAt(from.x, from.y + 1) == rt || rootAt(from.x, from.y - 1) == rt ||
+               rootAt(from.x + 1, from.y) == rt || rootAt(from.x - 1, from.y) == rt;
+    }
+
+    // Uniform FREE cell in the region(s) next to `from`. Only for when
+    // sampling the whole board keeps missing.
+    Point randomReachableFree(const Point& from, RandomSource& rng) {
+        return board.randomFreeInRegion(from, rng);
+    }
+
+    // Drop the labels before rewriting many cells at once; the next
+    // query relabels once instead of tracking every change
+    void invalidate() { stale = true; }
+
+    bool isStale() { return stale; }
+    long long getRelabels() { return relabels; }
+};
+
+// ==========================================
+//    [DSA CONCEPT: RING BUFFER] SNAKE
+// ==========================================
+// The body lives in one fixed-capacity circular array sized to the
+// number of playable cells, so the snake can never outgrow it. Moving
+// writes the new head one slot "behind" the old one and drops the tail
+// by shrinking the live count: O(1), no allocation, no pointer chasing.
+// Each push/pop also retags the matching Board cell.
+
+// Non-owning, non-allocating window over the ring. Index 0 is the head.
+class BodyView {
+private:
+    const Point* cells;
+    int capacity;
+    int head;
+    int count;
+
+public:
+    BodyView(const Point* cells, int capacity, int head, int count)
+        : cells(cells), capacity(capacity), head(head), count(count) {}
+
+    class iterator {
+    private:
+        const Point* cells;
+        int capacity;
+        int idx;  // Physical slot
+        int left; // Segments still to visit
+
+    public:
+        iterator(const Point* c, int cap, int i, int n) : cells(c), capacity(cap), idx(i), left(n) {}
+        const Point& operator*() const { return cells[idx]; }
+        const Point* operator->() const { return &cells[idx]; }
+        iterator& operator++() {
+            if (++idx == capacity) idx = 0;
+            left--;
+            return *this;
+        }
+        bool operator!=(const iterator& other) const { return left != other.left; }
+        bool operator==(const iterator& other) const { return left == other.left; }
+    };
+
+    iterator begin() const { return iterator(cells, capacity, head, count); }
+    iterator end() const { return iterator(cells, capacity, head, 0); }
+    int size() const { return count; }
+
+    const Point& operator[](int i) const {
+        int j = head + i;
+        if (j >= capacity) j -= capacity;
+        return cells[j];
+    }
+};
+
+class Snake {
+private:
+    std::vector<Point> ring; // Allocated once, never resized
+    int capacity;
+    int head;   // Slot of the head segment
+    int count;  // Live segments in the ring
+    int length; // Target length (count catches up after grow())
+    Direction dir;
+    Board* board;
+    Cell lastHit; // What the head landed on during the last move()
+    long long moves; // Steps taken; replays keep the actual directions
+
+public:
+    // `capacity` is the most segments the body may ever hold; the
+    // engine passes the playable cell count of the map.
+    Snake(int x, int y, int capacity, Board* board)
+        : capacity(capacity < 4 ? 4 : capacity), head(0), count(0), length(0), dir(STOP),
+          board(board), lastHit(CELL_FREE), moves(0) {
+        ring.resize(this->capacity);
+        // Start with small body hanging down
+        for(int i=0; i<3; ++i) {
+            ring[count++] = {x, y+i};
+            board->set(x, y+i, CELL_BODY);
+        }
+        length = count;
+    }
+
+    long long getMoveCount() {
+        return moves;
+    }
+
+    // Returns what the new head landed on (CELL_FREE when not moving)
+    Cell move() {
+        if (dir == STOP) return lastHit = CELL_FREE;
+        moves++;
+
+        Point next = ring[head];
+        if (dir == LEFT) next.x--;
+        if (dir == RIGHT) next.x++;
+        if (dir == UP) next.y--;
+        if (dir == DOWN) next.y++;
+
+        // Remove tail unless we still owe growth. The tail leaves first,
+        // so following it into its old cell is not a collision.
+        bool growing = count < length && count < capacity;
+        if (!growing) {
+            const Point& tail = getTail();
+            board->set(tail.x, tail.y, CELL_FREE);
+        }
+
+        // Add new head (may reuse the tail slot when the ring is full;
+        // the tail was just dropped in that case)
+        lastHit = board->at(next.x, next.y);
+        head = (head == 0) ? capacity - 1 : head - 1;
+        ring[head] = next;
+        if (growing) count++;
+        if (lastHit == CELL_FREE || lastHit == CELL_FOOD) board->set(next.x, next.y, CELL_BODY);
+        return lastHit;
+    }
+
+    void grow() { if (length < capacity) length++; }
+
+    // Take back the last move(): drop the head, put `tail` back on the
+    // end if that move dropped it, and retag the Board. `hit` is what the
+    // head landed on; the head's cell goes back to FREE unless the head
+    // never claimed it (a wall, an obstacle, the body).
+    void unmove(const Point& tail, bool tailLeft, Cell hit, Direction prevDir, int prevLength) {
+        const Point& h = ring[head];
+        if (hit == CELL_FREE || hit == CELL_FOOD) board->set(h.x, h.y, CELL_FREE);
+        head = (head + 1 == capacity) ? 0 : head + 1;
+        if (tailLeft) {
+            int slot = head + count - 1;
+            if (slot >= capacity) slot -= capacity;
+            ring[slot] = tail;
+            board->set(tail.x, tail.y, CELL_BODY);
+        } else {
+            count--;
+        }
+        length = prevLength;
+        dir = prevDir;
+        lastHit = CELL_FREE;
+        moves--;
+    }
+
+    bool isCollidingWithSelf() { return lastHit == CELL_BODY; }
+
+    void setDirection(Direction newDir) {
+        if ((dir == LEFT && newDir == RIGHT) || (dir == RIGHT && newDir == LEFT) ||
+            (dir == UP && newDir == DOWN) || (dir == DOWN && newDir == UP)) return;
+        dir = newDir;
+    }
+
+    Direction getDirection() { return dir; }
+    Cell getLastHit() { return lastHit; }
+    int getLength() { return length; }
+    int getCapacity() { return capacity; }
+    const Point& getHead() { return ring[head]; }
+    const Point& getTail() { return getBody()[count - 1]; }
+
+    BodyView getBody() const { return BodyView(ring.data(), capacity, head, count); }
+
+    // Replace the whole body (head first), retagging the Board
+    void restore(const std::vector<Point>& body, int len, Direction d, long long moveCount) {
+        // A dead head may sit on a wall or obstacle; leave those alone
+        for (const Point& p : getBody())
+            if (board->at(p.x, p.y) == CELL_BODY) board->set(p.x, p.y, CELL_FREE);
+        head = 0;
+        count = std::min((int)body.size(), capacity);
+        for (int i = 0; i < count; i++) {
+            ring[i] = body[i];
+            board->set(body[i].x, body[i].y, CELL_BODY);
+        }
+        length = std::max(count, std::min(len, capacity));
+        dir = d;
+        lastHit = CELL_FREE;
+        moves = moveCount;
+    }
+};
+
+// ==========================================
+//    [DSA CONCEPT: GRAPH BFS] FOOD
+// ==========================================
+class Food {
+public:
+    int x, y;
+
+    // Checks if the food location is reachable from the snake's head
+    // Map Walls, Obstacles, and Snake Body block the way. Flood fill over
+    // the Board's bitboards rather than a cell-by-cell BFS. Reference
+    // version; respawn() asks the incremental Reachability service.
+    bool isReachable(int startX, int startY, int targetX, int targetY, Board& board) {
+        if (board.at(targetX, targetY) != CELL_FREE) return false; // Target is inside obstacle
+        return board.canReach({startX, startY}, {targetX, targetY});
+    }
+
+    // Leaves the food at {-1, -1} when the board has no free cell left
+    void respawn(Board& board, Reachability& reach, Snake* snake, RandomSource& rng) {
+        SNAKE_PHASE(PHASE_RESPAWN);
+        // 1-3. Drawn straight from the free set: always inside the map,
+        // off obstacles and off the snake
+        Point p = board.randomFree(rng);
+        if (p.x < 0) { x = y = -1; return; }
+
+        // 4. [DSA] Reachability: a couple of find() calls per candidate
+        const Point& head = snake->getHead();
+        for (int attempts = 0; attempts < 32 && !reach.isReachable(head, p); attempts++)
+            p = board.randomFree(rng);
+
+        // Head is in a small pocket: sample that pocket directly. If it
+        // has no free cell at all, any free cell will do.
+        if (!reach.isReachable(head, p)) {
+            Point q = reach.randomReachableFree(head, rng);
+            if (q.x >= 0) p = q;
+        }
+        x = p.x; y = p.y;
+        board.set(x, y, CELL_FOOD);
+    }
+};
+
+// ==========================================
+//   [DSA CONCEPT: UNION-FIND] MAP GENERATOR
+// ==========================================
+// Obstacles go down as clusters (short random walks) and walls
+// (straight runs) until there are as many as asked for. A cell is only
+// taken if the open cells among its eight neighbours stay joined without
+// it, i.e. its open 4-neighbours lie on one unbroken arc of the ring
+// around it. Closing such a cell can never cut the open area in two, so
+// the map stays one connected region after every placement, checked in
+// O(1) instead of by a flood fill, and no cell is ever taken twice.
+//
+// Maps from files come with no such promise. sealPockets() labels the
+// open cells with a union-find over row runs (runs in adjacent rows that
+// overlap are joined) and fills every region but the spawn's.
+class ObstacleGenerator {
+private:
+    enum { CLUSTER_MAX = 5, WALL_MAX = 10, TILE = 64 };
+
+    struct Run {
+        int y, x0, x1; // Open cells [x0, x1) of row y
+    };
+
+    int width, height;
+    std::vector<uint8_t> open; // Playable and not an obstacle
+    std::vector<Run> runs;
+    std::vector<int> parent, size;
+
+    bool isOpen(int x, int y) const {
+        return (unsigned)x < (unsigned)width && (unsigned)y < (unsigned)height && open[(size_t)y * width + x];
+    }
+
+    // Closing (x, y) leaves its open neighbours connected
+    bool isSimple(int x, int y) const {
+        static const int rx[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+        static const int ry[8] = {-1, -1, 0, 1, 1, 1, 0, -1};
+        bool ring[8];
+        for (int i = 0; i < 8; i++) ring[i] = isOpen(x + rx[i], y + ry[i]);
+        // Open sides, minus those joined to the next side by an open corner
+        int arcs = 0;
+        for (int i = 0; i < 8; i += 2)
+            if (ring[i] && !(ring[(i + 1) & 7] && ring[(i + 2) & 7])) arcs++;
+        return arcs <= 1; // 0: no open side, or all joined into one ring
+    }
+
+    int find(int a) {
+        while (parent[a] != a) a = parent[a] = parent[parent[a]];
+        return a;
+    }
+
+    void unite(int a, int b) {
+        a = find(a);
+        b = find(b);
+        if (a == b) return;
+        if (size[a] < size[b]) std::swap(a, b);
+        parent[b] = a;
+        size[a] += size[b];
+    }
+
+    // Split the open cells into row runs and join overlapping ones
+    void label() {
+        runs.clear();
+        parent.clear();
+        size.clear();
+        size_t above = 0, aboveEnd = 0; // The previous row's runs
+        for (int y = 0; y < height; y++) {
+            size_t first = runs.size();
+            const uint8_t* row = &open[(size_t)y * width];
+            for (int x = 0; x < width;) {
+                if (!row[x]) { x++; continue; }
+                int x0 = x;
+                while (x < width && row[x]) x++;
+                int id = (int)runs.size();
+                runs.push_back({y, x0, x});
+                parent.push_back(id);
+                size.push_back(x - x0);
+                // Both rows are sorted by x, so runs ending left of this
+                // one can not touch any later run either
+                while (above < aboveEnd && runs[above].x1 <= x0) above++;
+                for (size_t j = above; j < aboveEnd && runs[j].x0 < x; j++) unite(id, (int)j);
+            }
+            above = first;
+            aboveEnd = runs.size();
+        }
+    }
+
+public:
+    ObstacleGenerator() : width(0), height(0) {}
+
+    // Start from the playable cells of `mask` minus `obstacles`
+    void reset(const BitGrid& mask, const std::vector<Point>& obstacles) {
+        width = mask.getWidth();
+        height = mask.getHeight();
+        open.assign((size_t)width * height, 0);
+        for (int y = 0; y < height; y++) {
+            const uint64_t* bits = mask.row(y);
+            uint8_t* row = &open[(size_t)y * width];
+            for (int x = 0; x < width; x++) row[x] = (bits[x >> 6] >> (x & 63)) & 1;
+        }
+        for (const Point& p : obstacles)
+            if (isOpen(p.x, p.y)) open[(size_t)p.y * width + p.x] = 0;
+    }
+
+    // Place up to `count` more obstacles, none within `clear` cells of
+    // `spawn`, appending them to `out`. Returns how many went down: fewer
+    // than asked only when the open area has no safe room left.
+    int generate(int count, const Point& spawn, int clear, RandomSource& rng, std::vector<Point>& out) {
+        // Tile by tile, each getting its share of `count` by open cells,
+        // so strokes land in cache-sized patches rather than all over a
+        // big map. A map smaller than a tile is one tile.
+        long long total = 0;
+        std::vector<int> tileOpen;
+        for (int ty = 0; ty < height; ty += TILE)
+            for (int tx = 0; tx < width; tx += TILE) {
+                int n = 0;
+                for (int y = ty; y < std::min(ty + (int)TILE, height); y++) {
+                    const uint8_t* row = &open[(size_t)y * width];
+                    for (int x = tx; x < std::min(tx + (int)TILE, width); x++) n += row[x];
+                }
+                tileOpen.push_back(n);
+                total += n;
+            }
+        if (total == 0) return 0;
+        out.reserve(out.size() + count);
+
+        int placed = 0;
+        long long seen = 0;
+        size_t tile = 0;
+        for (int ty = 0; ty < height; ty += TILE)
+            for (int tx = 0; tx < width; tx += TILE) {
+                seen += tileOpen[tile++];
+                int quota = (int)((long double)count * seen / total) - placed;
+                placed += generateIn(tx, ty, std::min((int)TILE, width - tx), std::min((int)TILE, height - ty), quota, spawn,
+                                     clear, rng, out);
+            }
+        return placed;
+    }
+
+private:
+    int generateIn(int left, int top, int w, int h, int count, const Point& spawn, int clear, RandomSource& rng,
+                   std::vector<Point>& out) {
+        int placed = 0;
+        auto take = [&](int x, int y) {
+            if (!isOpen(x, y) || (std::abs(x - spawn.x) <= clear && std::abs(y - spawn.y) <= clear) ||
+                !isSimple(x, y)) return false;
+            open[(size_t)y * width + x] = 0;
+            out.push_back({x, y});
+            placed++;
+            return true;
+        };
+        // A crowded map runs out of strokes rather than retrying forever
+        for (long long strokes = 8LL * count + 64; placed < count && strokes > 0; strokes--) {
+            int x = left + rng.next(w), y = top + rng.next(h);
+            if (!isOpen(x, y)) continue;
+            if (rng.next(4) == 0) {
+                int dx = rng.next(2), dy = 1 - dx;
+                for (int n = 2 + rng.next(WALL_MAX - 1); n > 0 && placed < count && take(x, y); n--) {
+                    x += dx;
+                    y += dy;
+                }
+            } else {
+                for (int n = 1 + rng.next(CLUSTER_MAX); n > 0 && placed < count; n--) {
+                    take(x, y);
+                    int d = rng.next(4);
+                    x += (d == 0) - (d == 1);
+                    y += (d == 2) - (d == 3);
+                }
+            }
+        }
+        return placed;
+    }
+
+public:
+    // Separate open regions (8-neighbour corners do not join them)
+    int regions() {
+        label();
+        int n = 0;
+        for (size_t i = 0; i < runs.size(); i++) n += parent[i] == (int)i;
+        return n;
+    }
+
+    // Fill every open region but the one holding `keep` (the largest if
+    // `keep` is not open), appending the filled cells to `out`
+    long long sealPockets(const Point& keep, std::vector<Point>& out) {
+        label();
+        if (runs.empty()) return 0;
+        int root = -1;
+        for (size_t i = 0; i < runs.size(); i++) {
+            const Run& r = runs[i];
+            if (r.y == keep.y && r.x0 <= keep.x && keep.x < r.x1) root = find((int)i);
+        }
+        if (root < 0) {
+            for (size_t i = 0; i < runs.size(); i++)
+                if (parent[i] == (int)i && (root < 0 || size[i] > size[root])) root = (int)i;
+        }
+        long long filled = 0;
+        for (size_t i = 0; i < runs.size(); i++) {
+            if (find((int)i) == root) continue;
+            const Run& r = runs[i];
+            for (int x = r.x0; x < r.x1; x++) {
+                open[(size_t)r.y * width + x] = 0;
+                out.push_back({x, r.y});
+                filled++;
+            }
+        }
+        return filled;
+    }
+};
+
+// ==========================================
+//           MAIN GAME ENGINE
+// ==========================================
+
+// What happened during one Game::step()
+struct StepResult {
+    bool ateFood;
+    bool died;
+};
+
+// Everything a running game changes. The map and obstacles are not in
+// here: they follow from the mode, map type, difficulty and seed.
+struct GameState {
+    long long ticks;
+    int score;
+    double timeLeft;
+    Direction dir;
+    int length;
+    long long moves;
+    Point food;
+    std::vector<Point> body; // Head first
+};
+
+// What one Game::step() changed, enough to take it back: the state
+// before the tick plus what the move did. Kept per tick by a rewind
+// buffer, so stepping back costs O(1) per tick instead of a full copy.
+struct TickDelta {
+    Point tail;        // Tail before the tick (put back if it left)
+    Point food;        // Food before the tick
+    double timeLeft;
+    RandomState rngState; // Generator before the tick
+    int score;
+    int length;
+    Direction dir;
+    Cell hit;          // What the head landed on
+    bool moved, tailLeft;
+};
+
+class Game {
+private:
+    GameMap* map;
+    Board* board;
+    Reachability* reach;
+    Snake* snake;
+    Food* food;
+    std::vector<Point> obstacles;
+
+    RandomSource& rng;
+    GameClock& clock;
+
+    GameMode mode;
+    MapType mapType;
+    int difficulty;
+    bool gameOver;
+    DeathCause cause;
+    int score;
+    double timeLeft;
+    double lastTime;
+    int tickPeriodMs;
+    long long ticks;
+
+    // Clusters and walls that leave the open area in one piece. The
+    // count is for the standard size; other sizes keep its density.
+    void generateObstacles(int count) {
+        int w = map->getWidth(), h = map->getHeight();
+        count = (int)((long long)count * w * h / (STANDARD_MAP_WIDTH * STANDARD_MAP_HEIGHT));
+        obstacles.clear();
+        ObstacleGenerator gen;
+        gen.reset(map->getMask(), obstacles);
+        gen.generate(count, {w / 2, h / 2}, 5, rng, obstacles);
+        for (const Point& p : obstacles) board->set(p.x, p.y, CELL_OBSTACLE);
+    }
+
+    // Everything after the map: board, snake, obstacles, first food.
+    // `fixed` are the obstacles of a loaded map; NULL generates them.
+    void start(const Point& spawn, const std::vector<Point>* fixed) {
+        board = new Board(map);
+        reach = new Reachability(*board);
+        snake = new Snake(spawn.x, spawn.y, map->countValid(), board);
+
+        // Difficulty controls speed and obstacle count
+        tickPeriodMs = (difficulty == 1) ? 100 : (difficulty == 2) ? 60 : 30;
+        if (fixed) setObstacles(*fixed);
+        else generateObstacles((difficulty == 1) ? 5 : (difficulty == 2) ? 15 : 25);
+
+        food = new Food();
+        food->respawn(*board, *reach, snake, rng);
+
+        score = 0;
+        gameOver = false;
+        cause = ALIVE;
+        timeLeft = (mode == TIME_ATTACK) ? 20.0 : 0.0;
+        lastTime = clock.now();
+        ticks = 0;
+    }
+
+    void end(DeathCause why) {
+        if (gameOver) return;
+        gameOver = true;
+        cause = why;
+    }
+
+public:
+    static const int DEFAULT_WIDTH = STANDARD_MAP_WIDTH;
+    static const int DEFAULT_HEIGHT = STANDARD_MAP_HEIGHT;
+
+    // Anything but the standard size builds its map shape at run time
+    Game(GameMode gm, MapType mt, int diff, RandomSource& rng, GameClock& clock,
+         int w = DEFAULT_WIDTH, int h = DEFAULT_HEIGHT)
+        : rng(rng), clock(clock), mode(gm), mapType(mt), difficulty(diff) {
+
+        if (mt == RECTANGLE) map = new RectangularMap(w, h);
+        else if (mt == CIRCLE) map = new CircularMap(w, h);
+        else map = new TriangularMap(w, h);
+
+        map->generateMap();
+        start({w / 2, h / 2}, NULL);
+    }
+
+    // A loaded map: its walls and obstacles as drawn, none generated.
+    // `layout` must outlive the game.
+    Game(GameMode gm, const MapData& layout, int diff, RandomSource& rng, GameClock& clock)
+        : rng(rng), clock(clock), mode(gm), mapType(CUSTOM), difficulty(diff) {
+        map = new LoadedMap(layout);
+        map->generateMap();
+        start(layout.spawn, &layout.obstacles);
+    }
+
+    ~Game() { delete reach; delete map; delete board; delete snake; delete food; }
+
+    Game(const Game&) = delete;
+    Game& operator=(const Game&) = delete;
+
+    // Advance the simulation by one tick. `turn` is the requested
+    // direction for this tick; STOP means "no new input".
+    StepResult step(Direction turn) {
+        SNAKE_PHASE(PHASE_LOGIC);
+        StepResult result = {false, false};
+        if (gameOver) return result;
+        ticks++;
+
+        // Timer
+        double now = clock.now();
+        double elapsed = now - lastTime;
+        lastTime = now;
+
+        if(mode == TIME_ATTACK) {
+            timeLeft -= elapsed;
+            if(timeLeft <= 0) end(TIME_OUT);
+        }
+
+        if (turn != STOP) snake->setDirection(turn);
+        Cell hit = snake->move();
+
+        // Map, Self and Obstacle Collision: one Board lookup
+        if(hit == CELL_VOID) end(HIT_WALL);
+        else if(hit == CELL_BODY) end(HIT_SELF);
+        else if(hit == CELL_OBSTACLE) end(HIT_OBSTACLE);
+
+        if(gameOver) {
+            result.died = true;
+            return result;
+        }
+
+        // Eat Food
+        if(hit == CELL_FOOD) {
+            result.ateFood = true;
+            score += 10;
+            snake->grow();
+            if(mode == TIME_ATTACK) timeLeft += 3.0; // Bonus time
+            food->respawn(*board, *reach, snake, rng);
+            if (food->x < 0) end(WON); // Nowhere left to put food: the snake fills the map
+        }
+        return result;
+    }
+
+    // Player asked to leave (the 'x' key)
+    void quit() { end(QUIT); }
+
+    // End the game for a reason step() could not see on its own; replays
+    // use it to finish the way the recorded game did (time out, quit)
+    void forceEnd(DeathCause why) { end(why); }
+
+    void saveState(GameState& s) {
+        s.ticks = ticks;
+        s.score = score;
+        s.timeLeft = timeLeft;
+        s.dir = snake->getDirection();
+        s.length = snake->getLength();
+        s.moves = snake->getMoveCount();
+        s.food = {food->x, food->y};
+        s.body.clear();
+        for (const Point& p : snake->getBody()) s.body.push_back(p);
+    }
+
+    // Whether loadState(s) leaves a live snake on the board with `obs` as
+    // the obstacles (all on the grid): a body of one or more distinct
+    // playable cells, each 4-adjacent to the one before and none on an
+    // obstacle, a length of the body's or one more (growth still owed),
+    // and the food -1/-1 or a playable cell off the body and obstacles.
+    // States read from a file must pass this first.
+    bool fitsState(const GameState& s, const std::vector<Point>& obs) {
+        int w = map->getWidth(), h = map->getHeight();
+        size_t n = s.body.size();
+        if (n == 0 || n > (size_t)w * h || s.length < (int)n || s.length > (int)n + 1) return false;
+        std::vector<uint8_t> taken((size_t)w * h, 0);
+        for (const Point& p : obs) {
+            if ((unsigned)p.x >= (unsigned)w || (unsigned)p.y >= (unsigned)h) return false;
+            taken[(size_t)p.y * w + p.x] = 1;
+        }
+        for (size_t i = 0; i < n; i++) {
+            const Point& p = s.body[i];
+            if (!map->isValid(p.x, p.y) || taken[(size_t)p.y * w + p.x]) return false;
+            if (i > 0 && std::abs(p.x - s.body[i - 1].x) + std::abs(p.y - s.body[i - 1].y) != 1) return false;
+            taken[(size_t)p.y * w + p.x] = 1;
+        }
+        if (s.food.x == -1 && s.food.y == -1) return true;
+        return map->isValid(s.food.x, s.food.y) && !taken[(size_t)s.food.y * w + s.food.x];
+    }
+
+    // Only valid for a game built with the same mode, map type and
+    // difficulty from the same seed (so the obstacles match)
+    void loadState(const GameState& s) {
+        reach->invalidate();
+        if (board->at(food->x, food->y) == CELL_FOOD) board->set(food->x, food->y, CELL_FREE);
+        snake->restore(s.body, s.length, s.dir, s.moves);
+        food->x = s.food.x;
+        food->y = s.food.y;
+        if (food->x >= 0) board->set(food->x, food->y, CELL_FOOD);
+        ticks = s.ticks;
+        score = s.score;
+        timeLeft = s.timeLeft;
+        gameOver = false;
+        cause = ALIVE;
+        lastTime = clock.now();
+    }
+
+    // Undo one step() described by `d` (the caller restores the
+    // generator to d.rngState). The clock carries on from now.
+    void undo(const TickDelta& d) {
+        if (d.moved) snake->unmove(d.tail, d.tailLeft, d.hit, d.dir, d.length); // Else nothing moved
+        if (food->x != d.food.x || food->y != d.food.y) {
+            if (board->at(food->x, food->y) == CELL_FOOD) board->set(food->x, food->y, CELL_FREE);
+            food->x = d.food.x;
+            food->y = d.food.y;
+        }
+        if (food->x >= 0 && board->at(food->x, food->y) == CELL_FREE) board->set(food->x, food->y, CELL_FOOD);
+        score = d.score;
+        timeLeft = d.timeLeft;
+        ticks--;
+        gameOver = false;
+        cause = ALIVE;
+        lastTime = clock.now();
+    }
+
+    // Swap the obstacles for `obs` (a snapshot of another session)
+    void setObstacles(const std::vector<Point>& obs) {
+        for (const Point& p : obstacles)
+            if (board->at(p.x, p.y) == CELL_OBSTACLE) board->set(p.x, p.y, CELL_FREE);
+        obstacles.clear();
+        for (const Point& p : obs) {
+            if (board->at(p.x, p.y) != CELL_FREE) continue;
+            board->set(p.x, p.y, CELL_OBSTACLE);
+            obstacles.push_back(p);
+        }
+        reach->invalidate();
+    }
+
+    // True if moving the head onto (x, y) would be fatal right now
+    bool isBlocked(int x, int y) {
+        Cell c = board->at(x, y);
+        return c == CELL_VOID || c == CELL_OBSTACLE || c == CELL_BODY;
+    }
+
+    GameMap* getMap() { return map; }
+    Board* getBoard() { return board; }
+    Reachability* getReachability() { return reach; }
+    Snake* getSnake() { return snake; }
+    Food* getFood() { return food; }
+    const std::vector<Point>& getObstacles() { return obstacles; }
+
+    GameMode getMode() { return mode; }
+    MapType getMapType() { return mapType; }
+    int getDifficulty() { return difficulty; }
+    bool isOver() { return gameOver; }
+    DeathCause getDeathCause() { return cause; }
+    int getScore() { return score; }
+    double getTimeLeft() { return timeLeft; }
+    int getTickPeriodMs() { return tickPeriodMs; }
+    long long getTicks() { return ticks; }
+};
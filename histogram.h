@@ -0,0 +1,88 @@
+#pragma once
+
+// ==========================================
+//   [DSA CONCEPT: LOG BUCKETS] HISTOGRAM
+// ==========================================
+// Fixed-size, HDR-style histogram of non-negative integer samples
+// (nanoseconds, counts). Values below 16 get a bucket each; above that
+// every power of two is split into 16 linear sub-buckets, so a reported
+// percentile is within 1/16 (~6%) of the true sample. Recording is a
+// bit scan and an increment, memory never grows, and two histograms
+// merge by adding their buckets, which is how per-thread ones combine.
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "bitboard.h"
+
+class Histogram {
+private:
+    static const int SUB_BITS = 4;
+    static const int SUB = 1 << SUB_BITS;
+    static const int BUCKETS = (64 - SUB_BITS + 1) * SUB;
+
+    uint64_t counts[BUCKETS];
+    uint64_t total;
+    uint64_t minValue, maxValue;
+    double sum;
+
+    static int bucketOf(uint64_t v) {
+        if (v < (uint64_t)SUB) return (int)v;
+        int shift = highestBit64(v) - SUB_BITS;
+        return (shift + 1) * SUB + (int)((v >> shift) & (SUB - 1));
+    }
+
+    // Largest value that lands in bucket i
+    static uint64_t bucketTop(int i) {
+        if (i < SUB) return (uint64_t)i;
+        int shift = i / SUB - 1;
+        uint64_t low = (uint64_t)(SUB + i % SUB) << shift;
+        return low + ((uint64_t)1 << shift) - 1;
+    }
+
+public:
+    Histogram() { reset(); }
+
+    void reset() {
+        memset(counts, 0, sizeof(counts));
+        total = 0;
+        minValue = UINT64_MAX;
+        maxValue = 0;
+        sum = 0;
+    }
+
+    void record(uint64_t v) {
+        counts[bucketOf(v)]++;
+        total++;
+        sum += (double)v;
+        if (v < minValue) minValue = v;
+        if (v > maxValue) maxValue = v;
+    }
+
+    void merge(const Histogram& o) {
+        for (int i = 0; i < BUCKETS; i++) counts[i] += o.counts[i];
+        total += o.total;
+        sum += o.sum;
+        minValue = std::min(minValue, o.minValue);
+        maxValue = std::max(maxValue, o.maxValue);
+    }
+
+    // Smallest bucket bound with at least p (0..1) of the samples at or
+    // below it, capped at the exact maximum; 0 when empty
+    uint64_t percentile(double p) const {
+        if (total == 0) return 0;
+        uint64_t want = (uint64_t)(p * (double)total + 0.5);
+        if (want < 1) want = 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += counts[i];
+            if (seen >= want) return std::min(bucketTop(i), maxValue);
+        }
+        return maxValue;
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t min() const { return total ? minValue : 0; }
+    uint64_t max() const { return maxValue; }
+    double mean() const { return total ? sum / (double)total : 0; }
+};
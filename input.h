@@ -0,0 +1,224 @@
+#pragma once
+
+// ==========================================
+//   [DSA CONCEPT: SPSC RING] INPUT PIPELINE
+// ==========================================
+// A reader thread blocks on the keyboard (poll() on a raw terminal, the
+// console input handle on Windows), stamps each key with the steady
+// clock and pushes it into a lock-free single-producer/single-consumer
+// ring. The tick drains everything pending and a TurnCoalescer turns
+// the burst into at most one turn now plus one buffered for the next
+// tick, so fast key combos are neither lost nor replayed as a backlog.
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include "engine.h"
+#include "ring.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+inline int64_t steadyNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct KeyEvent {
+    int key;       // 'w', 'a', 's', 'd', 'x', 'b', 'p' (arrows arrive as wasd)
+    int64_t stamp; // steadyNanos() when the key was read
+};
+
+class InputReader {
+private:
+    SpscRing<KeyEvent, 256> ring;
+    std::thread worker;
+    std::atomic<bool> running;
+    std::atomic<long long> dropped; // Keys lost to a full ring
+#ifndef _WIN32
+    termios saved;
+    bool rawMode;
+#endif
+
+    void emit(int key, int64_t stamp) {
+        if (!ring.push({key, stamp})) dropped++;
+    }
+
+    void loop() {
+#ifdef _WIN32
+        HANDLE in = GetStdHandle(STD_INPUT_HANDLE);
+        INPUT_RECORD recs[16];
+        while (running.load(std::memory_order_relaxed)) {
+            if (WaitForSingleObject(in, 10) != WAIT_OBJECT_0) continue;
+            DWORD n = 0;
+            if (!ReadConsoleInputA(in, recs, 16, &n)) continue;
+            int64_t stamp = steadyNanos();
+            for (DWORD i = 0; i < n; i++) {
+                if (recs[i].EventType != KEY_EVENT || !recs[i].Event.KeyEvent.bKeyDown) continue;
+                switch (recs[i].Event.KeyEvent.wVirtualKeyCode) {
+                    case VK_UP: emit('w', stamp); break;
+                    case VK_LEFT: emit('a', stamp); break;
+                    case VK_DOWN: emit('s', stamp); break;
+                    case VK_RIGHT: emit('d', stamp); break;
+                    default: emit(recs[i].Event.KeyEvent.uChar.AsciiChar, stamp); break;
+                }
+            }
+        }
+#else
+        unsigned char buf[64];
+        int escape = 0; // Progress through an arrow key's ESC [ x
+        while (running.load(std::memory_order_relaxed)) {
+            pollfd p = {STDIN_FILENO, POLLIN, 0};
+            if (::poll(&p, 1, 10) <= 0) continue;
+            ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+            if (n <= 0) break; // EOF or error: no more keys will come
+            int64_t stamp = steadyNanos();
+            for (ssize_t i = 0; i < n; i++) {
+                int c = buf[i];
+                if (escape == 0 && c == 0x1b) { escape = 1; continue; }
+                if (escape == 1) { escape = (c == '[') ? 2 : 0; continue; }
+                if (escape == 2) {
+                    escape = 0;
+                    if (c == 'A') emit('w', stamp);
+                    else if (c == 'B') emit('s', stamp);
+                    else if (c == 'C') emit('d', stamp);
+                    else if (c == 'D') emit('a', stamp);
+                    continue;
+                }
+                emit(c, stamp);
+            }
+        }
+#endif
+    }
+
+public:
+    InputReader() : running(false), dropped(0) {
+#ifndef _WIN32
+        rawMode = false;
+#endif
+    }
+
+    ~InputReader() { stop(); }
+
+    InputReader(const InputReader&) = delete;
+    InputReader& operator=(const InputReader&) = delete;
+
+    void start() {
+        if (running) return;
+#ifndef _WIN32
+        // Keys arrive one at a time and unechoed
+        if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &saved) == 0) {
+            termios raw = saved;
+            raw.c_lflag &= ~(ICANON | ECHO);
+            raw.c_cc[VMIN] = 0;
+            raw.c_cc[VTIME] = 0;
+            rawMode = tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0;
+        }
+#endif
+        running = true;
+        worker = std::thread(&InputReader::loop, this);
+    }
+
+    void stop() {
+        if (!running) return;
+        running = false;
+        worker.join();
+#ifndef _WIN32
+        if (rawMode) tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+        rawMode = false;
+#endif
+    }
+
+    // Consumer side: next pending key, oldest first
+    bool poll(KeyEvent& e) { return ring.pop(e); }
+
+    long long getDropped() { return dropped; }
+};
+
+// The per-tick input policy:
+//  1. A key that would reverse or repeat the direction it follows is
+//     dropped.
+//  2. The first valid turn is applied this tick.
+//  3. One more turn, valid after that one, is buffered for the next
+//     tick; later keys in the same burst replace it (the latest wins).
+// So "up, left" pressed within one tick while moving right turns up now
+// and left on the next tick instead of losing the second key.
+class TurnCoalescer {
+private:
+    Direction cur;    // The snake's direction at the start of the tick
+    Direction now;    // Turn for this tick
+    Direction queued; // Turn for the next tick
+    int64_t nowStamp, queuedStamp;
+    bool quitting;
+    bool saving;  // 'p': save the session and stop
+    int rewinds;  // 'b' presses this tick
+
+    static bool turns(Direction from, Direction to) {
+        if (to == STOP || to == from) return false;
+        return !((from == LEFT && to == RIGHT) || (from == RIGHT && to == LEFT) ||
+                 (from == UP && to == DOWN) || (from == DOWN && to == UP));
+    }
+
+    static Direction fromKey(int key) {
+        switch (key) {
+            case 'w': return UP;
+            case 's': return DOWN;
+            case 'a': return LEFT;
+            case 'd': return RIGHT;
+        }
+        return STOP;
+    }
+
+public:
+    TurnCoalescer()
+        : cur(STOP), now(STOP), queued(STOP), nowStamp(0), queuedStamp(0), quitting(false), saving(false), rewinds(0) {}
+
+    // Start a tick; `current` is the direction the snake is moving in
+    void begin(Direction current) {
+        now = STOP;
+        if (turns(current, queued)) { now = queued; nowStamp = queuedStamp; }
+        queued = STOP;
+        cur = current;
+        rewinds = 0;
+    }
+
+    void add(const KeyEvent& e) {
+        if (e.key == 'x') { quitting = true; return; }
+        if (e.key == 'p') { saving = true; return; }
+        if (e.key == 'b') { rewinds++; return; }
+        Direction d = fromKey(e.key);
+        if (now == STOP) {
+            if (turns(cur, d)) { now = d; nowStamp = e.stamp; }
+        } else if (turns(now, d)) {
+            queued = d;
+            queuedStamp = e.stamp;
+        }
+    }
+
+    // This tick's turn (STOP for none) and the stamp of the key behind it
+    Direction turn() { return now; }
+    int64_t turnStamp() { return now == STOP ? 0 : nowStamp; }
+    bool quitRequested() { return quitting; }
+    bool saveRequested() { return saving; }
+    int rewindsRequested() { return rewinds; }
+};
+
+// Key press to the first presented frame that shows its effect
+struct LatencyStats {
+    long long count = 0;
+    double sum = 0, max = 0; // Seconds
+
+    void add(double s) {
+        count++;
+        sum += s;
+        max = std::max(max, s);
+    }
+    double avg() const { return count ? sum / count : 0; }
+};
@@ -0,0 +1,300 @@
+#pragma once
+
+// ==========================================
+//   [DSA CONCEPT: FENWICK TREE] LEADERBOARD
+// ==========================================
+// Every finished game is one entry: player name, mode, map, difficulty
+// and score. Entries go into two files:
+//   <base>.log  append-only records, the source of truth
+//   <base>.idx  a fixed-size index, memory-mapped where the platform has
+//               mmap: per category (mode x map x difficulty) the best
+//               TOP_KEEP entries in order, and a Fenwick tree of entry
+//               counts per score step of 10, so "how many scored at most
+//               s" is a dozen additions
+// The index header says how many log bytes it covers. Opening maps the
+// index and replays only the log records written after that point, so
+// startup does not read the log. The header's dirty flag is set while an
+// entry is being applied; an index left dirty by a crash, or one that
+// does not match, is rebuilt from the whole log.
+//
+// Log record: category u8, name length u8, u16 0, score i32, time i64,
+// name, FNV-1a u32 of everything before it. A record cut short by a
+// crash fails its length or checksum; it and anything after it are cut
+// off the log on open, so the next append starts clean.
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <ctime>
+#include <algorithm>
+#include <filesystem>
+#include "engine.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+struct LeaderboardEntry {
+    int32_t score;
+    uint32_t when;  // Unix time, low 32 bits
+    char name[24];  // Cut to 23 bytes, NUL-terminated
+};
+
+// Where a score stands in its category
+struct Standing {
+    long long rank;   // 1 + entries with a higher score
+    long long total;  // Entries in the category
+    double percentile; // Share of entries scoring at most this, 0..100
+};
+
+class Leaderboard {
+public:
+    static const int TOP_KEEP = 100;        // Longest top list kept per category
+    static const int SCORE_STEP = 10;       // Food is worth 10
+    static const int SCORE_BUCKETS = 4096;  // Scores from 40950 up share the last
+    static const int CATEGORIES = 2 * 3 * 3;
+
+private:
+    static const uint32_t VERSION = 1;
+    static const size_t RECORD_FIXED = 20; // Header 16 + checksum 4
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint64_t covered; // Log bytes reflected in the index
+        uint32_t dirty;
+        uint32_t categories;
+    };
+
+    struct Category {
+        uint64_t total;
+        uint32_t topCount;
+        uint32_t pad;
+        LeaderboardEntry top[TOP_KEEP];
+        uint32_t tree[SCORE_BUCKETS]; // Fenwick tree, tree[i - 1] is node i
+    };
+
+    static const size_t IMAGE_SIZE = sizeof(Header) + CATEGORIES * sizeof(Category);
+
+    std::string logPath, indexPath;
+    FILE* log;
+    uint8_t* image;
+#ifdef _WIN32
+    std::vector<uint8_t> copy;
+#endif
+    long long replayed; // Log records read at open
+
+    Header& header() { return *(Header*)image; }
+    Category& category(int c) { return ((Category*)(image + sizeof(Header)))[c]; }
+
+    static int categoryOf(GameMode mode, MapType map, int difficulty) {
+        if (mode < CLASSIC || mode > TIME_ATTACK || map < RECTANGLE || map > TRIANGLE || difficulty < 1 || difficulty > 3)
+            return -1;
+        return ((mode - 1) * 3 + (map - 1)) * 3 + (difficulty - 1);
+    }
+
+    static int bucketOf(int score) { return std::min(std::max(score, 0) / SCORE_STEP, SCORE_BUCKETS - 1); }
+
+    static uint32_t fnv(const uint8_t* p, size_t n) {
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < n; i++) h = (h ^ p[i]) * 16777619u;
+        return h;
+    }
+
+    // Entries in buckets 0..b
+    static uint64_t countUpTo(const Category& c, int b) {
+        uint64_t n = 0;
+        for (int i = b + 1; i > 0; i -= i & -i) n += c.tree[i - 1];
+        return n;
+    }
+
+    void apply(int cat, const char* name, size_t nameLen, int32_t score, int64_t when) {
+        Category& c = category(cat);
+        c.total++;
+        for (int i = bucketOf(score) + 1; i <= SCORE_BUCKETS; i += i & -i) c.tree[i - 1]++;
+
+        // Ties keep the earlier entry in front
+        int pos = (int)c.topCount;
+        while (pos > 0 && c.top[pos - 1].score < score) pos--;
+        if (pos >= TOP_KEEP) return;
+        int last = std::min((int)c.topCount, TOP_KEEP - 1);
+        memmove(&c.top[pos + 1], &c.top[pos], (last - pos) * sizeof(LeaderboardEntry));
+        LeaderboardEntry& e = c.top[pos];
+        e.score = score;
+        e.when = (uint32_t)when;
+        memset(e.name, 0, sizeof(e.name));
+        memcpy(e.name, name, std::min(nameLen, sizeof(e.name) - 1));
+        if (c.topCount < (uint32_t)TOP_KEEP) c.topCount++;
+    }
+
+    // Apply the log from `from` on; cut off a torn or corrupt tail
+    bool replay(uint64_t from) {
+        FILE* f = fopen(logPath.c_str(), "rb");
+        if (!f) return from == 0;
+        std::vector<uint8_t> bytes;
+        if (fseek(f, (long)from, SEEK_SET) == 0) {
+            uint8_t chunk[65536];
+            for (size_t n; (n = fread(chunk, 1, sizeof(chunk), f)) > 0;) bytes.insert(bytes.end(), chunk, chunk + n);
+        }
+        fclose(f);
+
+        size_t at = 0;
+        while (bytes.size() - at >= RECORD_FIXED) {
+            const uint8_t* r = bytes.data() + at;
+            size_t size = RECORD_FIXED + r[1];
+            if (bytes.size() - at < size || r[0] >= CATEGORIES) break;
+            uint32_t sum;
+            memcpy(&sum, r + size - 4, 4);
+            if (sum != fnv(r, size - 4)) break;
+            int32_t score;
+            int64_t when;
+            memcpy(&score, r + 4, 4);
+            memcpy(&when, r + 8, 8);
+            apply(r[0], (const char*)r + 16, r[1], score, when);
+            replayed++;
+            at += size;
+        }
+        header().covered = from + at;
+        if (at < bytes.size()) {
+            std::error_code ec;
+            std::filesystem::resize_file(logPath, from + at, ec);
+            if (ec) return false;
+        }
+        return true;
+    }
+
+    bool valid() {
+        Header& h = header();
+        std::error_code ec;
+        uint64_t logSize = std::filesystem::exists(logPath, ec) ? std::filesystem::file_size(logPath, ec) : 0;
+        return !ec && memcmp(h.magic, "SNKL", 4) == 0 && h.version == VERSION && h.categories == CATEGORIES &&
+               !h.dirty && h.covered <= logSize;
+    }
+
+    bool mapIndex() {
+#ifdef _WIN32
+        copy.assign(IMAGE_SIZE, 0);
+        image = copy.data();
+        if (FILE* f = fopen(indexPath.c_str(), "rb")) {
+            if (fread(image, 1, IMAGE_SIZE, f) != IMAGE_SIZE) memset(image, 0, IMAGE_SIZE);
+            fclose(f);
+        }
+        return true;
+#else
+        int fd = open(indexPath.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0) return false;
+        struct stat st;
+        bool sized = fstat(fd, &st) == 0 && ((size_t)st.st_size == IMAGE_SIZE || ftruncate(fd, (off_t)IMAGE_SIZE) == 0);
+        void* mapping = sized ? mmap(NULL, IMAGE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        close(fd);
+        if (mapping == MAP_FAILED) return false;
+        image = (uint8_t*)mapping;
+        return true;
+#endif
+    }
+
+    // The mapping writes itself back; the Windows copy is saved whole
+    // through a temporary file so a crash leaves the old one or none
+    void saveIndex() {
+#ifdef _WIN32
+        std::string tmp = indexPath + ".tmp";
+        FILE* f = fopen(tmp.c_str(), "wb");
+        if (!f) return;
+        bool ok = fwrite(image, 1, IMAGE_SIZE, f) == IMAGE_SIZE;
+        if (fclose(f) != 0 || !ok) return;
+        remove(indexPath.c_str());
+        rename(tmp.c_str(), indexPath.c_str());
+#endif
+    }
+
+public:
+    // Opens (or creates) <base>.log and <base>.idx
+    explicit Leaderboard(const std::string& base)
+        : logPath(base + ".log"), indexPath(base + ".idx"), log(NULL), image(NULL), replayed(0) {
+        if (!mapIndex()) return;
+        uint64_t from = 0;
+        if (valid()) {
+            from = header().covered;
+        } else {
+            memset(image, 0, IMAGE_SIZE);
+            memcpy(header().magic, "SNKL", 4);
+            header().version = VERSION;
+            header().categories = CATEGORIES;
+        }
+        header().dirty = 1;
+        bool ok = replay(from);
+        header().dirty = 0;
+        if (replayed || from == 0) saveIndex();
+        if (ok) log = fopen(logPath.c_str(), "ab");
+    }
+
+    ~Leaderboard() {
+        if (log) fclose(log);
+#ifndef _WIN32
+        if (image) munmap(image, IMAGE_SIZE);
+#endif
+    }
+
+    Leaderboard(const Leaderboard&) = delete;
+    Leaderboard& operator=(const Leaderboard&) = delete;
+
+    bool isOpen() { return log != NULL; }
+
+    // Append one finished game; false if the category is unknown or the
+    // log cannot be written
+    bool add(const std::string& name, GameMode mode, MapType map, int difficulty, int score,
+             int64_t when = (int64_t)time(NULL)) {
+        int cat = categoryOf(mode, map, difficulty);
+        if (!log || cat < 0) return false;
+        size_t nameLen = std::min(name.size(), (size_t)255);
+        uint8_t r[RECORD_FIXED + 255] = {(uint8_t)cat, (uint8_t)nameLen};
+        int32_t s = score;
+        memcpy(r + 4, &s, 4);
+        memcpy(r + 8, &when, 8);
+        memcpy(r + 16, name.data(), nameLen);
+        size_t size = RECORD_FIXED + nameLen;
+        uint32_t sum = fnv(r, size - 4);
+        memcpy(r + size - 4, &sum, 4);
+        if (fwrite(r, 1, size, log) != size || fflush(log) != 0) return false;
+
+        header().dirty = 1;
+        apply(cat, name.data(), nameLen, score, when);
+        header().covered += size;
+        header().dirty = 0;
+        saveIndex();
+        return true;
+    }
+
+    // The best min(k, TOP_KEEP) entries, highest first
+    std::vector<LeaderboardEntry> top(GameMode mode, MapType map, int difficulty, int k) {
+        int cat = categoryOf(mode, map, difficulty);
+        if (!image || cat < 0) return {};
+        const Category& c = category(cat);
+        int n = std::min(std::max(k, 0), (int)c.topCount);
+        return std::vector<LeaderboardEntry>(c.top, c.top + n);
+    }
+
+    Standing standing(GameMode mode, MapType map, int difficulty, int score) {
+        Standing s = {1, 0, 0};
+        int cat = categoryOf(mode, map, difficulty);
+        if (!image || cat < 0) return s;
+        const Category& c = category(cat);
+        uint64_t upTo = countUpTo(c, bucketOf(score));
+        s.total = (long long)c.total;
+        s.rank = 1 + (long long)(c.total - upTo);
+        s.percentile = c.total ? 100.0 * upTo / c.total : 0;
+        return s;
+    }
+
+    long long size(GameMode mode, MapType map, int difficulty) {
+        int cat = categoryOf(mode, map, difficulty);
+        return image && cat >= 0 ? (long long)category(cat).total : 0;
+    }
+
+    long long getReplayed() { return replayed; }
+};
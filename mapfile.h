@@ -0,0 +1,114 @@
+#pragma once
+
+// ==========================================
+//        CUSTOM MAP FILES (TEXT GRID)
+// ==========================================
+// One character per cell, one line per row:
+//   '#'  off the map (a wall)
+//   '.'  floor
+//   'X'  obstacle
+//   'S'  floor, and where the snake's head starts (its body hangs
+//        down from there, so the two cells below must be floor too)
+// Lines may end in "\r\n"; a short line is padded with '#' up to the
+// widest one. Without an 'S' the snake starts in the middle.
+//
+// The file is read with a single fread and scanned a row at a time. Any
+// region of floor cut off from the spawn is filled with obstacles (see
+// ObstacleGenerator::sealPockets), so food can never appear where the
+// snake can not go.
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include "engine.h"
+
+// Reads `path` into `out`. Returns false, with the reason in `error`, if
+// the file is missing, empty or has no room for the snake to start.
+// `sealed` (if given) gets the number of cut-off floor cells filled.
+inline bool loadMapFile(const char* path, MapData& out, std::string& error, long long* sealed = NULL) {
+    FILE* f = fopen(path, "rb");
+    if (!f) { error = "cannot open"; return false; }
+    std::vector<char> text;
+    if (fseek(f, 0, SEEK_END) == 0) {
+        long size = ftell(f);
+        if (size > 0) {
+            text.resize((size_t)size);
+            rewind(f);
+            text.resize(fread(text.data(), 1, text.size(), f));
+        }
+    }
+    fclose(f);
+
+    // Row extents first, so the grid is sized once
+    std::vector<std::pair<size_t, size_t>> rows;
+    size_t widest = 0;
+    for (size_t p = 0; p < text.size();) {
+        const char* nl = (const char*)memchr(text.data() + p, '\n', text.size() - p);
+        size_t end = nl ? (size_t)(nl - text.data()) : text.size();
+        size_t len = end - p;
+        if (len && text[end - 1] == '\r') len--;
+        rows.push_back({p, len});
+        widest = std::max(widest, len);
+        p = end + 1;
+    }
+    if (rows.empty() || widest == 0) { error = "empty map"; return false; }
+
+    out.width = (int)widest;
+    out.height = (int)rows.size();
+    out.valid.resize(out.width, out.height);
+    out.valid.clear();
+    out.obstacles.clear();
+    out.obstacles.reserve(std::count(text.begin(), text.end(), 'X'));
+    out.spawn = {out.width / 2, out.height / 2};
+    // 64 cells at a time into bit masks: obstacles are scattered at
+    // random, so a branch per cell would mispredict about as often as
+    // not. The obstacle list is then read off the mask.
+    for (int y = 0; y < out.height; y++) {
+        const char* row = text.data() + rows[y].first;
+        int len = (int)rows[y].second;
+        uint64_t* bits = out.valid.row(y);
+        for (int x0 = 0; x0 < len; x0 += 64) {
+            const char* c = row + x0;
+            int n = std::min(64, len - x0);
+            uint64_t floor = 0, blocked = 0, start = 0;
+            for (int i = 0; i < n; i++) {
+                floor |= (uint64_t)(c[i] != '#') << i; // '.', 'X', 'S' and anything unknown
+                blocked |= (uint64_t)(c[i] == 'X') << i;
+                start |= (uint64_t)(c[i] == 'S') << i;
+            }
+            bits[x0 >> 6] = floor;
+            for (; blocked; blocked &= blocked - 1) out.obstacles.push_back({x0 + lowestBit64(blocked), y});
+            if (start) out.spawn = {x0 + lowestBit64(start), y};
+        }
+    }
+
+    const Point& s = out.spawn;
+    bool room = s.y + 2 < out.height;
+    for (int i = 0; room && i < 3; i++) room = out.valid.test(s.x, s.y + i);
+    for (const Point& p : out.obstacles) room = room && !(p.x == s.x && p.y >= s.y && p.y < s.y + 3);
+    if (!room) { error = "no room for the snake at the spawn"; return false; }
+
+    ObstacleGenerator gen;
+    gen.reset(out.valid, out.obstacles);
+    long long filled = gen.sealPockets(out.spawn, out.obstacles);
+    if (sealed) *sealed = filled;
+    return true;
+}
+
+// Writes `map` in the same format
+inline bool saveMapFile(const char* path, const MapData& map) {
+    std::vector<char> text((size_t)(map.width + 1) * map.height);
+    for (int y = 0; y < map.height; y++) {
+        char* row = &text[(size_t)y * (map.width + 1)];
+        for (int x = 0; x < map.width; x++) row[x] = map.valid.test(x, y) ? '.' : '#';
+        row[map.width] = '\n';
+    }
+    for (const Point& p : map.obstacles) text[(size_t)p.y * (map.width + 1) + p.x] = 'X';
+    if (map.spawn.x >= 0) text[(size_t)map.spawn.y * (map.width + 1) + map.spawn.x] = 'S';
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    bool ok = fwrite(text.data(), 1, text.size(), f) == text.size();
+    return fclose(f) == 0 && ok;
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+// ==========================================
+//      PER-PHASE TICK INSTRUMENTATION
+// ==========================================
+// Code marks a phase with SNAKE_PHASE(PHASE_x) at the top of a scope
+// and bumps counters with SNAKE_COUNT(COUNT_x, n). Both go to the
+// Metrics that a MetricsSession made active on the calling thread; with
+// no session they cost one thread-local load and a branch (the clock is
+// not read and the count expression is not evaluated). Building with
+// SNAKE_METRICS=0 removes them altogether.
+//
+// Phases nest: LOGIC is a whole Game::step, RESPAWN and BFS happen
+// inside it, so their time is part of LOGIC too. INPUT, LOGIC and DRAW
+// are recorded once per tick or frame, RESPAWN and BFS once per call.
+//
+// Allocations are counted by operator new, which a program opts into by
+// putting SNAKE_DEFINE_ALLOCATION_COUNTER() in one of its source files.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <chrono>
+#include "histogram.h"
+
+#ifndef SNAKE_METRICS
+#define SNAKE_METRICS 1
+#endif
+
+enum Phase { PHASE_INPUT = 0, PHASE_LOGIC, PHASE_RESPAWN, PHASE_BFS, PHASE_DRAW, PHASE_COUNT };
+enum Counter { COUNT_ALLOCATIONS = 0, COUNT_BFS_NODES, COUNT_CONSOLE_BYTES, COUNT_COUNT };
+
+struct Metrics {
+    Histogram phases[PHASE_COUNT]; // Nanoseconds
+    long long counters[COUNT_COUNT] = {};
+
+    static const char* phaseName(int p) {
+        static const char* names[] = {"input", "logic", "respawn", "bfs", "draw"};
+        return names[p];
+    }
+    static const char* counterName(int c) {
+        static const char* names[] = {"allocations", "bfs_nodes", "console_bytes"};
+        return names[c];
+    }
+
+    void merge(const Metrics& o) {
+        for (int p = 0; p < PHASE_COUNT; p++) phases[p].merge(o.phases[p]);
+        for (int c = 0; c < COUNT_COUNT; c++) counters[c] += o.counters[c];
+    }
+
+    // One row per phase, then one per counter (only `count` filled in)
+    bool writeCsv(const char* path) const {
+        FILE* f = fopen(path, "w");
+        if (!f) return false;
+        fprintf(f, "kind,name,count,mean_ns,p50_ns,p90_ns,p99_ns,max_ns\n");
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            const Histogram& h = phases[p];
+            fprintf(f, "phase,%s,%llu,%.1f,%llu,%llu,%llu,%llu\n", phaseName(p), (unsigned long long)h.count(),
+                    h.mean(), (unsigned long long)h.percentile(0.50), (unsigned long long)h.percentile(0.90),
+                    (unsigned long long)h.percentile(0.99), (unsigned long long)h.max());
+        }
+        for (int c = 0; c < COUNT_COUNT; c++)
+            fprintf(f, "counter,%s,%lld,,,,,\n", counterName(c), counters[c]);
+        return fclose(f) == 0;
+    }
+
+    bool writeJson(const char* path) const {
+        FILE* f = fopen(path, "w");
+        if (!f) return false;
+        fprintf(f, "{\n  \"phases\": {\n");
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            const Histogram& h = phases[p];
+            fprintf(f, "    \"%s\": {\"count\": %llu, \"mean_ns\": %.1f, \"p50_ns\": %llu, \"p90_ns\": %llu, "
+                       "\"p99_ns\": %llu, \"max_ns\": %llu}%s\n",
+                    phaseName(p), (unsigned long long)h.count(), h.mean(), (unsigned long long)h.percentile(0.50),
+                    (unsigned long long)h.percentile(0.90), (unsigned long long)h.percentile(0.99),
+                    (unsigned long long)h.max(), p + 1 < PHASE_COUNT ? "," : "");
+        }
+        fprintf(f, "  },\n  \"counters\": {\n");
+        for (int c = 0; c < COUNT_COUNT; c++)
+            fprintf(f, "    \"%s\": %lld%s\n", counterName(c), counters[c], c + 1 < COUNT_COUNT ? "," : "");
+        fprintf(f, "  }\n}\n");
+        return fclose(f) == 0;
+    }
+
+    // JSON if the path ends in .json, CSV otherwise
+    bool write(const char* path) const {
+        const char* dot = strrchr(path, '.');
+        return dot && strcmp(dot, ".json") == 0 ? writeJson(path) : writeCsv(path);
+    }
+};
+
+inline thread_local Metrics* activeMetrics = NULL;
+inline thread_local long long threadAllocations = 0; // Bumped by the counting operator new
+
+// Makes `m` the active Metrics on this thread for the session's lifetime;
+// allocations made meanwhile land in its COUNT_ALLOCATIONS
+class MetricsSession {
+private:
+    Metrics& m;
+    Metrics* previous;
+    long long allocStart;
+
+public:
+    explicit MetricsSession(Metrics& m) : m(m), previous(activeMetrics), allocStart(threadAllocations) {
+        activeMetrics = &m;
+    }
+    ~MetricsSession() {
+        m.counters[COUNT_ALLOCATIONS] += threadAllocations - allocStart;
+        activeMetrics = previous;
+    }
+
+    MetricsSession(const MetricsSession&) = delete;
+    MetricsSession& operator=(const MetricsSession&) = delete;
+};
+
+// Times its scope into one phase of the active Metrics
+class PhaseTimer {
+private:
+    Metrics* m;
+    Phase phase;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit PhaseTimer(Phase p) : m(activeMetrics), phase(p) {
+        if (m) start = std::chrono::steady_clock::now();
+    }
+    ~PhaseTimer() {
+        if (m)
+            m->phases[phase].record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                        std::chrono::steady_clock::now() - start).count());
+    }
+};
+
+#if SNAKE_METRICS
+#define SNAKE_METRICS_CAT2(a, b) a##b
+#define SNAKE_METRICS_CAT(a, b) SNAKE_METRICS_CAT2(a, b)
+#define SNAKE_PHASE(p) PhaseTimer SNAKE_METRICS_CAT(phaseTimer_, __LINE__)(p)
+#define SNAKE_COUNT(c, n) do { if (Metrics* m_ = activeMetrics) m_->counters[c] += (n); } while (0)
+#else
+#define SNAKE_PHASE(p) do {} while (0)
+#define SNAKE_COUNT(c, n) do {} while (0)
+#endif
+
+// Replaces the global operator new/delete with ones that count every
+// allocation on the calling thread. Use once per program. (They stay
+// out of line so GCC does not pair an inlined malloc() or free() with
+// the other side's operator.)
+#if defined(__GNUC__)
+#define SNAKE_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define SNAKE_NOINLINE __declspec(noinline)
+#else
+#define SNAKE_NOINLINE
+#endif
+
+#define SNAKE_DEFINE_ALLOCATION_COUNTER()                                                       \
+    SNAKE_NOINLINE void* operator new(std::size_t n) {                                          \
+        threadAllocations++;                                                                    \
+        if (void* p = std::malloc(n ? n : 1)) return p;                                         \
+        throw std::bad_alloc();                                                                 \
+    }                                                                                           \
+    SNAKE_NOINLINE void* operator new[](std::size_t n) { return operator new(n); }              \
+    SNAKE_NOINLINE void operator delete(void* p) noexcept { std::free(p); }                     \
+    SNAKE_NOINLINE void operator delete[](void* p) noexcept { std::free(p); }                   \
+    SNAKE_NOINLINE void operator delete(void* p, std::size_t) noexcept { std::free(p); }        \
+    SNAKE_NOINLINE void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
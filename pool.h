@@ -0,0 +1,89 @@
+#pragma once
+
+// ==========================================
+//      PHASE POOL (PARALLEL FOR PER TICK)
+// ==========================================
+// Persistent workers for work that is split into tasks and run in
+// lockstep, one batch after another: the arena's tick phases and the
+// vectorized environments' steps. run(n, fn) calls fn(task) for every
+// task in [0, n), spread over the workers and the calling thread, and
+// returns once all of them are done. The workers sleep between batches.
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+class PhasePool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable wake, finished;
+    const std::function<void(int)>* job;
+    int tasks;
+    std::atomic<int> nextTask;
+    long long generation;
+    int busy;
+    bool quitting;
+
+    void drain() {
+        for (int t; (t = nextTask.fetch_add(1, std::memory_order_relaxed)) < tasks;) (*job)(t);
+    }
+
+    void loop() {
+        long long seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> l(lock);
+                wake.wait(l, [&] { return quitting || generation != seen; });
+                if (quitting) return;
+                seen = generation;
+            }
+            drain();
+            std::lock_guard<std::mutex> l(lock);
+            if (--busy == 0) finished.notify_one();
+        }
+    }
+
+public:
+    // threads <= 0 means one per hardware thread
+    explicit PhasePool(int threads) : job(NULL), tasks(0), nextTask(0), generation(0), busy(0), quitting(false) {
+        if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+        for (int i = 1; i < threads; i++) workers.emplace_back(&PhasePool::loop, this);
+    }
+
+    ~PhasePool() {
+        {
+            std::lock_guard<std::mutex> l(lock);
+            quitting = true;
+        }
+        wake.notify_all();
+        for (auto& w : workers) w.join();
+    }
+
+    PhasePool(const PhasePool&) = delete;
+    PhasePool& operator=(const PhasePool&) = delete;
+
+    void run(int n, const std::function<void(int)>& fn) {
+        if (workers.empty() || n == 1) {
+            for (int t = 0; t < n; t++) fn(t);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> l(lock);
+            job = &fn;
+            tasks = n;
+            nextTask.store(0, std::memory_order_relaxed);
+            busy = (int)workers.size();
+            generation++;
+        }
+        wake.notify_all();
+        drain();
+        std::unique_lock<std::mutex> l(lock);
+        finished.wait(l, [&] { return busy == 0; });
+    }
+
+    int getThreads() { return (int)workers.size() + 1; }
+};
@@ -0,0 +1,278 @@
+#pragma once
+
+// ==========================================
+//     [DSA CONCEPT: DIFF] FRAME RENDERER
+// ==========================================
+// Keeps two screen buffers: what the terminal shows (front) and what
+// this frame wants (back). Only cells whose glyph or colour actually
+// changed are queued, and the backend emits the whole queue as one
+// batched write. The map's static layer (void, floor, obstacles) is
+// cached once; per tick only the Board's dirty cells (new head, old
+// tail, food) plus the previous head are looked at.
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include "engine.h"
+
+// Colours use the Win32 console attribute numbering (the game's
+// original palette); the ANSI backend translates them.
+struct ScreenCell {
+    char glyph;
+    uint8_t color;
+    bool operator==(const ScreenCell& o) const { return glyph == o.glyph && color == o.color; }
+    bool operator!=(const ScreenCell& o) const { return !(*this == o); }
+};
+
+class RenderBackend {
+public:
+    virtual ~RenderBackend() {}
+    // Emit the `n` listed cells of a `cols`-wide screen in one batch.
+    // `dirty` is sorted row-major. Returns bytes handed to the terminal.
+    virtual size_t flush(const ScreenCell* cells, int cols, int rows, const int* dirty, int n) = 0;
+    // Called once per screen, so flush() can size its buffers up front
+    virtual void reserve(int cols, int rows) { (void)cols; (void)rows; }
+};
+
+// Portable VT/ANSI backend for Linux terminals (and modern Windows
+// consoles). Cursor moves are skipped for runs of adjacent cells and
+// colour codes are only sent when the colour changes. Pass NULL as the
+// stream to just count bytes.
+class AnsiBackend : public RenderBackend {
+private:
+    FILE* out;
+    std::string buf;
+
+    static int ansiColor(uint8_t attr) {
+        // Win32: 1=blue 2=green 4=red 8=bright. ANSI: 1=red 2=green 4=blue
+        int rgb = ((attr & 4) ? 1 : 0) | ((attr & 2) ? 2 : 0) | ((attr & 1) ? 4 : 0);
+        return ((attr & 8) ? 90 : 30) + rgb;
+    }
+
+public:
+    explicit AnsiBackend(FILE* out) : out(out) { buf.reserve(1 << 16); }
+
+    // A full repaint: a cursor move per row, a colour change and a glyph
+    // per cell at worst
+    void reserve(int cols, int rows) override {
+        buf.reserve(std::max(buf.capacity(), (size_t)rows * (12 + (size_t)cols * 6)));
+    }
+
+    size_t flush(const ScreenCell* cells, int cols, int rows, const int* dirty, int n) override {
+        (void)rows;
+        buf.clear();
+        int cursor = -1;   // Screen index the terminal cursor sits on
+        int color = -1;
+        char tmp[32];
+        for (int i = 0; i < n; i++) {
+            int idx = dirty[i];
+            if (idx != cursor) {
+                snprintf(tmp, sizeof(tmp), "\x1b[%d;%dH", idx / cols + 1, idx % cols + 1);
+                buf += tmp;
+            }
+            if (cells[idx].color != color) {
+                color = cells[idx].color;
+                snprintf(tmp, sizeof(tmp), "\x1b[%dm", ansiColor(cells[idx].color));
+                buf += tmp;
+            }
+            buf += cells[idx].glyph;
+            // The terminal wraps at the last column, so only trust the
+            // implicit cursor advance within a row
+            cursor = ((idx + 1) % cols == 0) ? -1 : idx + 1;
+        }
+        if (out && !buf.empty()) {
+            fwrite(buf.data(), 1, buf.size(), out);
+            fflush(out);
+        }
+        return buf.size();
+    }
+};
+
+// The two screen buffers and the diff between them. Subclasses put()
+// this frame's cells, then flushFrame() sends only the changed ones.
+class Screen {
+private:
+    RenderBackend& backend;
+    std::vector<ScreenCell> front; // On the terminal
+    std::vector<ScreenCell> back;  // Wanted this frame
+    std::vector<int> dirty;
+    std::vector<uint8_t> dirtyFlag;
+
+    // Counters
+    long long frames;
+    long long totalBytes;
+    size_t lastBytes;
+    double totalNanos;
+    double lastNanos;
+
+    void mark(int idx) {
+        if (!dirtyFlag[idx]) { dirtyFlag[idx] = 1; dirty.push_back(idx); }
+    }
+
+protected:
+    int cols, rows;
+
+    Screen(RenderBackend& backend, int cols, int rows)
+        : backend(backend), frames(0), totalBytes(0), lastBytes(0), totalNanos(0), lastNanos(0), cols(cols), rows(rows) {
+        back.assign((size_t)cols * rows, ScreenCell{' ', 7});
+        front.assign(back.size(), ScreenCell{0, 0});
+        dirtyFlag.assign(back.size(), 0);
+        dirty.reserve(back.size());
+        backend.reserve(cols, rows);
+    }
+
+    // Send the changed cells as one batch. `t0` is when the frame
+    // started, for the frame time counters.
+    void flushFrame(std::chrono::steady_clock::time_point t0) {
+        // Emit in row-major order so the backend can coalesce runs
+        int n = 0;
+        if (dirty.size() * 8 > back.size()) {
+            dirty.clear();
+            for (size_t i = 0; i < back.size(); i++) if (dirtyFlag[i]) dirty.push_back((int)i);
+        } else {
+            std::sort(dirty.begin(), dirty.end());
+        }
+        for (int idx : dirty) {
+            dirtyFlag[idx] = 0;
+            if (back[idx] != front[idx]) { front[idx] = back[idx]; dirty[n++] = idx; }
+        }
+        lastBytes = backend.flush(back.data(), cols, rows, dirty.data(), n);
+        dirty.clear();
+
+        lastNanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+        frames++;
+        totalBytes += lastBytes;
+        SNAKE_COUNT(COUNT_CONSOLE_BYTES, (long long)lastBytes);
+        totalNanos += lastNanos;
+    }
+
+public:
+    virtual ~Screen() {}
+
+    // Forget what the terminal shows; the next frame repaints all
+    void invalidate() {
+        std::fill(front.begin(), front.end(), ScreenCell{0, 0});
+        for (size_t i = 0; i < back.size(); i++) mark((int)i);
+    }
+
+    void put(int col, int row, char glyph, uint8_t color) {
+        if (col < 0 || col >= cols || row < 0 || row >= rows) return;
+        int idx = row * cols + col;
+        back[idx] = {glyph, color};
+        if (back[idx] != front[idx]) mark(idx);
+    }
+
+    // Returns the column after the text
+    int putText(int col, int row, const std::string& text, uint8_t color) {
+        for (char ch : text) put(col++, row, ch, color);
+        return col;
+    }
+    int putText(int col, int row, const char* text, uint8_t color) {
+        while (*text) put(col++, row, *text++, color);
+        return col;
+    }
+
+    // `count` copies of one glyph; returns the column after them
+    int putRun(int col, int row, char glyph, int count, uint8_t color) {
+        while (count-- > 0) put(col++, row, glyph, color);
+        return col;
+    }
+
+    // A number without building a string; returns the column after it
+    int putNumber(int col, int row, long long n, uint8_t color) {
+        char text[24];
+        snprintf(text, sizeof(text), "%lld", n);
+        return putText(col, row, text, color);
+    }
+
+    void clearRow(int fromCol, int row) {
+        for (int col = fromCol; col < cols; col++) put(col, row, ' ', 7);
+    }
+
+    int getCols() { return cols; }
+    int getRows() { return rows; }
+    long long getFrames() { return frames; }
+    size_t getLastFrameBytes() { return lastBytes; }
+    double getLastFrameNanos() { return lastNanos; }
+    double getAvgFrameBytes() { return frames ? double(totalBytes) / frames : 0; }
+    double getAvgFrameNanos() { return frames ? totalNanos / frames : 0; }
+};
+
+class Renderer : public Screen {
+private:
+    int mapLeft, mapTop; // Screen position of map cell (0, 0)
+    int mapW, mapH;
+    std::vector<ScreenCell> staticLayer; // Void, floor and obstacles
+
+    Point lastHead;
+
+    void drawMapCell(Game& game, int x, int y) {
+        if (x < 0 || x >= mapW || y < 0 || y >= mapH) return;
+        ScreenCell c;
+        switch (game.getBoard()->at(x, y)) {
+            case CELL_BODY: {
+                const Point& h = game.getSnake()->getHead();
+                c = (h.x == x && h.y == y) ? ScreenCell{'O', 10} : ScreenCell{'o', 2};
+                break;
+            }
+            case CELL_FOOD: c = {'@', 13}; break;
+            default: c = staticLayer[y * mapW + x]; break;
+        }
+        put(mapLeft + x, mapTop + y, c.glyph, c.color);
+    }
+
+public:
+    // The HUD takes the two rows above the map; the map is indented one
+    // column. Screens are at least 80 columns so long names still fit.
+    Renderer(Game& game, RenderBackend& backend)
+        : Screen(backend, std::max(1 + game.getMap()->getWidth(), 80), 2 + game.getMap()->getHeight()),
+          mapLeft(1), mapTop(2), mapW(game.getMap()->getWidth()), mapH(game.getMap()->getHeight()),
+          lastHead({-1, -1}) {
+        buildStaticLayer(game);
+    }
+
+    // Cache the parts of the map that never change during a game. Call
+    // again if the map or obstacles are regenerated.
+    void buildStaticLayer(Game& game) {
+        Board* board = game.getBoard();
+        staticLayer.assign((size_t)mapW * mapH, ScreenCell{' ', 7});
+        for (int y = 0; y < mapH; y++) {
+            for (int x = 0; x < mapW; x++) {
+                Cell c = board->at(x, y);
+                if (c == CELL_VOID) staticLayer[y * mapW + x] = {'.', 8};      // Void
+                else if (c == CELL_OBSTACLE) staticLayer[y * mapW + x] = {'X', 4}; // Red Obstacle
+            }
+        }
+        invalidate();
+    }
+
+    // Forget what the terminal shows; the next present() repaints all
+    void invalidate() {
+        Screen::invalidate();
+        lastHead = {-1, -1};
+    }
+
+    // Pull this tick's changes out of the game and write the frame
+    void present(Game& game) {
+        SNAKE_PHASE(PHASE_DRAW);
+        auto t0 = std::chrono::steady_clock::now();
+        Board* board = game.getBoard();
+        bool full = lastHead.x < 0;
+
+        if (full) {
+            for (int y = 0; y < mapH; y++)
+                for (int x = 0; x < mapW; x++)
+                    drawMapCell(game, x, y);
+        } else {
+            for (int idx : board->getDirty()) drawMapCell(game, idx % mapW, idx / mapW);
+            drawMapCell(game, lastHead.x, lastHead.y); // Old head turns into body
+        }
+        board->clearDirty();
+        const Point& h = game.getSnake()->getHead();
+        drawMapCell(game, h.x, h.y);
+        lastHead = h;
+        flushFrame(t0);
+    }
+};
@@ -0,0 +1,549 @@
+#pragma once
+
+// ==========================================
+//   [DSA CONCEPT: RUN-LENGTH] REPLAY FILES
+// ==========================================
+// A replay stores the seed, the game settings and the direction the
+// snake actually moved on every tick; the engine is deterministic, so
+// that is enough to play the game again. Directions are stored as runs:
+// one byte holds a 2-bit direction and a 6-bit tick count, so a straight
+// line of up to 62 ticks costs a single byte. Every `interval` ticks a
+// keyframe with the full game state goes into the stream, and a closing
+// index lists where each one starts: seeking loads the keyframe before
+// the target and simulates at most one interval forward. The writer
+// streams through a small buffer and keeps at most INDEX_CAP index
+// entries, dropping every other one when full (a seek past that point
+// simulates further), so memory stays flat however long the session
+// runs; a file cut short by a crash still plays up to its last complete
+// record.
+//
+// Layout: header | records ... | index | footer
+//   header    "SNKR", version, u32 seed, mode, map, difficulty, u32 interval
+//   run       [dir:2][n:6]   n = 1..62 ticks; n = 63 means 63 + varint more
+//   escape    [op:2][000000] op 0: varint ticks of STOP (before the first
+//                            key), op 1: keyframe (varint size, state),
+//                            op 2: end (varint tick, cause)
+//   index     varint count, (varint tick, varint offset) per keyframe,
+//             varint end tick, cause
+//   footer    u64 index offset, "SNKX"
+
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include "engine.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+struct ReplayHeader {
+    uint32_t seed;
+    GameMode mode;
+    MapType map;
+    int difficulty;
+    int interval; // Ticks between keyframes
+};
+
+struct KeyframeEntry {
+    long long tick;
+    uint64_t offset; // From the start of the file
+};
+
+// Little-endian encoding shared by the writer and the player. The get*
+// functions advance `p` and return false instead of reading past `end`.
+class ReplayCodec {
+public:
+    static const int VERSION = 2; // 2: xoshiro128** generator, 16-byte state
+
+    static void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+        while (v >= 0x80) { out.push_back((uint8_t)(v | 0x80)); v >>= 7; }
+        out.push_back((uint8_t)v);
+    }
+
+    static void putFixed(std::vector<uint8_t>& out, uint64_t v, int bytes) {
+        for (int i = 0; i < bytes; i++) out.push_back((uint8_t)(v >> (8 * i)));
+    }
+
+    static bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+        v = 0;
+        for (int shift = 0; p < end && shift < 64; shift += 7) {
+            uint8_t b = *p++;
+            v |= (uint64_t)(b & 0x7f) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+
+    static bool getFixed(const uint8_t*& p, const uint8_t* end, uint64_t& v, int bytes) {
+        if (end - p < bytes) return false;
+        v = 0;
+        for (int i = 0; i < bytes; i++) v |= (uint64_t)*p++ << (8 * i);
+        return true;
+    }
+
+    // Body segments are 4-neighbours, so after the head each one is a
+    // 2-bit step: left, right, up, down
+    static void putState(std::vector<uint8_t>& out, const GameState& s, const RandomState& rngState) {
+        uint64_t timeBits;
+        memcpy(&timeBits, &s.timeLeft, sizeof(timeBits));
+        putVarint(out, s.ticks);
+        putVarint(out, s.score);
+        putFixed(out, timeBits, 8);
+        for (uint32_t w : rngState.s) putFixed(out, w, 4);
+        out.push_back((uint8_t)s.dir);
+        putVarint(out, s.length);
+        putVarint(out, s.moves);
+        putVarint(out, s.food.x + 1); // -1 when the board is full
+        putVarint(out, s.food.y + 1);
+        putVarint(out, s.body.size());
+        if (s.body.empty()) return;
+        putVarint(out, s.body[0].x);
+        putVarint(out, s.body[0].y);
+        uint8_t packed = 0;
+        int n = 0;
+        for (size_t i = 1; i < s.body.size(); i++) {
+            int dx = s.body[i].x - s.body[i - 1].x, dy = s.body[i].y - s.body[i - 1].y;
+            int step = dx < 0 ? 0 : dx > 0 ? 1 : dy < 0 ? 2 : 3;
+            packed |= step << (2 * n);
+            if (++n == 4) { out.push_back(packed); packed = 0; n = 0; }
+        }
+        if (n) out.push_back(packed);
+    }
+
+    static bool getState(const uint8_t*& p, const uint8_t* end, GameState& s, RandomState& rngState) {
+        uint64_t v[9];
+        if (!getVarint(p, end, v[0]) || !getVarint(p, end, v[1]) || !getFixed(p, end, v[2], 8)) return false;
+        for (uint32_t& w : rngState.s) {
+            if (!getFixed(p, end, v[3], 4)) return false;
+            w = (uint32_t)v[3];
+        }
+        if (p >= end || *p > DOWN) return false;
+        s.ticks = (long long)v[0];
+        s.score = (int)v[1];
+        memcpy(&s.timeLeft, &v[2], sizeof(s.timeLeft));
+        s.dir = (Direction)*p++;
+        for (int i = 4; i < 9; i++) if (!getVarint(p, end, v[i])) return false;
+        s.length = (int)v[4];
+        s.moves = (long long)v[5];
+        s.food = {(int)v[6] - 1, (int)v[7] - 1};
+        size_t count = (size_t)v[8];
+        s.body.clear();
+        if (count == 0) return true;
+        uint64_t hx, hy;
+        if (!getVarint(p, end, hx) || !getVarint(p, end, hy)) return false;
+        if (count - 1 > (size_t)(end - p) * 4) return false; // 2 bits per step after the head
+        Point cur = {(int)hx, (int)hy};
+        s.body.push_back(cur);
+        for (size_t i = 1; i < count; i++) {
+            int step = (p[(i - 1) / 4] >> (2 * ((i - 1) % 4))) & 3;
+            if (step == 0) cur.x--;
+            else if (step == 1) cur.x++;
+            else if (step == 2) cur.y--;
+            else cur.y++;
+            s.body.push_back(cur);
+        }
+        p += (count - 1 + 3) / 4;
+        return true;
+    }
+};
+
+// Appends one game to a file as it is played. Build the Game from
+// SeededRandom(seed) and create the writer before the first step();
+// then call record() after every step().
+class ReplayWriter {
+private:
+    static const size_t FLUSH_AT = 4096;
+    static const size_t INDEX_CAP = 1024; // Half a million ticks at the default interval before thinning
+
+    FILE* out;
+    Game& game;
+    SeededRandom& rng;
+    int interval;
+
+    std::vector<uint8_t> buf; // Bytes not yet handed to the file
+    uint64_t offset;          // File offset of buf[0]
+    std::vector<KeyframeEntry> index;
+
+    Direction runDir;
+    long long runLen;
+    GameState scratch;
+    std::vector<uint8_t> stateBuf;
+
+    void flushBuf() {
+        if (!buf.empty()) fwrite(buf.data(), 1, buf.size(), out);
+        offset += buf.size();
+        buf.clear();
+    }
+
+    void flushRun() {
+        if (runLen == 0) return;
+        if (runDir == STOP) {
+            buf.push_back(0x00);
+            ReplayCodec::putVarint(buf, runLen);
+        } else {
+            uint8_t code = (uint8_t)((runDir - LEFT) << 6);
+            if (runLen < 63) {
+                buf.push_back(code | (uint8_t)runLen);
+            } else {
+                buf.push_back(code | 63);
+                ReplayCodec::putVarint(buf, runLen - 63);
+            }
+        }
+        runLen = 0;
+    }
+
+    void keyframe() {
+        flushRun();
+        game.saveState(scratch);
+        stateBuf.clear();
+        ReplayCodec::putState(stateBuf, scratch, rng.getState());
+        if (index.size() == INDEX_CAP) {
+            // Keep every other entry, in place: the index never outgrows
+            // its reserve, and the keyframes themselves stay in the file
+            for (size_t i = 0; i < INDEX_CAP / 2; i++) index[i] = index[2 * i];
+            index.resize(INDEX_CAP / 2);
+        }
+        index.push_back({game.getTicks(), offset + buf.size()});
+        buf.push_back(0x40);
+        ReplayCodec::putVarint(buf, stateBuf.size());
+        buf.insert(buf.end(), stateBuf.begin(), stateBuf.end());
+    }
+
+public:
+    ReplayWriter(const char* path, Game& game, SeededRandom& rng, uint32_t seed, int interval = 512)
+        : game(game), rng(rng), interval(interval < 1 ? 1 : interval), offset(0), runDir(STOP), runLen(0) {
+        out = fopen(path, "wb");
+        if (!out) return;
+        // Sized up front so record() never allocates: a keyframe is at
+        // most a few dozen bytes plus two bits per body cell
+        size_t cells = (size_t)game.getBoard()->getWidth() * game.getBoard()->getHeight();
+        scratch.body.reserve(cells);
+        stateBuf.reserve(64 + cells / 4);
+        buf.reserve(std::max(FLUSH_AT * 2, FLUSH_AT + 80 + cells / 4));
+        index.reserve(INDEX_CAP);
+        buf.insert(buf.end(), {'S', 'N', 'K', 'R', (uint8_t)ReplayCodec::VERSION});
+        ReplayCodec::putFixed(buf, seed, 4);
+        buf.push_back((uint8_t)game.getMode());
+        buf.push_back((uint8_t)game.getMapType());
+        buf.push_back((uint8_t)game.getDifficulty());
+        ReplayCodec::putFixed(buf, this->interval, 4);
+        keyframe();
+    }
+
+    ~ReplayWriter() { finish(); }
+
+    ReplayWriter(const ReplayWriter&) = delete;
+    ReplayWriter& operator=(const ReplayWriter&) = delete;
+
+    bool isOpen() { return out != NULL; }
+
+    // O(1) unless a keyframe is due
+    void record() {
+        if (!out) return;
+        Direction d = game.getSnake()->getDirection();
+        if (d != runDir) flushRun();
+        runDir = d;
+        runLen++;
+        if (!game.isOver() && game.getTicks() % interval == 0) keyframe();
+        if (buf.size() >= FLUSH_AT) flushBuf();
+    }
+
+    // The game jumped back (a rewind, a resumed snapshot): record its
+    // state as a keyframe, which playback loads like any other, and drop
+    // the index entries for ticks that will now be played again
+    void resync() {
+        if (!out) return;
+        while (!index.empty() && index.back().tick >= game.getTicks()) index.pop_back();
+        keyframe();
+    }
+
+    // Writes the end record and the index, then closes the file. An
+    // unfinished game is recorded as ending ALIVE at its current tick.
+    void finish() {
+        if (!out) return;
+        flushRun();
+        DeathCause cause = game.isOver() ? game.getDeathCause() : ALIVE;
+        buf.push_back(0x80);
+        ReplayCodec::putVarint(buf, game.getTicks());
+        buf.push_back((uint8_t)cause);
+
+        uint64_t indexAt = offset + buf.size();
+        ReplayCodec::putVarint(buf, index.size());
+        for (const KeyframeEntry& k : index) {
+            ReplayCodec::putVarint(buf, k.tick);
+            ReplayCodec::putVarint(buf, k.offset);
+        }
+        ReplayCodec::putVarint(buf, game.getTicks());
+        buf.push_back((uint8_t)cause);
+        ReplayCodec::putFixed(buf, indexAt, 8);
+        buf.insert(buf.end(), {'S', 'N', 'K', 'X'});
+        flushBuf();
+        fclose(out);
+        out = NULL;
+    }
+
+    uint64_t getBytes() { return offset + buf.size(); }
+    int getKeyframes() { return (int)index.size(); }
+};
+
+// Read-only bytes of a whole file: memory-mapped where the platform
+// has mmap, otherwise read in one go
+class MappedFile {
+private:
+    const uint8_t* bytes;
+    size_t length;
+#ifdef _WIN32
+    std::vector<uint8_t> copy;
+#else
+    void* mapping;
+#endif
+
+public:
+    explicit MappedFile(const char* path) : bytes(NULL), length(0) {
+#ifdef _WIN32
+        FILE* f = fopen(path, "rb");
+        if (!f) return;
+        fseek(f, 0, SEEK_END);
+        long n = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        if (n > 0) {
+            copy.resize((size_t)n);
+            length = fread(copy.data(), 1, copy.size(), f);
+            bytes = copy.data();
+        }
+        fclose(f);
+#else
+        mapping = MAP_FAILED;
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) {
+                bytes = (const uint8_t*)mapping;
+                length = (size_t)st.st_size;
+            }
+        }
+        close(fd);
+#endif
+    }
+
+    ~MappedFile() {
+#ifndef _WIN32
+        if (mapping != MAP_FAILED) munmap(mapping, length);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+};
+
+// Plays a replay file back through a private Game. TIME_ATTACK runs on
+// game time (one tick period per step), as it does when recorded; the
+// player still never lets the timer end the game early, so the end
+// record alone decides when and how the game finishes. A game that timed
+// out runs its last tick out of time, so that tick ends as recorded.
+class ReplayPlayer {
+private:
+    static const size_t HEADER_SIZE = 16;
+
+    MappedFile file;
+    ReplayHeader header;
+    const uint8_t* base;
+    const uint8_t* recordsEnd;
+    std::vector<KeyframeEntry> index;
+
+    SeededRandom rng;
+    ManualClock clock;
+    Game* game;
+
+    const uint8_t* cur; // Next record
+    Direction runDir;
+    long long runLeft;
+    bool ended;
+    long long endTick;
+    DeathCause endCause;
+    GameState scratch;
+
+    bool readHeader() {
+        if (file.size() < HEADER_SIZE || memcmp(base, "SNKR", 4) != 0 || base[4] != ReplayCodec::VERSION)
+            return false;
+        const uint8_t* p = base + 5;
+        uint64_t seed, interval;
+        ReplayCodec::getFixed(p, base + HEADER_SIZE, seed, 4);
+        header.seed = (uint32_t)seed;
+        header.mode = (GameMode)*p++;
+        header.map = (MapType)*p++;
+        header.difficulty = *p++;
+        ReplayCodec::getFixed(p, base + HEADER_SIZE, interval, 4);
+        header.interval = (int)interval;
+        return header.mode >= CLASSIC && header.mode <= TIME_ATTACK &&
+               header.map >= RECTANGLE && header.map <= TRIANGLE && header.interval > 0;
+    }
+
+    // Use the closing index if the file has one; otherwise walk the
+    // records once (a recording that never got to finish())
+    void loadIndex() {
+        const uint8_t* fileEnd = base + file.size();
+        recordsEnd = fileEnd;
+        if (file.size() >= HEADER_SIZE + 12 && memcmp(fileEnd - 4, "SNKX", 4) == 0) {
+            const uint8_t* p = fileEnd - 12;
+            uint64_t at, count, tick, off, cause;
+            ReplayCodec::getFixed(p, fileEnd, at, 8);
+            p = base + at;
+            bool ok = at >= HEADER_SIZE && at < file.size() - 12 && ReplayCodec::getVarint(p, fileEnd, count);
+            for (uint64_t i = 0; ok && i < count; i++) {
+                ok = ReplayCodec::getVarint(p, fileEnd, tick) && ReplayCodec::getVarint(p, fileEnd, off) &&
+                     off >= HEADER_SIZE && off < at;
+                if (ok) index.push_back({(long long)tick, off});
+            }
+            ok = ok && ReplayCodec::getVarint(p, fileEnd, tick) && ReplayCodec::getFixed(p, fileEnd, cause, 1) &&
+                 cause <= WON;
+            if (ok) {
+                recordsEnd = base + at;
+                endTick = (long long)tick;
+                endCause = (DeathCause)cause;
+                return;
+            }
+            index.clear();
+        }
+
+        const uint8_t* p = base + HEADER_SIZE;
+        while (p < fileEnd) {
+            const uint8_t* rec = p;
+            uint8_t b = *p++;
+            uint64_t v, cause;
+            int op = b >> 6, n = b & 63;
+            if (n == 63 || (n == 0 && op == 0)) {
+                if (!ReplayCodec::getVarint(p, fileEnd, v)) break;
+            } else if (n == 0 && op == 1) {
+                GameState s;
+                RandomState r;
+                if (!ReplayCodec::getVarint(p, fileEnd, v) || (uint64_t)(fileEnd - p) < v) break;
+                const uint8_t* body = p;
+                if (!ReplayCodec::getState(body, p + v, s, r)) break;
+                index.push_back({s.ticks, (uint64_t)(rec - base)});
+                p += v;
+            } else if (n == 0 && op == 2) {
+                if (!ReplayCodec::getVarint(p, fileEnd, v) || !ReplayCodec::getFixed(p, fileEnd, cause, 1) ||
+                    cause > WON) break;
+                endTick = (long long)v;
+                endCause = (DeathCause)cause;
+                break;
+            } else if (n == 0) {
+                break;
+            }
+        }
+        recordsEnd = p;
+    }
+
+    // Decode one record. Returns false at the end record, the end of the
+    // data, or anything malformed.
+    bool nextRecord() {
+        if (cur >= recordsEnd) return false;
+        uint8_t b = *cur++;
+        int op = b >> 6, n = b & 63;
+        uint64_t v;
+        if (n > 0) {
+            runDir = (Direction)(LEFT + op);
+            runLeft = n;
+            if (n == 63) {
+                if (!ReplayCodec::getVarint(cur, recordsEnd, v)) return false;
+                runLeft += (long long)v;
+            }
+            return true;
+        }
+        if (op == 0) {
+            if (!ReplayCodec::getVarint(cur, recordsEnd, v)) return false;
+            runDir = STOP;
+            runLeft = (long long)v;
+            return true;
+        }
+        if (op == 1) {
+            RandomState r;
+            if (!ReplayCodec::getVarint(cur, recordsEnd, v) || (uint64_t)(recordsEnd - cur) < v) return false;
+            const uint8_t* p = cur;
+            cur += v;
+            if (!ReplayCodec::getState(p, cur, scratch, r) || !game->fitsState(scratch, game->getObstacles())) return false;
+            game->loadState(scratch);
+            rng.setState(r);
+            return true;
+        }
+        if (op == 2) {
+            ended = true;
+            if (endCause != ALIVE) game->forceEnd(endCause);
+        }
+        return false;
+    }
+
+public:
+    explicit ReplayPlayer(const char* path)
+        : file(path), header(), base(file.data()), recordsEnd(base), rng(1), game(NULL), cur(NULL),
+          runDir(STOP), runLeft(0), ended(false), endTick(-1), endCause(ALIVE) {
+        if (!base || !readHeader()) return;
+        loadIndex();
+        if (index.empty()) return;
+        rng = SeededRandom(header.seed);
+        game = new Game(header.mode, header.map, header.difficulty, rng, clock);
+        seek(0);
+    }
+
+    ~ReplayPlayer() { delete game; }
+
+    ReplayPlayer(const ReplayPlayer&) = delete;
+    ReplayPlayer& operator=(const ReplayPlayer&) = delete;
+
+    bool isOpen() { return game != NULL; }
+    const ReplayHeader& getHeader() { return header; }
+    Game& getGame() { return *game; }
+
+    // Advance one recorded tick; false once the recording is over
+    bool step() {
+        if (!game || game->isOver()) return false;
+        while (runLeft == 0) {
+            if (!nextRecord()) return false;
+        }
+        // Recorded ticks were not exactly a period apart: hold the timer
+        // above zero until the tick the recording timed out on, then spend
+        // all that is left so the snake moves and stops short of eating
+        double dt = game->getTickPeriodMs() / 1000.0;
+        if (game->getMode() == TIME_ATTACK) {
+            if (endCause == TIME_OUT && game->getTicks() + 1 == endTick) dt += game->getTimeLeft();
+            else if (game->getTimeLeft() <= dt) dt = 0;
+        }
+        clock.advance(dt);
+        game->step(runDir);
+        runLeft--;
+        return true;
+    }
+
+    // Jump to the state after `tick` ticks: load the nearest keyframe at
+    // or before it, then simulate the rest. False if the recording ends
+    // first (the game is then at its last tick).
+    bool seek(long long tick) {
+        if (!game) return false;
+        size_t k = std::upper_bound(index.begin(), index.end(), tick,
+                                    [](long long t, const KeyframeEntry& e) { return t < e.tick; }) - index.begin();
+        if (k > 0) k--;
+        cur = base + index[k].offset;
+        runLeft = 0;
+        ended = false;
+        if (!nextRecord()) return false; // The keyframe itself
+        while (game->getTicks() < tick && step()) {}
+        return game->getTicks() == tick;
+    }
+
+    // Known up front when the file was finished properly, otherwise -1
+    long long getEndTick() { return endTick; }
+    DeathCause getEndCause() { return endCause; }
+    bool isEnded() { return ended; }
+    int getKeyframes() { return (int)index.size(); }
+    size_t getFileBytes() { return file.size(); }
+};
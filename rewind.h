@@ -0,0 +1,173 @@
+#pragma once
+
+// ==========================================
+//   [DSA CONCEPT: UNDO LOG] SNAPSHOTS & REWIND
+// ==========================================
+// Two ways back to an earlier game:
+//   Snapshot  the complete state (settings, obstacles, body, direction,
+//             food, score, TIME_ATTACK timer, generator state). Taking
+//             or restoring one copies the body; saveSnapshot() and
+//             loadSnapshot() put one on disk so a session can resume in
+//             another run, in a Game built from the snapshot's settings.
+//   Rewinder  steps the game and keeps each tick's TickDelta (the cell
+//             the head took, the tail cell it dropped, where the food
+//             was, the generator state) in a ring of the last `capacity`
+//             ticks. rewind(n) takes back n ticks at O(1) each, with no
+//             full copies. A Rewinder owns the history of its game:
+//             changing the game behind its back (loadState, a snapshot)
+//             needs a clear() first.
+//
+// Snapshot file: "SNKS", version u8, mode u8, map u8, difficulty u8,
+// u32 seed, varint width, height, obstacle count, (x, y) per obstacle,
+// then the game state as replay keyframes encode it (putState).
+
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include "engine.h"
+#include "replay.h"
+
+struct Snapshot {
+    uint32_t seed; // The game's starting seed, if the caller knows it (replays need it)
+    GameMode mode;
+    MapType map;
+    int difficulty;
+    int width, height;
+    std::vector<Point> obstacles;
+    GameState state;
+    RandomState rngState;
+};
+
+inline void takeSnapshot(Game& game, SeededRandom& rng, uint32_t seed, Snapshot& s) {
+    s.seed = seed;
+    s.mode = game.getMode();
+    s.map = game.getMapType();
+    s.difficulty = game.getDifficulty();
+    s.width = game.getBoard()->getWidth();
+    s.height = game.getBoard()->getHeight();
+    s.obstacles = game.getObstacles();
+    game.saveState(s.state);
+    s.rngState = rng.getState();
+}
+
+// `game` must have the snapshot's mode, map, difficulty and size, and
+// the state must fit it with the snapshot's obstacles (Game::fitsState);
+// false (and the game untouched) if not. The body goes down before the
+// obstacles move, so neither lands on the other's old cells.
+inline bool restoreSnapshot(Game& game, SeededRandom& rng, const Snapshot& s) {
+    Board* board = game.getBoard();
+    if (s.mode != game.getMode() || s.map != game.getMapType() || s.difficulty != game.getDifficulty() ||
+        s.width != board->getWidth() || s.height != board->getHeight() || !game.fitsState(s.state, s.obstacles))
+        return false;
+    game.loadState(s.state);
+    game.setObstacles(s.obstacles);
+    rng.setState(s.rngState);
+    return true;
+}
+
+inline bool saveSnapshot(const char* path, const Snapshot& s) {
+    std::vector<uint8_t> out = {'S', 'N', 'K', 'S', 2, (uint8_t)s.mode, (uint8_t)s.map, (uint8_t)s.difficulty};
+    ReplayCodec::putFixed(out, s.seed, 4);
+    ReplayCodec::putVarint(out, s.width);
+    ReplayCodec::putVarint(out, s.height);
+    ReplayCodec::putVarint(out, s.obstacles.size());
+    for (const Point& p : s.obstacles) {
+        ReplayCodec::putVarint(out, p.x);
+        ReplayCodec::putVarint(out, p.y);
+    }
+    ReplayCodec::putState(out, s.state, s.rngState);
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    bool ok = fwrite(out.data(), 1, out.size(), f) == out.size();
+    return fclose(f) == 0 && ok;
+}
+
+inline bool loadSnapshot(const char* path, Snapshot& s) {
+    MappedFile file(path);
+    const uint8_t* p = file.data();
+    const uint8_t* end = p + file.size();
+    if (file.size() < 8 || memcmp(p, "SNKS", 4) != 0 || p[4] != 2) return false;
+    s.mode = (GameMode)p[5];
+    s.map = (MapType)p[6];
+    s.difficulty = p[7];
+    if (s.mode < CLASSIC || s.mode > TIME_ATTACK || s.map < RECTANGLE || s.map > TRIANGLE || s.difficulty < 1 ||
+        s.difficulty > 3) return false;
+    p += 8;
+    uint64_t seed, w, h, n;
+    if (!ReplayCodec::getFixed(p, end, seed, 4) || !ReplayCodec::getVarint(p, end, w) ||
+        !ReplayCodec::getVarint(p, end, h) || !ReplayCodec::getVarint(p, end, n) || w < 1 || h < 1 ||
+        w > 0xffff || h > 0xffff || n > w * h) return false;
+    s.seed = (uint32_t)seed;
+    s.width = (int)w;
+    s.height = (int)h;
+    s.obstacles.clear();
+    for (uint64_t i = 0; i < n; i++) {
+        uint64_t x, y;
+        if (!ReplayCodec::getVarint(p, end, x) || !ReplayCodec::getVarint(p, end, y) || x >= w || y >= h)
+            return false;
+        s.obstacles.push_back({(int)x, (int)y});
+    }
+    // Everything on the grid; restoreSnapshot() checks it against the map
+    if (!ReplayCodec::getState(p, end, s.state, s.rngState) || s.state.body.empty() || s.state.body.size() > w * h)
+        return false;
+    for (const Point& b : s.state.body)
+        if ((unsigned)b.x >= w || (unsigned)b.y >= h) return false;
+    const Point& f = s.state.food;
+    return (f.x == -1 && f.y == -1) || ((unsigned)f.x < w && (unsigned)f.y < h);
+}
+
+class Rewinder {
+private:
+    Game& game;
+    SeededRandom& rng;
+    std::vector<TickDelta> ring;
+    size_t newest; // Slot after the most recent delta
+    size_t count;
+
+public:
+    // Keeps the last `capacity` ticks
+    Rewinder(Game& game, SeededRandom& rng, size_t capacity)
+        : game(game), rng(rng), ring(capacity ? capacity : 1), newest(0), count(0) {}
+
+    // Game::step(turn), remembering how to take it back
+    StepResult step(Direction turn) {
+        Snake* snake = game.getSnake();
+        Food* food = game.getFood();
+        TickDelta& d = ring[newest];
+        d.tail = snake->getTail();
+        d.food = {food->x, food->y};
+        d.timeLeft = game.getTimeLeft();
+        d.rngState = rng.getState();
+        d.score = game.getScore();
+        d.length = snake->getLength();
+        d.dir = snake->getDirection();
+        int before = snake->getBody().size();
+        long long moves = snake->getMoveCount();
+        long long ticks = game.getTicks();
+
+        StepResult r = game.step(turn);
+        if (game.getTicks() == ticks) return r; // Already over: nothing to take back
+
+        d.moved = snake->getMoveCount() != moves;
+        d.tailLeft = d.moved && snake->getBody().size() == before;
+        d.hit = snake->getLastHit();
+        newest = (newest + 1) % ring.size();
+        if (count < ring.size()) count++;
+        return r;
+    }
+
+    // Take back up to `n` ticks; returns how many were
+    long long rewind(long long n) {
+        long long done = 0;
+        for (; done < n && count > 0; done++) {
+            newest = (newest == 0 ? ring.size() : newest) - 1;
+            count--;
+            game.undo(ring[newest]);
+            rng.setState(ring[newest].rngState);
+        }
+        return done;
+    }
+
+    void clear() { count = 0; }
+    long long available() { return (long long)count; }
+};
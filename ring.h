@@ -0,0 +1,43 @@
+#pragma once
+
+// ==========================================
+//    [DSA CONCEPT: SPSC RING] LOCK-FREE RING
+// ==========================================
+// The hand-off between one thread that produces small events and one
+// that consumes them: keys from the input reader to the tick, sounds
+// from the tick to the audio worker. Neither side ever waits.
+
+#include <atomic>
+#include <cstdint>
+
+// One writer thread, one reader thread, no locks. Head and tail sit on
+// their own cache lines so the two sides do not false-share.
+template <class T, int N>
+class SpscRing {
+private:
+    static_assert((N & (N - 1)) == 0, "ring size must be a power of two");
+    alignas(64) std::atomic<uint32_t> head; // Next slot to read, consumer-owned
+    alignas(64) std::atomic<uint32_t> tail; // Next slot to write, producer-owned
+    alignas(64) T items[N];
+
+public:
+    SpscRing() : head(0), tail(0) {}
+
+    // Producer side; false when full
+    bool push(const T& v) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == (uint32_t)N) return false;
+        items[t & (N - 1)] = v;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; false when empty
+    bool pop(T& v) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        v = items[h & (N - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+};
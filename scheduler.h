@@ -0,0 +1,144 @@
+#pragma once
+
+// ==========================================
+//      FIXED-TIMESTEP TICK SCHEDULER
+// ==========================================
+// Ticks are due at start + k * period on the monotonic steady clock.
+// Deadlines are absolute, so a late tick does not push the later ones
+// back: the loop runs ticks until it is caught up (up to MAX_CATCH_UP
+// per pass) and frames at their own rate in between. Waiting is a
+// hybrid: sleep until shortly before the next deadline, then spin. The
+// margin tracks how far the OS has recently overslept, so it stays
+// tight on a quiet machine and widens on a busy one (or on Windows'
+// coarse timer). Every tick's start time feeds the timing stats, so
+// jitter and overruns can be read back after a run.
+
+#include <chrono>
+#include <thread>
+#include <cmath>
+#include <algorithm>
+
+struct TimingStats {
+    long long ticks = 0;
+    long long frames = 0;
+    long long overruns = 0; // Ticks that started a full period or more late
+    long long dropped = 0;  // Ticks given up after falling too far behind
+
+    // Lateness: how far past its deadline a tick started
+    double sumLate = 0, maxLate = 0;
+    // Jitter: |time between consecutive tick starts - period|
+    double sumJitter = 0, sumJitterSq = 0, maxJitter = 0;
+    long long intervals = 0;
+
+    double avgLate() const { return ticks ? sumLate / ticks : 0; }
+    double avgJitter() const { return intervals ? sumJitter / intervals : 0; }
+    double rmsJitter() const { return intervals ? std::sqrt(sumJitterSq / intervals) : 0; }
+};
+
+// The hybrid wait on its own (the session server waits the same way)
+class DeadlineWaiter {
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::duration slack; // Recent worst oversleep
+
+public:
+    DeadlineWaiter() : slack(std::chrono::milliseconds(1)) {}
+
+    void waitUntil(Clock::time_point t) {
+        for (;;) {
+            Clock::time_point now = Clock::now();
+            if (now >= t) return;
+            Clock::duration margin = slack + std::chrono::microseconds(200);
+            if (t - now > margin) {
+                Clock::duration ask = t - now - margin;
+                std::this_thread::sleep_for(ask);
+                Clock::duration over = Clock::now() - now - ask;
+                // Rise at once, decay slowly
+                slack = over > slack ? over : slack - (slack - over) / 8;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+};
+
+class TickScheduler {
+private:
+    typedef std::chrono::steady_clock Clock;
+    typedef Clock::time_point Time;
+
+    static constexpr int MAX_CATCH_UP = 5; // Ticks run back to back before a frame
+    static constexpr int MAX_BEHIND = 25;  // Periods behind before giving up on them
+
+    Clock::duration tickPeriod;
+    Clock::duration framePeriod;
+    DeadlineWaiter waiter;
+    TimingStats stats;
+    Time lastTick;
+
+    static double seconds(Clock::duration d) { return std::chrono::duration<double>(d).count(); }
+
+    void noteTick(Time due, Time now) {
+        double late = seconds(now - due);
+        stats.ticks++;
+        stats.sumLate += late;
+        stats.maxLate = std::max(stats.maxLate, late);
+        if (now - due >= tickPeriod) stats.overruns++;
+        if (stats.ticks > 1) {
+            double j = std::fabs(seconds(now - lastTick) - seconds(tickPeriod));
+            stats.intervals++;
+            stats.sumJitter += j;
+            stats.sumJitterSq += j * j;
+            stats.maxJitter = std::max(stats.maxJitter, j);
+        }
+        lastTick = now;
+    }
+
+public:
+    // A frame rate of 0 draws once after every tick
+    TickScheduler(double tickSeconds, double framesPerSecond)
+        : tickPeriod(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(tickSeconds))),
+          framePeriod(framesPerSecond > 0
+                          ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / framesPerSecond))
+                          : Clock::duration::zero()) {}
+
+    // Call tick() at the fixed rate and frame() at the frame rate until
+    // tick() returns false. The first tick is due right away.
+    template <class Tick, class Frame>
+    void run(Tick tick, Frame frame) {
+        Time nextTick = Clock::now();
+        Time nextFrame = nextTick + framePeriod;
+        bool running = true;
+        frame();
+        stats.frames++;
+        while (running) {
+            Time now = Clock::now();
+            int ran = 0;
+            for (; running && ran < MAX_CATCH_UP && now >= nextTick; ran++) {
+                noteTick(nextTick, now);
+                running = tick();
+                nextTick += tickPeriod;
+                now = Clock::now();
+            }
+            if (now - nextTick > MAX_BEHIND * tickPeriod) {
+                // Stalled (debugger, suspended console): skip, don't replay
+                long long behind = (now - nextTick) / tickPeriod;
+                stats.dropped += behind;
+                nextTick += behind * tickPeriod;
+            }
+
+            bool perTick = framePeriod == Clock::duration::zero();
+            if (!running || (perTick ? ran > 0 : now >= nextFrame)) {
+                frame();
+                stats.frames++;
+                nextFrame += framePeriod;
+                if (nextFrame <= now) nextFrame = now + framePeriod;
+            }
+            if (running) waiter.waitUntil(perTick ? nextTick : std::min(nextTick, nextFrame));
+        }
+    }
+
+    const TimingStats& getStats() { return stats; }
+    double getTickSeconds() { return seconds(tickPeriod); }
+};
@@ -0,0 +1,942 @@
+#pragma once
+
+// ==========================================
+//  [DSA CONCEPT: TIMER WHEEL] SESSION SERVER
+// ==========================================
+// One process hosting thousands of games at once, each ticking at its
+// own difficulty's rate. Instead of a thread and a sleep per game, a
+// hierarchical timer wheel holds every session's next deadline: a driver
+// thread wakes once per millisecond, takes the sessions whose slot came
+// up, ticks them on a PhasePool and files each one under its next
+// deadline. Filing and expiring are O(1) per session however many there
+// are; a deadline more than 64 ms out is filed coarsely and moved down a
+// level when its slot comes round.
+//
+// Clients connect over a Unix-domain stream socket (see ServerWire):
+// they join with the game settings and send turns, and get back one
+// frame per tick with the cells the Board retagged that tick, or the
+// whole board (a keyframe) after joining or after a dropped frame. A
+// client that reads too slowly never holds up a tick: while its socket
+// is full its frames are dropped, and the next one that fits is a
+// keyframe. Bot sessions, steered by a Controller instead of a socket,
+// put load on the server for measurements and restart when they die.
+//
+// Every tick's lateness (when it started minus its deadline) goes into
+// a histogram. Sockets make this POSIX only; the console game does not
+// use it.
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include "engine.h"
+#include "batch.h"
+#include "pool.h"
+#include "ring.h"
+#include "input.h"
+#include "histogram.h"
+#include "scheduler.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Timers are ids in [0, capacity) and time is a tick count (milliseconds
+// for the server). Level L has 64 slots of 64^L ticks each; a timer sits
+// at the lowest level whose span covers its distance from now. The slot
+// lists are linked through arrays, so nothing allocates after the wheel
+// is built.
+class TimerWheel {
+public:
+    static const int SLOT_BITS = 6;
+    static const int SLOTS = 1 << SLOT_BITS;
+    static const int LEVELS = 4; // 2^24 ticks; anything further waits in the top level
+
+private:
+    struct Timer {
+        uint64_t due;
+        int next, prev; // Neighbours in its slot's list
+        int slot;       // level * SLOTS + index, -1 when not scheduled
+    };
+
+    std::vector<Timer> timers;
+    int heads[LEVELS * SLOTS];
+    uint64_t now;
+    int scheduled;
+
+    void link(int id) {
+        Timer& t = timers[id];
+        uint64_t delta = t.due - now;
+        int level = 0;
+        while (level < LEVELS - 1 && delta >> (SLOT_BITS * (level + 1))) level++;
+        // Beyond the top level's span: park in the last slot it reaches
+        uint64_t at = delta >> (SLOT_BITS * LEVELS) ? now + ((uint64_t)1 << (SLOT_BITS * LEVELS)) - 1 : t.due;
+        int s = level * SLOTS + (int)((at >> (SLOT_BITS * level)) & (SLOTS - 1));
+        t.slot = s;
+        t.prev = -1;
+        t.next = heads[s];
+        if (heads[s] >= 0) timers[heads[s]].prev = id;
+        heads[s] = id;
+    }
+
+    void unlink(int id) {
+        Timer& t = timers[id];
+        if (t.prev >= 0) timers[t.prev].next = t.next;
+        else heads[t.slot] = t.next;
+        if (t.next >= 0) timers[t.next].prev = t.prev;
+        t.slot = -1;
+    }
+
+    // The current slot of `level` has come round: refile its timers,
+    // which are all due within that slot's span, further down
+    void cascade(int level) {
+        int s = level * SLOTS + (int)((now >> (SLOT_BITS * level)) & (SLOTS - 1));
+        int id = heads[s];
+        heads[s] = -1;
+        while (id >= 0) {
+            int next = timers[id].next;
+            link(id);
+            id = next;
+        }
+    }
+
+public:
+    explicit TimerWheel(int capacity) : timers(capacity), now(0), scheduled(0) {
+        for (Timer& t : timers) t.slot = -1;
+        std::fill(heads, heads + LEVELS * SLOTS, -1);
+    }
+
+    // Fire `id` at tick `due`, moving it if it was already scheduled. A
+    // due tick that has already passed fires on the next advance.
+    void schedule(int id, uint64_t due) {
+        if (timers[id].slot >= 0) unlink(id);
+        else scheduled++;
+        timers[id].due = std::max(due, now + 1);
+        link(id);
+    }
+
+    void cancel(int id) {
+        if (timers[id].slot < 0) return;
+        unlink(id);
+        scheduled--;
+    }
+
+    // Step time forward to `to`, appending every timer that comes due on
+    // the way to `fired`. Fired timers are no longer scheduled.
+    void advance(uint64_t to, std::vector<int>& fired) {
+        while (now < to) {
+            now++;
+            for (int level = 1; level < LEVELS && !(now & (((uint64_t)1 << (SLOT_BITS * level)) - 1)); level++)
+                cascade(level);
+            int s = (int)(now & (SLOTS - 1));
+            for (int id = heads[s]; id >= 0; id = timers[id].next) {
+                timers[id].slot = -1;
+                fired.push_back(id);
+                scheduled--;
+            }
+            heads[s] = -1;
+        }
+    }
+
+    bool isScheduled(int id) const { return timers[id].slot >= 0; }
+    uint64_t getNow() const { return now; }
+    int size() const { return scheduled; }
+};
+
+// The socket protocol. Integers are little-endian; cells are Cell values.
+//   client -> server
+//     'J' mode:u8 map:u8 difficulty:u8 seed:u32   join (the first message)
+//     'T' dir:u8                                  turn (a Direction)
+//     'Q'                                         quit
+//   server -> client
+//     'W' session:u32 width:u16 height:u16 tickMs:u16        joined
+//     'K' header, width * height cells:u8                    whole board
+//     'D' header, count:u16, (index:u32, cell:u8) * count    changed cells
+//     'E' ticks:u32 score:i32 cause:u8 hash:u64              game over
+//   header = tick:u32 score:i32 timeLeft:u16 (tenths of a second)
+//            head x:i16 y:i16 dir:u8
+// The hash in 'E' is hashCells() of the final board, so a client can
+// check its copy.
+struct ServerWire {
+    enum {
+        JOIN_BYTES = 8,
+        TURN_BYTES = 2,
+        WELCOME_BYTES = 11,
+        HEADER_BYTES = 16,
+        CELL_BYTES = 5, // One entry of a 'D' frame
+        END_BYTES = 18
+    };
+
+    static void put(uint8_t*& p, uint64_t v, int bytes) {
+        for (int i = 0; i < bytes; i++) *p++ = (uint8_t)(v >> (8 * i));
+    }
+
+    static uint64_t get(const uint8_t*& p, int bytes) {
+        uint64_t v = 0;
+        for (int i = 0; i < bytes; i++) v |= (uint64_t)*p++ << (8 * i);
+        return v;
+    }
+
+    // FNV-1a, one cell at a time in row-major order
+    static uint64_t hashCell(uint64_t h, uint8_t cell) { return (h ^ cell) * 1099511628211ULL; }
+    static uint64_t hashCells(const uint8_t* cells, size_t n) {
+        uint64_t h = 1469598103934665603ULL;
+        for (size_t i = 0; i < n; i++) h = hashCell(h, cells[i]);
+        return h;
+    }
+
+    static bool validJoin(int mode, int map, int difficulty) {
+        return (mode == CLASSIC || mode == TIME_ATTACK) && map >= RECTANGLE && map <= TRIANGLE && difficulty >= 1 &&
+               difficulty <= 3;
+    }
+};
+
+#ifdef MSG_NOSIGNAL
+static const int SERVER_SEND_FLAGS = MSG_DONTWAIT | MSG_NOSIGNAL;
+#else
+static const int SERVER_SEND_FLAGS = MSG_DONTWAIT; // SO_NOSIGPIPE is set on the socket instead
+#endif
+
+inline void setSocketOptions(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+}
+
+struct ServerConfig {
+    int threads = 0;         // Tick pool size; 0 for one per hardware thread
+    int maxSessions = 4096;  // Bots and clients at once; storage is sized for this up front
+    int sendBuffer = 0;      // Socket send buffer per client in bytes; 0 keeps the system's
+    int lingerMs = 2000;     // How long a client gets to join, and once finished to read its last frames
+};
+
+struct ServerStats {
+    long long ticks = 0;
+    long long overruns = 0; // Ticks that started a full period or more late
+    long long dropped = 0;  // Ticks given up by sessions that fell too far behind
+    long long games = 0;    // Games played to the end, bots included
+    long long joined = 0;   // Client sessions started
+    long long rejected = 0; // Connections refused: server full, a bad join or none in time
+    long long frames = 0, keyframes = 0, skipped = 0; // Frames sent, how many whole, dropped on a full socket
+    long long bytes = 0;
+    int live = 0, peak = 0; // Sessions being ticked
+    double seconds = 0;     // How long run() ran
+    double busySeconds = 0; // Of that, spent ticking
+    Histogram lateNanos;    // Tick start minus deadline
+};
+
+class SessionServer {
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    static const int MAX_BEHIND = 25; // Periods behind before a session skips ticks
+    static const int CHUNK = 16;      // Sessions per pool task
+
+    // Where a slot's connection is; only the I/O thread reads or changes
+    // it. A finished client lingers until its last frames are sent, then
+    // until it closes its end: closing ours with its turns still unread
+    // would reset the connection before it read them.
+    enum Conn { CONN_NONE = 0, CONN_PENDING, CONN_LIVE, CONN_HUNG, CONN_LINGER, CONN_SHUT };
+
+    struct Session {
+        SeededRandom rng;
+        ManualClock clock;
+        std::unique_ptr<Game> game;
+        std::unique_ptr<Controller> pilot; // Bots only
+        GameSpec spec;
+        int periodMs;
+        uint64_t due; // Wheel tick of the next tick
+
+        // The client's socket, -1 for a bot. Turns arrive through the
+        // ring as keys and are coalesced as at the console.
+        int fd;
+        SpscRing<uint8_t, 16> turns;
+        TurnCoalescer coalescer;
+        std::atomic<bool> hangup;
+        std::vector<uint8_t> out; // Sized for the largest frame, twice, plus 'E'
+        size_t outLen, outSent;
+        bool keyframe;
+
+        // I/O thread only
+        Conn conn;
+        uint8_t in[ServerWire::JOIN_BYTES];
+        int inLen;
+        Clock::time_point deadline; // To join, or to finish lingering
+
+        // What the last tick did, for the driver
+        int64_t lateNanos;
+        size_t sentBytes;
+        bool sentKey, skipped, ended;
+
+        Session()
+            : rng(1), periodMs(0), due(0), fd(-1), hangup(false), outLen(0), outSent(0), keyframe(true),
+              conn(CONN_NONE), inLen(0), lateNanos(0), sentBytes(0), sentKey(false), skipped(false), ended(false) {}
+    };
+
+    ServerConfig cfg;
+    ControllerFactory botPilot;
+    std::unique_ptr<Session[]> sessions;
+    TimerWheel wheel;
+    PhasePool pool;
+    DeadlineWaiter waiter;
+    std::function<void(int)> tickTask;
+    std::vector<int> ready;
+    Clock::time_point epoch;
+    std::atomic<bool> running;
+    ServerStats stats;
+    long long admitted; // Staggers the first ticks of sessions that join together
+
+    // Hand-offs between the I/O thread, addBot() and the driver
+    std::mutex lock;
+    std::vector<int> freeSlots, joining, closing;
+    std::vector<int> admitting; // Driver's side of `joining`
+
+    int listenFd;
+    std::string socketPath;
+    std::thread io;
+
+    static int64_t nanos(Clock::duration d) { return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count(); }
+
+    int takeSlot() {
+        std::lock_guard<std::mutex> hold(lock);
+        if (freeSlots.empty()) return -1;
+        int id = freeSlots.back();
+        freeSlots.pop_back();
+        return id;
+    }
+
+    // Build the slot's game. The slot is not ticked until admitted.
+    void prepare(Session& s, const GameSpec& spec) {
+        s.spec = spec;
+        s.rng = SeededRandom(spec.seed);
+        s.clock = ManualClock();
+        s.pilot.reset();
+        s.game.reset(newGame(spec, s.rng, s.clock));
+        if (s.fd < 0 && botPilot) s.pilot = botPilot(*s.game);
+        s.periodMs = s.game->getTickPeriodMs();
+        size_t frame = ServerWire::HEADER_BYTES + (size_t)s.game->getMap()->getWidth() * s.game->getMap()->getHeight();
+        s.out.resize(std::max(s.out.size(), 2 * frame + ServerWire::END_BYTES));
+        s.outLen = s.outSent = 0;
+        s.keyframe = true;
+        s.hangup = false;
+        s.coalescer = TurnCoalescer();
+        uint8_t stale;
+        while (s.turns.pop(stale)) {}
+    }
+
+    void hand(std::vector<int>& queue, int id) {
+        std::lock_guard<std::mutex> hold(lock);
+        queue.push_back(id);
+    }
+
+    // --- Ticks (pool threads; each session is ticked by one at a time) ---
+
+    // Push out what is queued. True once nothing is left.
+    static bool drain(Session& s) {
+        while (s.outSent < s.outLen) {
+            if (s.fd < 0) { s.outSent = s.outLen; break; } // A bot: nobody to send to
+            ssize_t n = send(s.fd, s.out.data() + s.outSent, s.outLen - s.outSent, SERVER_SEND_FLAGS);
+            if (n > 0) { s.outSent += (size_t)n; continue; }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return false;
+            if (n < 0 && errno == EINTR) continue;
+            s.hangup = true; // The client is gone: drop the rest
+            s.outSent = s.outLen;
+        }
+        s.outLen = s.outSent = 0;
+        return true;
+    }
+
+    static uint8_t* putHeader(uint8_t* p, char type, Game& game) {
+        const Point& h = game.getSnake()->getHead();
+        *p++ = (uint8_t)type;
+        ServerWire::put(p, (uint64_t)game.getTicks(), 4);
+        ServerWire::put(p, (uint32_t)game.getScore(), 4);
+        ServerWire::put(p, (uint64_t)std::max(0.0, game.getTimeLeft() * 10 + 0.5), 2);
+        ServerWire::put(p, (uint16_t)h.x, 2);
+        ServerWire::put(p, (uint16_t)h.y, 2);
+        *p++ = (uint8_t)game.getSnake()->getDirection();
+        return p;
+    }
+
+    // Append this tick's frame: the retagged cells, or the whole board
+    // when the client's copy cannot be trusted or a delta would be bigger
+    static void writeFrame(Session& s, bool whole) {
+        Game& game = *s.game;
+        Board* board = game.getBoard();
+        int w = board->getWidth(), h = board->getHeight();
+        const std::vector<int>& dirty = board->getDirty();
+        whole = whole || dirty.size() > 0xffff || dirty.size() * ServerWire::CELL_BYTES >= (size_t)w * h;
+        uint8_t* start = s.out.data() + s.outLen;
+        uint8_t* p = putHeader(start, whole ? 'K' : 'D', game);
+        if (whole) {
+            for (int y = 0; y < h; y++)
+                for (int x = 0; x < w; x++) *p++ = board->at(x, y);
+        } else {
+            ServerWire::put(p, dirty.size(), 2);
+            for (int i : dirty) {
+                ServerWire::put(p, (uint32_t)i, 4);
+                *p++ = board->at(i % w, i / w);
+            }
+        }
+        board->clearDirty();
+        s.keyframe = false;
+        s.sentKey = whole;
+        s.sentBytes += (size_t)(p - start);
+        s.outLen += (size_t)(p - start);
+    }
+
+    static void writeEnd(Session& s) {
+        Game& game = *s.game;
+        Board* board = game.getBoard();
+        uint64_t hash = 1469598103934665603ULL;
+        for (int y = 0; y < board->getHeight(); y++)
+            for (int x = 0; x < board->getWidth(); x++) hash = ServerWire::hashCell(hash, board->at(x, y));
+        uint8_t* p = s.out.data() + s.outLen;
+        *p++ = 'E';
+        ServerWire::put(p, (uint64_t)game.getTicks(), 4);
+        ServerWire::put(p, (uint32_t)game.getScore(), 4);
+        *p++ = (uint8_t)game.getDeathCause();
+        ServerWire::put(p, hash, 8);
+        s.outLen += ServerWire::END_BYTES;
+        s.sentBytes += ServerWire::END_BYTES;
+    }
+
+    void tick(Session& s) {
+        Clock::time_point t0 = Clock::now();
+        s.lateNanos = nanos(t0 - (epoch + std::chrono::milliseconds(s.due)));
+        s.sentBytes = 0;
+        s.sentKey = s.skipped = s.ended = false;
+        Game& game = *s.game;
+
+        Direction turn;
+        if (s.pilot) {
+            turn = s.pilot->decide(game);
+        } else {
+            s.coalescer.begin(game.getSnake()->getDirection());
+            uint8_t key;
+            while (s.turns.pop(key)) s.coalescer.add({key, 0});
+            if (s.hangup.load(std::memory_order_relaxed)) game.quit();
+            turn = s.coalescer.turn();
+        }
+        if (!game.isOver()) {
+            s.clock.advance(s.periodMs / 1000.0);
+            game.step(turn);
+        }
+        s.ended = game.isOver();
+
+        // A frame only goes out once the last one is gone. The final one
+        // always does (after any backlog), so the client ends in sync.
+        if (drain(s) || s.ended) writeFrame(s, s.keyframe || s.outLen > 0);
+        else {
+            s.skipped = true;
+            s.keyframe = true;
+            game.getBoard()->clearDirty();
+        }
+        if (s.ended) writeEnd(s);
+        drain(s);
+
+        if (s.ended && s.pilot) {
+            // Bots play on with the next seed
+            GameSpec next = s.spec;
+            next.seed++;
+            prepare(s, next);
+        }
+    }
+
+    void tickChunk(int task) {
+        size_t end = std::min(ready.size(), (size_t)(task + 1) * CHUNK);
+        for (size_t i = (size_t)task * CHUNK; i < end; i++) tick(sessions[ready[i]]);
+    }
+
+    // --- Driver ---
+
+    void admit() {
+        {
+            std::lock_guard<std::mutex> hold(lock);
+            admitting.swap(joining);
+        }
+        for (int id : admitting) {
+            Session& s = sessions[id];
+            // Spread a crowd of joins over their first period
+            s.due = wheel.getNow() + 1 + (uint64_t)(admitted++ % s.periodMs);
+            wheel.schedule(id, s.due);
+            stats.live++;
+            stats.peak = std::max(stats.peak, stats.live);
+        }
+        admitting.clear();
+    }
+
+    void settle(int id, uint64_t nowMs) {
+        Session& s = sessions[id];
+        stats.ticks++;
+        stats.lateNanos.record((uint64_t)std::max<int64_t>(0, s.lateNanos));
+        if (s.lateNanos >= (int64_t)s.periodMs * 1000000) stats.overruns++;
+        if (s.skipped) stats.skipped++;
+        else stats.frames++;
+        if (s.sentKey) stats.keyframes++;
+        stats.bytes += (long long)s.sentBytes;
+        if (s.ended) stats.games++;
+
+        if (s.ended && s.fd >= 0) {
+            stats.live--;
+            hand(closing, id);
+            return;
+        }
+        s.due += s.periodMs;
+        if (s.due + (uint64_t)MAX_BEHIND * s.periodMs < nowMs) {
+            // Stalled: skip ahead rather than tick a backlog back to back
+            uint64_t behind = (nowMs - s.due) / s.periodMs;
+            stats.dropped += (long long)behind;
+            s.due += behind * s.periodMs;
+        }
+        wheel.schedule(id, s.due);
+    }
+
+    // --- Sockets (I/O thread) ---
+
+    void release(int id) {
+        Session& s = sessions[id];
+        if (s.fd >= 0) close(s.fd);
+        s.fd = -1;
+        s.conn = CONN_NONE;
+        s.inLen = 0;
+        s.pilot.reset();
+        s.game.reset();
+        hand(freeSlots, id);
+    }
+
+    void accept() {
+        for (;;) {
+            int fd = ::accept(listenFd, NULL, NULL);
+            if (fd < 0) return;
+            int id = takeSlot();
+            if (id < 0) {
+                close(fd);
+                stats.rejected++;
+                continue;
+            }
+            setSocketOptions(fd);
+            if (cfg.sendBuffer > 0) setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &cfg.sendBuffer, sizeof(cfg.sendBuffer));
+            Session& s = sessions[id];
+            s.fd = fd;
+            s.conn = CONN_PENDING;
+            s.inLen = 0;
+            s.deadline = Clock::now() + std::chrono::milliseconds(cfg.lingerMs);
+        }
+    }
+
+    // Bytes from a client that has not joined yet
+    void readJoin(int id) {
+        Session& s = sessions[id];
+        ssize_t n = read(s.fd, s.in + s.inLen, ServerWire::JOIN_BYTES - s.inLen);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return;
+        if (n <= 0) { release(id); return; }
+        s.inLen += (int)n;
+        if (s.inLen < ServerWire::JOIN_BYTES) return;
+
+        const uint8_t* p = s.in + 1;
+        GameSpec spec;
+        spec.mode = (GameMode)*p++;
+        spec.map = (MapType)*p++;
+        spec.difficulty = *p++;
+        spec.seed = (uint32_t)ServerWire::get(p, 4);
+        if (s.in[0] != 'J' || !ServerWire::validJoin(spec.mode, spec.map, spec.difficulty)) {
+            stats.rejected++;
+            release(id);
+            return;
+        }
+        prepare(s, spec);
+        uint8_t welcome[ServerWire::WELCOME_BYTES];
+        uint8_t* w = welcome;
+        *w++ = 'W';
+        ServerWire::put(w, (uint32_t)id, 4);
+        ServerWire::put(w, (uint64_t)s.game->getMap()->getWidth(), 2);
+        ServerWire::put(w, (uint64_t)s.game->getMap()->getHeight(), 2);
+        ServerWire::put(w, (uint64_t)s.periodMs, 2);
+        // The socket is empty, so this fits
+        if (send(s.fd, welcome, sizeof(welcome), SERVER_SEND_FLAGS) != (ssize_t)sizeof(welcome)) {
+            release(id);
+            return;
+        }
+        s.conn = CONN_LIVE;
+        s.inLen = 0;
+        stats.joined++;
+        hand(joining, id);
+    }
+
+    // Turns and quits from a client in a game
+    void readInput(int id) {
+        Session& s = sessions[id];
+        uint8_t buf[256];
+        ssize_t n = read(s.fd, buf, sizeof(buf));
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return;
+        if (n <= 0) {
+            s.hangup = true;
+            s.conn = CONN_HUNG; // The tick ends the game and hands the slot back
+            return;
+        }
+        static const char keys[] = {0, 'a', 'd', 'w', 's'}; // By Direction
+        for (ssize_t i = 0; i < n; i++) {
+            s.in[s.inLen++] = buf[i];
+            if (s.in[0] == 'T' && s.inLen < ServerWire::TURN_BYTES) continue;
+            if (s.in[0] == 'T' && s.in[1] >= LEFT && s.in[1] <= DOWN) s.turns.push((uint8_t)keys[s.in[1]]); // Full: dropped
+            else if (s.in[0] != 'T') {
+                // 'Q', or not the protocol at all
+                s.hangup = true;
+                s.conn = CONN_HUNG;
+                return;
+            }
+            s.inLen = 0;
+        }
+    }
+
+    void ioLoop() {
+        std::vector<pollfd> fds;
+        std::vector<int> owner;
+        std::vector<int> done;
+        fds.reserve(cfg.maxSessions + 1);
+        owner.reserve(cfg.maxSessions + 1);
+        done.reserve(cfg.maxSessions);
+        while (running.load(std::memory_order_relaxed)) {
+            {
+                std::lock_guard<std::mutex> hold(lock);
+                done.swap(closing);
+            }
+            Clock::time_point now = Clock::now();
+            for (int id : done) {
+                sessions[id].conn = CONN_LINGER;
+                sessions[id].deadline = now + std::chrono::milliseconds(cfg.lingerMs);
+            }
+            done.clear();
+
+            fds.clear();
+            owner.clear();
+            fds.push_back({listenFd, POLLIN, 0});
+            owner.push_back(-1);
+            for (int id = 0; id < cfg.maxSessions; id++) {
+                Session& s = sessions[id];
+                if ((s.conn == CONN_PENDING || s.conn == CONN_LINGER || s.conn == CONN_SHUT) && now >= s.deadline) {
+                    if (s.conn == CONN_PENDING) stats.rejected++;
+                    release(id);
+                } else if (s.conn == CONN_LINGER && s.outSent == s.outLen) {
+                    shutdown(s.fd, SHUT_WR);
+                    s.conn = CONN_SHUT;
+                }
+                if (s.conn == CONN_PENDING || s.conn == CONN_LIVE || s.conn == CONN_LINGER || s.conn == CONN_SHUT) {
+                    fds.push_back({s.fd, (short)(s.conn == CONN_LINGER ? POLLOUT : POLLIN), 0});
+                    owner.push_back(id);
+                }
+            }
+            if (poll(fds.data(), (nfds_t)fds.size(), 10) <= 0) continue;
+
+            if (fds[0].revents & POLLIN) accept();
+            for (size_t i = 1; i < fds.size(); i++) {
+                if (!fds[i].revents) continue;
+                int id = owner[i];
+                Session& s = sessions[id];
+                if (s.conn == CONN_PENDING) readJoin(id);
+                else if (s.conn == CONN_LIVE) readInput(id);
+                else if (s.conn == CONN_LINGER && (fds[i].revents & (POLLERR | POLLHUP))) release(id);
+                else if (s.conn == CONN_LINGER) drain(s);
+                else {
+                    // Shut: discard anything still arriving until the client closes
+                    uint8_t discard[256];
+                    ssize_t n = read(s.fd, discard, sizeof(discard));
+                    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) release(id);
+                }
+            }
+        }
+    }
+
+public:
+    // `bots` steers the sessions addBot() starts
+    explicit SessionServer(const ServerConfig& config, ControllerFactory bots = ControllerFactory())
+        : cfg(config), botPilot(bots), sessions(new Session[config.maxSessions]), wheel(config.maxSessions),
+          pool(config.threads), running(false), admitted(0), listenFd(-1) {
+        tickTask = [this](int task) { tickChunk(task); };
+        ready.reserve(cfg.maxSessions);
+        freeSlots.reserve(cfg.maxSessions);
+        joining.reserve(cfg.maxSessions);
+        admitting.reserve(cfg.maxSessions);
+        closing.reserve(cfg.maxSessions);
+        for (int id = cfg.maxSessions - 1; id >= 0; id--) freeSlots.push_back(id);
+    }
+
+    ~SessionServer() {
+        stop();
+        if (io.joinable()) io.join();
+        for (int id = 0; id < cfg.maxSessions; id++)
+            if (sessions[id].fd >= 0) close(sessions[id].fd);
+        if (listenFd >= 0) {
+            close(listenFd);
+            unlink(socketPath.c_str());
+        }
+    }
+
+    SessionServer(const SessionServer&) = delete;
+    SessionServer& operator=(const SessionServer&) = delete;
+
+    // Accept clients on a Unix-domain socket at `path` (replacing a stale
+    // one). Call before run().
+    bool listen(const char* path, std::string& error) {
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (strlen(path) >= sizeof(addr.sun_path)) { error = "socket path too long"; return false; }
+        strcpy(addr.sun_path, path);
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) { error = strerror(errno); return false; }
+        unlink(path);
+        if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(fd, SOMAXCONN) < 0) {
+            error = strerror(errno);
+            close(fd);
+            return false;
+        }
+        setSocketOptions(fd);
+        listenFd = fd;
+        socketPath = path;
+        return true;
+    }
+
+    // Start a bot session (any thread). False when the server is full.
+    bool addBot(const GameSpec& spec) {
+        int id = takeSlot();
+        if (id < 0) return false;
+        prepare(sessions[id], spec);
+        hand(joining, id);
+        return true;
+    }
+
+    // Tick until stop() or for `seconds` (0 for no limit). Clients are
+    // served on a thread of their own meanwhile.
+    void run(double seconds) {
+        epoch = Clock::now();
+        running = true;
+        if (listenFd >= 0) io = std::thread(&SessionServer::ioLoop, this);
+        while (running.load(std::memory_order_relaxed)) {
+            admit();
+            uint64_t next = wheel.getNow() + 1;
+            if (seconds > 0 && next > seconds * 1000) break;
+            waiter.waitUntil(epoch + std::chrono::milliseconds(next));
+            uint64_t nowMs = (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - epoch).count();
+            ready.clear();
+            wheel.advance(nowMs, ready);
+            if (ready.empty()) continue;
+
+            Clock::time_point t0 = Clock::now();
+            pool.run((int)((ready.size() + CHUNK - 1) / CHUNK), tickTask);
+            stats.busySeconds += std::chrono::duration<double>(Clock::now() - t0).count();
+            for (int id : ready) settle(id, nowMs);
+        }
+        running = false;
+        if (io.joinable()) io.join();
+        stats.seconds = std::chrono::duration<double>(Clock::now() - epoch).count();
+    }
+
+    // Ask run() to return (any thread)
+    void stop() { running = false; }
+
+    // Read once run() has returned
+    const ServerStats& getStats() { return stats; }
+    int getThreads() { return pool.getThreads(); }
+};
+
+// The client end: joins, sends turns and keeps a copy of the board
+// from the frames. pump() applies whatever has arrived.
+struct ClientView {
+    int width = 0, height = 0, tickMs = 0;
+    uint32_t session = 0;
+    std::vector<uint8_t> cells; // Row-major Cell values
+    long long tick = 0;
+    int score = 0;
+    double timeLeft = 0;
+    Point head = {-1, -1}, food = {-1, -1};
+    Direction dir = STOP;
+    bool over = false;
+    DeathCause cause = ALIVE;
+    uint64_t endHash = 0; // The server's hash of the final board
+    long long frames = 0, keyframes = 0, bytes = 0;
+
+    bool blocked(int x, int y) const {
+        if (x < 0 || y < 0 || x >= width || y >= height) return true;
+        uint8_t c = cells[(size_t)y * width + x];
+        return c == CELL_VOID || c == CELL_OBSTACLE || c == CELL_BODY;
+    }
+    uint64_t hash() const { return ServerWire::hashCells(cells.data(), cells.size()); }
+};
+
+class ServerClient {
+private:
+    int fd;
+    std::vector<uint8_t> buf;
+    size_t have;
+    ClientView view;
+
+    bool sendAll(const uint8_t* p, size_t n) {
+        while (n > 0) {
+            ssize_t k = send(fd, p, n, SERVER_SEND_FLAGS);
+            if (k < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+                pollfd w = {fd, POLLOUT, 0};
+                poll(&w, 1, 100);
+                continue;
+            }
+            if (k <= 0) return false;
+            p += k;
+            n -= (size_t)k;
+        }
+        return true;
+    }
+
+    void readHeader(const uint8_t*& p) {
+        view.tick = (long long)ServerWire::get(p, 4);
+        view.score = (int32_t)ServerWire::get(p, 4);
+        view.timeLeft = ServerWire::get(p, 2) / 10.0;
+        view.head.x = (int16_t)ServerWire::get(p, 2);
+        view.head.y = (int16_t)ServerWire::get(p, 2);
+        view.dir = (Direction)*p++;
+    }
+
+    // Length of the complete message at `p`, 0 if more bytes are needed,
+    // -1 if it is not the protocol
+    long long messageBytes(const uint8_t* p, size_t n) const {
+        size_t cells = view.cells.size();
+        switch (p[0]) {
+            case 'W': return n >= ServerWire::WELCOME_BYTES ? ServerWire::WELCOME_BYTES : 0;
+            case 'E': return n >= ServerWire::END_BYTES ? ServerWire::END_BYTES : 0;
+            case 'K': return n >= ServerWire::HEADER_BYTES + cells ? (long long)(ServerWire::HEADER_BYTES + cells) : 0;
+            case 'D': {
+                if (n < ServerWire::HEADER_BYTES + 2) return 0;
+                size_t count = p[ServerWire::HEADER_BYTES] | (size_t)p[ServerWire::HEADER_BYTES + 1] << 8;
+                size_t len = ServerWire::HEADER_BYTES + 2 + count * ServerWire::CELL_BYTES;
+                return n >= len ? (long long)len : 0;
+            }
+        }
+        return -1;
+    }
+
+    bool apply(const uint8_t* p) {
+        switch (*p++) {
+            case 'W':
+                view.session = (uint32_t)ServerWire::get(p, 4);
+                view.width = (int)ServerWire::get(p, 2);
+                view.height = (int)ServerWire::get(p, 2);
+                view.tickMs = (int)ServerWire::get(p, 2);
+                view.cells.assign((size_t)view.width * view.height, CELL_VOID);
+                break;
+            case 'K':
+                readHeader(p);
+                memcpy(view.cells.data(), p, view.cells.size());
+                view.food = {-1, -1};
+                for (size_t i = 0; i < view.cells.size(); i++)
+                    if (view.cells[i] == CELL_FOOD) view.food = {(int)(i % view.width), (int)(i / view.width)};
+                view.frames++;
+                view.keyframes++;
+                break;
+            case 'D': {
+                readHeader(p);
+                size_t count = (size_t)ServerWire::get(p, 2);
+                for (size_t k = 0; k < count; k++) {
+                    size_t i = (size_t)ServerWire::get(p, 4);
+                    uint8_t c = *p++;
+                    if (i >= view.cells.size()) return false;
+                    view.cells[i] = c;
+                    if (c == CELL_FOOD) view.food = {(int)(i % view.width), (int)(i / view.width)};
+                }
+                view.frames++;
+                break;
+            }
+            case 'E':
+                view.tick = (long long)ServerWire::get(p, 4);
+                view.score = (int32_t)ServerWire::get(p, 4);
+                view.cause = (DeathCause)*p++;
+                view.endHash = ServerWire::get(p, 8);
+                view.over = true;
+                break;
+        }
+        return true;
+    }
+
+public:
+    ServerClient() : fd(-1), have(0) {}
+    ~ServerClient() { if (fd >= 0) close(fd); }
+
+    ServerClient(const ServerClient&) = delete;
+    ServerClient& operator=(const ServerClient&) = delete;
+
+    bool connect(const char* path, std::string& error) {
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (strlen(path) >= sizeof(addr.sun_path)) { error = "socket path too long"; return false; }
+        strcpy(addr.sun_path, path);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || ::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+            error = strerror(errno);
+            return false;
+        }
+        setSocketOptions(fd);
+        buf.resize(1 << 16);
+        return true;
+    }
+
+    bool join(GameMode mode, MapType map, int difficulty, uint32_t seed) {
+        uint8_t msg[ServerWire::JOIN_BYTES];
+        uint8_t* p = msg;
+        *p++ = 'J';
+        *p++ = (uint8_t)mode;
+        *p++ = (uint8_t)map;
+        *p++ = (uint8_t)difficulty;
+        ServerWire::put(p, seed, 4);
+        return sendAll(msg, sizeof(msg));
+    }
+
+    bool turn(Direction d) {
+        uint8_t msg[ServerWire::TURN_BYTES] = {'T', (uint8_t)d};
+        return sendAll(msg, sizeof(msg));
+    }
+
+    bool quit() {
+        uint8_t msg = 'Q';
+        return sendAll(&msg, 1);
+    }
+
+    // Wait up to `timeoutMs` for data and apply every complete message.
+    // False once the server has closed the connection (or broke protocol).
+    bool pump(int timeoutMs) {
+        pollfd r = {fd, POLLIN, 0};
+        if (poll(&r, 1, timeoutMs) <= 0) return true;
+        for (;;) {
+            if (have == buf.size()) buf.resize(buf.size() * 2);
+            ssize_t n = read(fd, buf.data() + have, buf.size() - have);
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            have += (size_t)n;
+            view.bytes += n;
+        }
+        size_t at = 0;
+        while (at < have) {
+            long long len = messageBytes(buf.data() + at, have - at);
+            if (len < 0 || (len > 0 && !apply(buf.data() + at))) return false;
+            if (len == 0) break;
+            at += (size_t)len;
+        }
+        memmove(buf.data(), buf.data() + at, have - at);
+        have -= at;
+        return true;
+    }
+
+    const ClientView& getView() { return view; }
+};
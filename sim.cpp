@@ -0,0 +1,1256 @@
+// ==========================================
+//      HEADLESS SIMULATION DRIVER (CLI)
+// ==========================================
+// Plays N seeded games with a simple greedy policy (or the A* autopilot,
+// --policy auto) and reports raw engine throughput. No console, no
+// sleeping: the clock is advanced by one tick period per step, so
+// TIME_ATTACK runs in game time. Games are spread over --threads workers
+// (default: all cores); game g always uses seed S+g, so results do not
+// depend on the thread count.
+//
+//   sim [--games N] [--seed S] [--map rect|circle|triangle|all]
+//       [--difficulty 1-3|all] [--mode classic|time] [--max-ticks T]
+//       [--threads N] [--render] [--render-full]
+//       [--policy greedy|auto] [--budget-us U] [--metrics FILE]
+//   sim --watch | --realtime | --play [--fps F] [--load N] [game options]
+//   sim --record FILE [game options]
+//   sim --replay FILE [--seek T] [--watch]
+//   sim --check-rewind [--rewind T] [game options]
+//   sim --check-alloc [--games N] [game options]
+//   sim --check-audio [game options]
+//   sim --check-threads [--games N] [game options]
+//   sim --map-file FILE [batch options]
+//   sim --gen-map FILE [--map rect|circle|triangle] [--size S]
+//       [--density D] [--seed S]
+//   sim --world [--cache C] [--prefetch] [--watch | --play]
+//       [--max-ticks T] [--seed S]
+//   sim --arena [--snakes N] [--size S] [--food F] [--tick-ms M]
+//       [--max-ticks T] [--threads N] [--seed S]
+//   sim --serve PATH|- [--sessions N] [--seconds S] [--threads N]
+//       [game options]
+//   sim --connect PATH [--watch | --play] [--max-ticks T] [game options]
+//   sim --check-server [--sessions N] [--max-ticks T]
+//
+// With "all", game g cycles through the map types / difficulties.
+// --render draws every tick through the ANSI renderer into a null sink
+// and reports frame bytes/time; --render-full forces a full repaint each
+// frame for comparison. --watch plays one game live in the terminal on
+// the fixed-timestep scheduler; --realtime does the same into a null
+// sink; --play lets you steer (wasd/arrows, x quits), rings the terminal
+// bell for food and death, and also reports key-to-screen latency. All
+// report tick jitter and overruns, and --load N keeps N extra threads
+// spinning to show the timing under load.
+// --record plays one game (seed S) into a replay file and reports its
+// size and per-tick cost; --replay plays a file back, checks that seeking
+// lands on the same states as straight playback, and reports the result.
+// With --policy auto every game is steered by the Autopilot with a
+// planning budget of U microseconds per tick (default 1000), and the
+// batch report adds the win rate per map (a win fills the whole map) and
+// percentiles of the time spent deciding each tick.
+// --metrics times the engine's phases (input, logic, respawn, BFS, draw)
+// in batch and real-time runs, prints p50/p99/max with the allocation,
+// BFS node and console byte counts, and writes them to FILE (.json for
+// JSON, anything else for CSV).
+// --check-rewind plays one game (seed S) through a Rewinder and checks
+// that stepping back up to T ticks (default 300) lands on the states
+// seen going forward, that a snapshot saved to disk resumes in a
+// fresh game that then plays on identically, and that damaged copies of
+// that file (truncated, or edited off the grid) are all turned away.
+// --check-alloc plays N games serially as the console game ticks them
+// (decide, step, record, draw into a null sink) and counts the heap
+// allocations made inside ticks; everything is sized when the game is
+// built, so any at all is a failure (exit 2).
+// --check-audio plays one game twice, one tick per millisecond, once
+// silent and once posting its sounds to an AudioQueue whose sink takes
+// as long as Beep, and compares the tick times; a tick slowed by sound
+// fails (exit 2). The game stops at T ticks (default 3000).
+// --check-threads runs the batch, and a small arena, on 1 thread, 2 and
+// every core (at least 4) and fails (exit 2) unless each gives the same
+// per-game digest or arena hash. Use the greedy policy: the autopilot's
+// time budget makes its plans depend on the machine.
+// --map-file plays the batch (and --render, --check-alloc,
+// --check-threads) on a map read from a text file (see mapfile.h).
+// --gen-map generates an S x S map (default 1024) of the shape with
+// obstacles on a fraction D of its cells (default 0.1), writes it to
+// FILE, reads it back and reports the time each step took and whether
+// the open area is in one piece.
+// --world plays the endless chunked World (a cache of C chunks, default
+// 128) with a greedy pilot for T ticks (default 100000), headless unless
+// --watch or --play, and reports tick times, chunk generation, evictions
+// and the cache's memory, which does not grow with the distance covered.
+// --prefetch generates chunks ahead on a worker thread; the final state
+// hash is the same with or without it.
+// --arena runs the many-snake Arena (N AI snakes on an S x S map with F
+// food) on the scheduler at one tick per M ms for T ticks and reports
+// the tick time, overruns, deaths and a state hash that must not change
+// with --threads.
+// --serve hosts N bot sessions (default 0, game g as in a batch) and
+// any clients that connect to the Unix-domain socket PATH ("-" for
+// none) on one SessionServer for S seconds (default 10, 0 for no end),
+// then reports how late ticks started and what was sent.
+// --connect joins the server at PATH as a client, steering greedily
+// (or from the keyboard with --play) for T ticks, and checks its copy of
+// the board against the server's at the end (exit 2 if they differ).
+// --check-server runs a server with N bots (default 200) and 8 clients,
+// one of which stops reading for a while, and fails (exit 2) unless
+// every client's board ends up as the server's.
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <cmath>
+#include <climits>
+#include <string>
+#include <thread>
+#include <atomic>
+#include "engine.h"
+#include "render.h"
+#include "batch.h"
+#include "replay.h"
+#include "scheduler.h"
+#include "input.h"
+#include "autopilot.h"
+#include "arena.h"
+#include "rewind.h"
+#include "audio.h"
+#include "world.h"
+#include "mapfile.h"
+#include "server.h"
+
+using namespace std;
+
+SNAKE_DEFINE_ALLOCATION_COUNTER()
+
+// Lets the batch runner drive the Autopilot and collect its counters
+class AutopilotController : public Controller {
+private:
+    Autopilot pilot;
+
+public:
+    AutopilotController(Game& game, double budgetMicros) : pilot(game, budgetMicros) {}
+
+    Direction decide(Game& game) override { return pilot.decide(game); }
+
+    void report(Game& game, BatchStats& stats) override {
+        stats.decideNanos[game.getMapType()].merge(pilot.getDecideTimes());
+        stats.plans += pilot.getPlans();
+        stats.planReuses += pilot.getReuses();
+        stats.fallbacks += pilot.getFallbacks();
+        stats.overBudget += pilot.getOverBudget();
+    }
+};
+
+static ControllerFactory makeFactory(bool autopilot, double budgetMicros) {
+    if (autopilot)
+        return [budgetMicros](Game& game) {
+            return unique_ptr<Controller>(new AutopilotController(game, budgetMicros));
+        };
+    return [](Game&) { return unique_ptr<Controller>(new PolicyController(greedyTurn)); };
+}
+
+static void drawHud(Renderer& r, Game& game) {
+    int col = r.putText(0, 0, " SIM | SCORE: ", 14);
+    col = r.putText(r.putNumber(col, 0, game.getScore(), 14), 0, " ", 14);
+    if (game.getMode() == TIME_ATTACK) {
+        int color = game.getTimeLeft() < 5.0 ? 12 : 11;
+        col = r.putText(r.putNumber(r.putText(col, 0, "| TIME: ", color), 0, (int)game.getTimeLeft(), color), 0, "s", color);
+    }
+    r.clearRow(col, 0);
+    r.putRun(r.putText(0, 1, " ", 8), 1, '-', game.getMap()->getWidth(), 8);
+}
+
+// 0 means "cycle through all of them"
+static int parseMap(const string& s) {
+    if (s == "all") return 0;
+    if (s == "circle") return CIRCLE;
+    if (s == "triangle") return TRIANGLE;
+    return RECTANGLE;
+}
+
+static const char* causeName(int c) {
+    static const char* names[] = {"tick cap", "wall", "self", "obstacle", "time out", "quit", "won"};
+    return c >= ALIVE && c <= WON ? names[c] : "unknown";
+}
+
+static double secondsSince(chrono::steady_clock::time_point t0) {
+    return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+// A generated map written out and read back in
+static int generateMapFile(const char* path, MapType shape, int size, double density, uint32_t seed) {
+    unique_ptr<GameMap> map(shape == CIRCLE ? (GameMap*)new CircularMap(size, size)
+                            : shape == TRIANGLE ? (GameMap*)new TriangularMap(size, size)
+                                                : (GameMap*)new RectangularMap(size, size));
+    map->generateMap();
+    MapData data;
+    data.width = data.height = size;
+    data.valid = map->getMask();
+    data.spawn = {size / 2, size / 2};
+
+    SeededRandom rng(seed);
+    ObstacleGenerator gen;
+    auto t0 = chrono::steady_clock::now();
+    gen.reset(data.valid, data.obstacles);
+    int wanted = (int)(density * map->countValid());
+    int placed = gen.generate(wanted, data.spawn, 5, rng, data.obstacles);
+    double genSecs = secondsSince(t0);
+    int regions = gen.regions();
+
+    t0 = chrono::steady_clock::now();
+    if (!saveMapFile(path, data)) { cerr << "cannot write " << path << "\n"; return 1; }
+    double saveSecs = secondsSince(t0);
+    MapData loaded;
+    string error;
+    long long sealed = 0;
+    t0 = chrono::steady_clock::now();
+    if (!loadMapFile(path, loaded, error, &sealed)) { cerr << path << ": " << error << "\n"; return 1; }
+    double loadSecs = secondsSince(t0);
+
+    cout << "map:        " << size << "x" << size << ", " << map->countValid() << " playable cells\n";
+    cout << "obstacles:  " << placed << " of " << wanted << " wanted, in " << genSecs * 1e3 << " ms\n";
+    cout << "regions:    " << regions << " open region" << (regions == 1 ? "" : "s") << "\n";
+    cout << "file:       written in " << saveSecs * 1e3 << " ms, read in " << loadSecs * 1e3 << " ms, "
+         << sealed << " cells sealed\n";
+    bool ok = regions == 1 && sealed == 0 && loaded.obstacles.size() == data.obstacles.size();
+    return ok ? 0 : 2;
+}
+
+static bool sameState(const GameState& a, const GameState& b) {
+    return a.ticks == b.ticks && a.score == b.score && a.dir == b.dir && a.length == b.length &&
+           a.moves == b.moves && a.food == b.food && a.body.size() == b.body.size() &&
+           equal(a.body.begin(), a.body.end(), b.body.begin());
+}
+
+static int recordGame(const char* path, uint32_t seed, GameMode mode, MapType mapType, int difficulty,
+                      long long maxTicks, const ControllerFactory& factory) {
+    // Same game without a recorder, to price the recording
+    SeededRandom plainRng(seed);
+    ManualClock plainClock;
+    Game plain(mode, mapType, difficulty, plainRng, plainClock);
+    unique_ptr<Controller> plainPilot = factory(plain);
+    auto t0 = chrono::steady_clock::now();
+    while (!plain.isOver() && plain.getTicks() < maxTicks) {
+        plainClock.advance(plain.getTickPeriodMs() / 1000.0);
+        plain.step(plainPilot->decide(plain));
+    }
+    double plainSecs = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    SeededRandom rng(seed);
+    ManualClock clock;
+    Game game(mode, mapType, difficulty, rng, clock);
+    unique_ptr<Controller> pilot = factory(game);
+    ReplayWriter writer(path, game, rng, seed);
+    if (!writer.isOpen()) { cerr << "cannot write " << path << "\n"; return 1; }
+    t0 = chrono::steady_clock::now();
+    while (!game.isOver() && game.getTicks() < maxTicks) {
+        clock.advance(game.getTickPeriodMs() / 1000.0);
+        game.step(pilot->decide(game));
+        writer.record();
+    }
+    writer.finish();
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    long long ticks = max(1LL, game.getTicks());
+    cout << "ticks:      " << game.getTicks() << "\n";
+    cout << "score:      " << game.getScore() << "\n";
+    cout << "bytes:      " << writer.getBytes() << " (" << writer.getKeyframes() << " keyframes)\n";
+    cout << "bytes/tick: " << double(writer.getBytes()) / ticks << "\n";
+    cout << "ns/tick:    " << secs * 1e9 / ticks << " recorded, " << plainSecs * 1e9 / ticks << " plain\n";
+    return 0;
+}
+
+// Per-phase p50/p99/max and the counters; writes them out if asked to
+static int reportMetrics(const Metrics& m, const char* path) {
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        const Histogram& h = m.phases[p];
+        if (!h.count()) continue;
+        cout << left << setw(12) << (string(Metrics::phaseName(p)) + ":") << right << h.count() << " x, p50 "
+             << h.percentile(0.50) / 1e3 << " us, p99 " << h.percentile(0.99) / 1e3 << " us, max "
+             << h.max() / 1e3 << " us\n";
+    }
+    cout << "counters:   " << m.counters[COUNT_ALLOCATIONS] << " allocations, " << m.counters[COUNT_BFS_NODES]
+         << " BFS nodes, " << m.counters[COUNT_CONSOLE_BYTES] << " console bytes\n";
+    if (path && !m.write(path)) { cerr << "cannot write " << path << "\n"; return 1; }
+    return 0;
+}
+
+static void printTiming(const TimingStats& t, double tickSeconds) {
+    cout << "tick:       " << tickSeconds * 1e3 << " ms, " << t.ticks << " ticks, " << t.frames << " frames\n";
+    cout << "jitter:     avg " << t.avgJitter() * 1e6 << " us, rms " << t.rmsJitter() * 1e6
+         << " us, max " << t.maxJitter * 1e6 << " us\n";
+    cout << "late:       avg " << t.avgLate() * 1e6 << " us, max " << t.maxLate * 1e6 << " us\n";
+    cout << "overruns:   " << t.overruns << " (" << t.dropped << " dropped)\n";
+}
+
+// Cells, state and generator: everything that decides the next tick
+struct Fingerprint {
+    GameState state;
+    RandomState rng;
+    uint64_t board;
+
+    void take(Game& game, SeededRandom& r) {
+        game.saveState(state);
+        rng = r.getState();
+        Board* b = game.getBoard();
+        board = 1469598103934665603ULL;
+        for (int y = 0; y < b->getHeight(); y++)
+            for (int x = 0; x < b->getWidth(); x++) board = (board ^ b->at(x, y)) * 1099511628211ULL;
+    }
+    // The timer is measured off the clock, whose readings after a rewind
+    // or a resume differ from the first run's by rounding
+    bool operator==(const Fingerprint& o) const {
+        return sameState(state, o.state) && fabs(state.timeLeft - o.state.timeLeft) < 1e-6 && rng == o.rng &&
+               board == o.board;
+    }
+};
+
+static int checkRewind(uint32_t seed, GameMode mode, MapType mapType, int difficulty, long long maxTicks,
+                       long long depth, const ControllerFactory& factory) {
+    const long long CHECK_EVERY = 500;
+    const char* path = "check_rewind.snap";
+    SeededRandom rng(seed);
+    ManualClock clock;
+    Game game(mode, mapType, difficulty, rng, clock);
+    unique_ptr<Controller> pilot = factory(game);
+    double dt = game.getTickPeriodMs() / 1000.0;
+    Rewinder rewinder(game, rng, (size_t)depth);
+
+    // The last `depth` fingerprints going forward, by tick, and every turn
+    vector<Fingerprint> seen((size_t)depth + 1);
+    vector<Direction> turns;
+    long long checks = 0, mismatches = 0, rewound = 0;
+    double rewindNanos = 0;
+    Fingerprint now, back;
+    Snapshot snap;
+    bool saved = false;
+    long long saveAt = min(100LL, maxTicks / 2), savedAt = 0;
+
+    seen[0].take(game, rng);
+    while (!game.isOver() && game.getTicks() < maxTicks) {
+        Direction turn = pilot->decide(game);
+        turns.push_back(turn);
+        // Snapshots are of a live game: if it ends before saveAt, the
+        // last tick before the end is saved
+        if (!saved && game.getTicks() < saveAt) takeSnapshot(game, rng, seed, snap);
+        clock.advance(dt);
+        rewinder.step(turn);
+        long long t = game.getTicks();
+        seen[t % seen.size()].take(game, rng);
+        if (!saved && t == saveAt && !game.isOver()) takeSnapshot(game, rng, seed, snap);
+        if (!saved && (t == saveAt || game.isOver())) {
+            saved = saveSnapshot(path, snap);
+            savedAt = snap.state.ticks;
+        }
+        if (t % CHECK_EVERY != 0 && !game.isOver()) continue;
+
+        // Back `depth` ticks, compare, then forward again with the same turns
+        now.take(game, rng);
+        auto t0 = chrono::steady_clock::now();
+        long long k = rewinder.rewind(depth);
+        rewindNanos += chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+        rewound += k;
+        back.take(game, rng);
+        checks++;
+        if (!(back == seen[(t - k) % seen.size()])) mismatches++;
+        for (long long i = t - k; i < t; i++) {
+            clock.advance(dt);
+            rewinder.step(turns[i]);
+        }
+        back.take(game, rng);
+        if (!(back == now)) mismatches++;
+        pilot.reset(factory(game).release()); // Drop any plan made for the old timeline
+    }
+
+    // Resume the saved snapshot in a game built with another seed: the
+    // obstacles and generator must come from the file
+    long long resumeChecks = 0, resumeMismatches = 0;
+    Snapshot loaded;
+    if (saved && loadSnapshot(path, loaded)) {
+        SeededRandom rng2(seed ^ 0x5EED);
+        ManualClock clock2;
+        Game resumed(loaded.mode, loaded.map, loaded.difficulty, rng2, clock2, loaded.width, loaded.height);
+        restoreSnapshot(resumed, rng2, loaded);
+        SeededRandom rng3(seed);
+        ManualClock clock3;
+        Game original(mode, mapType, difficulty, rng3, clock3);
+        for (long long i = 0; i < savedAt; i++) {
+            clock3.advance(dt);
+            original.step(turns[i]);
+        }
+        Fingerprint a, b;
+        for (long long i = savedAt; i <= (long long)turns.size(); i++) {
+            a.take(original, rng3);
+            b.take(resumed, rng2);
+            resumeChecks++;
+            if (!(a == b)) resumeMismatches++;
+            if (i == (long long)turns.size()) break;
+            clock2.advance(dt);
+            clock3.advance(dt);
+            original.step(turns[i]);
+            resumed.step(turns[i]);
+        }
+    }
+
+    // Damaged save files: every truncation of the real one, and edits that
+    // put the body, food or an obstacle off the grid or off the map, empty
+    // or break up the body or overlap it. Each must fail to load or to
+    // restore, leaving the game as it was; the edits are also restored
+    // straight from memory.
+    long long corruptFiles = 0, corruptAccepted = 0;
+    if (saved) {
+        const char* badPath = "check_rewind_bad.snap";
+        auto refuses = [&](const Snapshot& bad) {
+            SeededRandom r(seed);
+            ManualClock c;
+            Game g(mode, mapType, difficulty, r, c);
+            Fingerprint before, after;
+            before.take(g, r);
+            bool restored = restoreSnapshot(g, r, bad);
+            after.take(g, r);
+            return !restored && before == after;
+        };
+        auto rejects = [&](const char* file) {
+            Snapshot bad;
+            return !loadSnapshot(file, bad) || refuses(bad);
+        };
+        vector<uint8_t> bytes;
+        if (FILE* f = fopen(path, "rb")) {
+            uint8_t buf[4096];
+            for (size_t n; (n = fread(buf, 1, sizeof(buf), f)) > 0;) bytes.insert(bytes.end(), buf, buf + n);
+            fclose(f);
+        }
+        for (size_t len = 0; len < bytes.size(); len++) {
+            FILE* f = fopen(badPath, "wb");
+            if (!f) break;
+            fwrite(bytes.data(), 1, len, f);
+            fclose(f);
+            corruptFiles++;
+            if (!rejects(badPath)) corruptAccepted++;
+        }
+        int w = snap.width, h = snap.height;
+        const vector<Point>& body = snap.state.body;
+        vector<Snapshot> edits(13, snap);
+        edits[0].state.body[0] = {-1, body[0].y};
+        edits[1].state.body[0] = {w + 5, 0};
+        edits[2].state.body = {{0, 0}}; // A wall on every built-in map
+        edits[2].state.length = 1;
+        edits[3].state.food = {w, h};
+        edits[4].state.food = body[0];
+        edits[5].width = w + 1;
+        edits[6].obstacles.push_back({w, 0});
+        edits[7].state.body.assign((size_t)w * h + 1, {1, 1});
+        edits[8].state.body.clear();
+        edits[9].state.body = {body[0], body[1], body[0]}; // Adjacent, but the head twice
+        edits[9].state.length = 3;
+        edits[10].state.length = (int)body.size() + 2;
+        edits[11].obstacles.push_back(body[1]);
+        edits[12].state.body = {body[0], body[2]}; // A gap; the file stores steps, so only in memory
+        edits[12].state.length = 2;
+        for (size_t i = 0; i < edits.size(); i++) {
+            corruptFiles++;
+            bool fromFile = i + 1 < edits.size();
+            if ((fromFile && (!saveSnapshot(badPath, edits[i]) || !rejects(badPath))) || !refuses(edits[i]))
+                corruptAccepted++;
+        }
+        remove(badPath);
+        remove(path);
+    }
+
+    cout << "ticks:      " << game.getTicks() << " (" << causeName(game.getDeathCause()) << ")\n";
+    cout << "rewinds:    " << checks << " of up to " << depth << " ticks, "
+         << (rewound ? rewindNanos / rewound : 0) << " ns per tick taken back, " << mismatches << " mismatches\n";
+    cout << "snapshot:   " << (saved ? "saved at tick " + to_string(savedAt) : string("not saved")) << ", "
+         << resumeChecks << " ticks compared after resuming, " << resumeMismatches << " mismatches\n";
+    cout << "corrupt:    " << corruptFiles << " damaged save files, " << corruptAccepted << " accepted\n";
+    return mismatches || resumeMismatches || corruptAccepted || !saved ? 2 : 0;
+}
+
+// No tick may touch the allocator
+static int checkAllocations(const vector<GameSpec>& specs, long long maxTicks, const ControllerFactory& factory) {
+    const char* path = "check_alloc.replay";
+    long long ticks = 0, allocating = 0, allocations = 0;
+    for (const GameSpec& spec : specs) {
+        SeededRandom rng(spec.seed);
+        ManualClock clock;
+        unique_ptr<Game> owned(newGame(spec, rng, clock));
+        Game& game = *owned;
+        unique_ptr<Controller> pilot = factory(game);
+        ReplayWriter writer(path, game, rng, spec.seed);
+        AnsiBackend nullSink(NULL);
+        Renderer renderer(game, nullSink);
+        double dt = game.getTickPeriodMs() / 1000.0;
+        while (!game.isOver() && game.getTicks() < maxTicks) {
+            long long before = threadAllocations;
+            clock.advance(dt);
+            game.step(pilot->decide(game));
+            writer.record();
+            drawHud(renderer, game);
+            renderer.present(game);
+            long long n = threadAllocations - before;
+            ticks++;
+            if (n) {
+                if (!allocating)
+                    cout << "first:      seed " << spec.seed << " tick " << game.getTicks() << ", " << n
+                         << " allocations\n";
+                allocating++;
+                allocations += n;
+            }
+        }
+    }
+    remove(path);
+    cout << "games:      " << specs.size() << "\n";
+    cout << "ticks:      " << ticks << "\n";
+    cout << "allocating: " << allocating << " ticks, " << allocations << " allocations\n";
+    return allocating ? 2 : 0;
+}
+
+// Posting a sound must cost the tick nothing, however long it plays
+static int checkAudio(uint32_t seed, GameMode mode, MapType mapType, int difficulty, long long maxTicks,
+                      const ControllerFactory& factory) {
+    const auto pace = chrono::milliseconds(1); // Between ticks, so one tone spans many of them
+    RecordingSink sink(true);
+    AudioQueue audio(sink);
+    Histogram tickNanos[2]; // Silent, with sound
+    long long inlineMs = 0; // What playing the sounds on the tick would have cost
+    for (int loud = 0; loud < 2; loud++) {
+        if (loud) audio.start();
+        SeededRandom rng(seed);
+        ManualClock clock;
+        Game game(mode, mapType, difficulty, rng, clock);
+        unique_ptr<Controller> pilot = factory(game);
+        double dt = game.getTickPeriodMs() / 1000.0;
+        while (!game.isOver() && game.getTicks() < maxTicks) {
+            auto t0 = chrono::steady_clock::now();
+            clock.advance(dt);
+            StepResult r = game.step(pilot->decide(game));
+            if (loud && r.ateFood) { audio.post(SOUND_FOOD); inlineMs += toneOf(SOUND_FOOD).ms; }
+            if (loud && r.died) { audio.post(SOUND_GAMEOVER); inlineMs += toneOf(SOUND_GAMEOVER).ms; }
+            tickNanos[loud].record((uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count());
+            this_thread::sleep_for(pace);
+        }
+    }
+    audio.stop();
+
+    const char* names[] = {"silent:     ", "sound:      "};
+    for (int loud = 0; loud < 2; loud++) {
+        const Histogram& h = tickNanos[loud];
+        cout << names[loud] << h.count() << " ticks, p50 " << h.percentile(0.50) / 1e3 << " us, p99 "
+             << h.percentile(0.99) / 1e3 << " us, max " << h.max() / 1e3 << " us\n";
+    }
+    cout << "audio:      " << audio.getPosted() << " posted, " << audio.getPlayed() << " played, "
+         << audio.getCoalesced() << " coalesced, " << audio.getDropped() << " dropped\n";
+    cout << "inline:     " << inlineMs << " ms of Beep the tick would have waited for\n";
+    // Well under the shortest tone: any tick that waited on the sink fails
+    bool ok = tickNanos[1].max() < (uint64_t)toneOf(SOUND_FOOD).ms * 1000000 / 10 &&
+              (long long)sink.getPlayed().size() == audio.getPlayed() && (audio.getPosted() == 0 || audio.getPlayed() > 0);
+    return ok ? 0 : 2;
+}
+
+// Runs the same batch and arena on 1, 2 and every core and checks the
+// results match bit for bit: every random draw comes from a generator
+// owned by its game (or arena), never from one a thread happens to share
+static int checkThreads(const vector<GameSpec>& specs, long long maxTicks, const ControllerFactory& factory,
+                        ArenaConfig arenaCfg) {
+    int cores = max(4, (int)thread::hardware_concurrency()); // Oversubscribed on small machines, still interleaved
+    int counts[] = {1, 2, cores};
+    int mismatches = 0;
+
+    uint64_t firstDigest = 0;
+    for (int i = 0; i < 3; i++) {
+        BatchRunner runner(specs, factory, maxTicks, counts[i]);
+        BatchStats st = runner.run();
+        if (i == 0) firstDigest = st.digest;
+        bool same = st.digest == firstDigest;
+        mismatches += !same;
+        cout << "batch:      " << counts[i] << " threads, " << st.games << " games, " << st.ticks << " ticks, digest "
+             << hex << st.digest << dec << (same ? "" : "  MISMATCH") << "\n";
+    }
+
+    // A smaller arena than --arena's default, so the check stays quick
+    arenaCfg.width = arenaCfg.height = min(arenaCfg.width, 256);
+    arenaCfg.snakes = min(arenaCfg.snakes, 200);
+    arenaCfg.obstacles = arenaCfg.width * arenaCfg.height / 1000;
+    uint64_t firstHash = 0;
+    for (int i = 0; i < 3; i++) {
+        Arena arena(arenaCfg, counts[i]);
+        for (int t = 0; t < 300; t++) arena.tick();
+        if (i == 0) firstHash = arena.hash();
+        bool same = arena.hash() == firstHash;
+        mismatches += !same;
+        cout << "arena:      " << counts[i] << " threads, " << arenaCfg.snakes << " snakes, hash " << hex
+             << arena.hash() << dec << (same ? "" : "  MISMATCH") << "\n";
+    }
+    cout << "mismatches: " << mismatches << "\n";
+    return mismatches ? 2 : 0;
+}
+
+// Open-world pilot: toward the nearest food in sight, else straight on,
+// never into a wall or the body, and not into a cell with no way out
+static Direction worldPilot(World& w) {
+    const int SIGHT = 8;
+    static const Direction dirs[] = {UP, RIGHT, DOWN, LEFT};
+    static const int dx[] = {0, 1, 0, -1}, dy[] = {-1, 0, 1, 0};
+    auto open = [&](int x, int y) { Cell c = w.cell(x, y); return c == CELL_FREE || c == CELL_FOOD; };
+    Point h = w.getHead();
+    Point food = {0, 0};
+    int nearest = -1;
+    for (int y = -SIGHT; y <= SIGHT; y++)
+        for (int x = -SIGHT; x <= SIGHT; x++)
+            if (w.cell(h.x + x, h.y + y) == CELL_FOOD && (nearest < 0 || abs(x) + abs(y) < nearest)) {
+                nearest = abs(x) + abs(y);
+                food = {h.x + x, h.y + y};
+            }
+
+    Direction cur = w.getDirection(), pick = cur;
+    long long best = LLONG_MIN;
+    for (int k = 0; k < 4; k++) {
+        if (dirs[k] == dirs[(find(dirs, dirs + 4, cur) - dirs + 2) % 4]) continue; // Reverse
+        int nx = h.x + dx[k], ny = h.y + dy[k];
+        if (!open(nx, ny)) continue;
+        int exits = 0;
+        for (int j = 0; j < 4; j++) exits += open(nx + dx[j], ny + dy[j]);
+        long long score = exits ? 0 : -1000000;
+        score += nearest >= 0 ? -10LL * (abs(food.x - nx) + abs(food.y - ny)) : (dirs[k] == cur ? 1 : 0);
+        if (score > best) { best = score; pick = dirs[k]; }
+    }
+    return pick;
+}
+
+// The endless world, headless or on the terminal
+static int playWorld(const WorldConfig& cfg, long long maxTicks, bool watch, bool human, double fps) {
+    World world(cfg);
+    Histogram tickNanos;
+    AnsiBackend ansi(stdout);
+    WorldView view(ansi, 78, 22);
+    InputReader keys;
+    TurnCoalescer turns;
+    if (human) keys.start();
+
+    auto tick = [&]() {
+        Direction turn;
+        if (human) {
+            turns.begin(world.getDirection());
+            KeyEvent e;
+            while (keys.poll(e)) turns.add(e);
+            if (turns.quitRequested()) { world.quit(); return false; }
+            turn = turns.turn();
+        } else {
+            turn = worldPilot(world);
+        }
+        auto t0 = chrono::steady_clock::now();
+        world.step(turn);
+        tickNanos.record((uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count());
+        return !world.isOver() && world.getStats().ticks < maxTicks;
+    };
+    if (watch) {
+        fputs("\x1b[2J\x1b[?25l", stdout);
+        TickScheduler scheduler(0.06, fps);
+        scheduler.run(tick, [&]() {
+            int col = view.putNumber(view.putText(0, 0, " WORLD | SCORE: ", 14), 0, world.getScore(), 14);
+            col = view.putNumber(view.putText(col, 0, " | AT ", 14), 0, world.getHead().x, 14);
+            col = view.putNumber(view.putText(col, 0, ",", 14), 0, world.getHead().y, 14);
+            view.clearRow(col, 0);
+            view.putRun(view.putText(0, 1, " ", 8), 1, '-', 78, 8);
+            view.present(world);
+        });
+        printf("\x1b[0m\x1b[?25h\x1b[%d;1H", view.getRows() + 1);
+    } else {
+        while (tick()) {}
+    }
+    keys.stop();
+
+    const WorldStats& st = world.getStats();
+    uint64_t hash = 1469598103934665603ULL;
+    for (long long v : {st.ticks, (long long)world.getScore(), (long long)world.getLength(), (long long)world.getHead().x,
+                        (long long)world.getHead().y, st.evictions, st.generated + st.prefetched})
+        hash = (hash ^ (uint64_t)v) * 1099511628211ULL;
+    cout << "world:      seed " << cfg.seed << ", cache " << cfg.cacheChunks << " chunks of " << World::CHUNK << "x"
+         << World::CHUNK << ", prefetch " << (cfg.prefetch ? "on" : "off") << "\n";
+    cout << "ticks:      " << st.ticks << " (" << causeName(world.getDeathCause()) << ")\n";
+    cout << "score:      " << world.getScore() << ", length " << world.getLength() << ", farthest "
+         << st.farthest << " cells from the start\n";
+    cout << "tick time:  p50 " << tickNanos.percentile(0.50) / 1e3 << " us, p99 " << tickNanos.percentile(0.99) / 1e3
+         << " us, max " << tickNanos.max() / 1e3 << " us\n";
+    cout << "chunks:     " << st.generated << " generated on the tick, " << st.prefetched << " prefetched, "
+         << st.evictions << " evicted, " << st.peakChunks << " resident at most\n";
+    cout << "memory:     " << world.memoryBytes() / 1024 << " KB of chunk cache\n";
+    cout << "hash:       " << hex << hash << dec << "\n";
+    return 0;
+}
+
+// Draws a server client's copy of the board, like Renderer does a Game
+class RemoteView : public Screen {
+public:
+    RemoteView(RenderBackend& backend, int w, int h) : Screen(backend, max(1 + w, 80), 2 + h) {}
+
+    void present(const ClientView& v) {
+        auto t0 = chrono::steady_clock::now();
+        int col = putText(0, 0, " SERVER | SCORE: ", 14);
+        col = putText(putNumber(col, 0, v.score, 14), 0, " ", 14);
+        if (v.timeLeft > 0) col = putText(putNumber(putText(col, 0, "| TIME: ", 11), 0, (int)v.timeLeft, 11), 0, "s", 11);
+        clearRow(col, 0);
+        putRun(putText(0, 1, " ", 8), 1, '-', v.width, 8);
+        for (int y = 0; y < v.height; y++) {
+            for (int x = 0; x < v.width; x++) {
+                ScreenCell c = {' ', 7};
+                switch (v.cells[(size_t)y * v.width + x]) {
+                    case CELL_VOID: c = {'.', 8}; break;
+                    case CELL_OBSTACLE: c = {'X', 4}; break;
+                    case CELL_BODY: c = (v.head.x == x && v.head.y == y) ? ScreenCell{'O', 10} : ScreenCell{'o', 2}; break;
+                    case CELL_FOOD: c = {'@', 13}; break;
+                }
+                put(1 + x, 2 + y, c.glyph, c.color);
+            }
+        }
+        flushFrame(t0);
+    }
+};
+
+// Bots (one per spec) plus any clients that connect to `path` (NULL
+// for bots only), for `seconds`
+static int serveSessions(const char* path, const vector<GameSpec>& bots, double seconds, int threads,
+                         const ControllerFactory& factory) {
+    ServerConfig cfg;
+    cfg.threads = threads;
+    cfg.maxSessions = (int)bots.size() + 1024;
+    SessionServer server(cfg, factory);
+    string error;
+    if (path && !server.listen(path, error)) {
+        cerr << "cannot listen on " << path << ": " << error << "\n";
+        return 1;
+    }
+    for (const GameSpec& spec : bots) server.addBot(spec);
+    server.run(seconds);
+
+    const ServerStats& st = server.getStats();
+    const Histogram& late = st.lateNanos;
+    cout << "server:     " << (path ? path : "bots only") << ", " << server.getThreads() << " threads, "
+         << st.seconds << " s\n";
+    cout << "sessions:   " << bots.size() << " bots, " << st.joined << " clients (" << st.rejected
+         << " rejected), peak " << st.peak << " live\n";
+    cout << "ticks:      " << st.ticks << " (" << (long long)(st.seconds > 0 ? st.ticks / st.seconds : 0)
+         << "/sec), busy " << (st.seconds > 0 ? 100 * st.busySeconds / st.seconds : 0) << "%\n";
+    cout << "lateness:   p50 " << late.percentile(0.50) / 1e6 << " ms, p90 " << late.percentile(0.90) / 1e6
+         << " ms, p99 " << late.percentile(0.99) / 1e6 << " ms, p99.9 " << late.percentile(0.999) / 1e6
+         << " ms, max " << late.max() / 1e6 << " ms\n";
+    cout << "overruns:   " << st.overruns << " (" << st.dropped << " ticks dropped)\n";
+    cout << "frames:     " << st.frames << " (" << st.keyframes << " whole), " << st.skipped
+         << " skipped on full sockets, " << st.bytes / 1024 << " KB\n";
+    cout << "games:      " << st.games << " finished\n";
+    return 0;
+}
+
+// Plays `maxTicks` ticks (or to the end) as one client: greedy unless a
+// human steers. Exits 2 if the board copy ends up unlike the server's,
+// 1 if the server went away before the game ended.
+// `stallAfter` stops reading for a while after that many frames (for
+// --check-server: before its first turn the snake stands still, so the
+// stall fills the socket without ending the game).
+static int playClient(const char* path, const GameSpec& spec, long long maxTicks, bool watch, bool human,
+                      long long stallAfter = -1, bool quiet = false) {
+    ServerClient client;
+    string error;
+    if (!client.connect(path, error) || !client.join(spec.mode, spec.map, spec.difficulty, spec.seed)) {
+        cerr << "cannot join " << path << ": " << (error.empty() ? "connection lost" : error) << "\n";
+        return 1;
+    }
+    const ClientView& v = client.getView();
+    AnsiBackend ansi(watch ? stdout : NULL);
+    unique_ptr<RemoteView> screen;
+    InputReader keys;
+    if (human) keys.start();
+    if (watch) fputs("\x1b[2J\x1b[?25l", stdout);
+
+    long long shown = -1;
+    bool quitting = false;
+    while (client.pump(5) && !v.over) {
+        if (v.frames > 0 && v.tick != shown) {
+            shown = v.tick;
+            if (v.frames == stallAfter) this_thread::sleep_for(chrono::milliseconds(1500));
+            if (!human) {
+                Direction d = greedyToward(v.head, v.food, v.dir, [&v](int x, int y) { return v.blocked(x, y); });
+                if (d != v.dir) client.turn(d);
+            }
+            if (watch) {
+                if (!screen) screen.reset(new RemoteView(ansi, v.width, v.height));
+                screen->present(v);
+            }
+            if (!quitting && v.tick >= maxTicks) quitting = client.quit();
+        }
+        KeyEvent e;
+        while (keys.poll(e)) {
+            Direction d = e.key == 'w' ? UP : e.key == 'a' ? LEFT : e.key == 's' ? DOWN : e.key == 'd' ? RIGHT : STOP;
+            if (e.key == 'x') quitting = client.quit();
+            else if (d != STOP) client.turn(d);
+        }
+    }
+    keys.stop();
+    while (!v.over && client.pump(100)) {} // The last frames after a quit
+
+    if (watch) printf("\x1b[0m\x1b[?25h\x1b[%d;1H", v.height + 3);
+    bool same = v.over && v.endHash == v.hash();
+    if (!quiet) {
+        cout << "session:    " << v.session << " (" << v.width << "x" << v.height << ", " << v.tickMs << " ms ticks)\n";
+        cout << "score:      " << v.score << "  ticks: " << v.tick << "  cause: " << (v.over ? causeName(v.cause) : "lost") << "\n";
+        cout << "frames:     " << v.frames << " (" << v.keyframes << " whole), " << v.bytes << " bytes\n";
+        cout << "board:      "
+             << (!v.over ? "not checked: the server closed first" : same ? "matches the server" : "DIFFERS from the server")
+             << "\n";
+    }
+    return !v.over ? 1 : same ? 0 : 2;
+}
+
+// A server with bots and `clients` socket clients: every client's copy
+// of the board must end up as the server's, including the one that stops
+// reading for a while (small send buffers make its socket fill up)
+static int checkServer(uint32_t seed, int bots, int clients, long long maxTicks, const ControllerFactory& factory) {
+    static const char* SOCKET_PATH = "sim_check_server.sock";
+    ServerConfig cfg;
+    cfg.maxSessions = bots + clients;
+    cfg.sendBuffer = 4096;
+    SessionServer server(cfg, factory);
+    string error;
+    if (!server.listen(SOCKET_PATH, error)) {
+        cerr << "cannot listen on " << SOCKET_PATH << ": " << error << "\n";
+        return 1;
+    }
+    for (int b = 0; b < bots; b++) {
+        GameSpec spec;
+        spec.seed = seed + 1000 + b;
+        spec.map = (MapType)(1 + b % 3);
+        spec.difficulty = 1 + b / 3 % 3;
+        spec.mode = CLASSIC;
+        server.addBot(spec);
+    }
+    thread host([&server]() { server.run(0); });
+
+    vector<int> results(clients);
+    vector<thread> players;
+    for (int c = 0; c < clients; c++) {
+        players.emplace_back([&, c]() {
+            GameSpec spec;
+            spec.seed = seed + c;
+            spec.map = (MapType)(1 + c % 3);
+            spec.difficulty = c == 0 ? 3 : 1 + c / 3 % 3;
+            spec.mode = c % 2 ? TIME_ATTACK : CLASSIC;
+            results[c] = playClient(SOCKET_PATH, spec, maxTicks, false, false, c == 0 ? 1 : -1, true);
+        });
+    }
+    for (auto& t : players) t.join();
+    server.stop();
+    host.join();
+
+    int failed = 0;
+    for (int r : results) failed += r != 0;
+    const ServerStats& st = server.getStats();
+    cout << "clients:    " << clients << " (" << st.joined << " joined), " << failed << " out of sync\n";
+    cout << "bots:       " << bots << ", " << st.games << " games finished\n";
+    cout << "frames:     " << st.frames << " (" << st.keyframes << " whole), " << st.skipped
+         << " skipped on full sockets\n";
+    cout << "lateness:   p50 " << st.lateNanos.percentile(0.50) / 1e6 << " ms, p99 "
+         << st.lateNanos.percentile(0.99) / 1e6 << " ms, max " << st.lateNanos.max() / 1e6 << " ms\n";
+    return failed ? 2 : 0;
+}
+
+// The many-snake arena at a fixed tick rate
+static int playArena(const ArenaConfig& cfg, double tickMs, long long maxTicks, int threads) {
+    Arena arena(cfg, threads);
+    Histogram tickNanos;
+    TickScheduler scheduler(tickMs / 1000.0, 0);
+    scheduler.run(
+        [&]() {
+            auto t0 = chrono::steady_clock::now();
+            arena.tick();
+            tickNanos.record((uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count());
+            return arena.getStats().ticks < maxTicks;
+        },
+        []() {});
+
+    const ArenaStats& st = arena.getStats();
+    cout << "arena:      " << arena.getWidth() << "x" << arena.getHeight() << ", " << cfg.snakes << " snakes, "
+         << cfg.food << " food, " << arena.getThreads() << " threads, " << arena.getStrips() << " strips\n";
+    cout << "tick time:  mean " << tickNanos.mean() / 1e6 << " ms, p50 " << tickNanos.percentile(0.50) / 1e6
+         << " ms, p99 " << tickNanos.percentile(0.99) / 1e6 << " ms, max " << tickNanos.max() / 1e6 << " ms\n";
+    printTiming(scheduler.getStats(), tickMs / 1000.0);
+    cout << "alive:      " << st.alive << " (longest " << st.longest << ")\n";
+    cout << "eaten:      " << st.eaten << "\n";
+    cout << "deaths:     " << st.hitWall << " wall, " << st.hitBody << " body, " << st.headOn << " head-on ("
+         << st.respawns << " respawns)\n";
+    cout << "hash:       " << hex << arena.hash() << dec << "\n";
+    return 0;
+}
+
+// One game at real speed: ticks on the scheduler, frames at `fps`.
+// `human` steers from the keyboard instead of the controller.
+static int playRealtime(uint32_t seed, GameMode mode, MapType mapType, int difficulty, long long maxTicks,
+                        bool watch, bool human, double fps, int load, const ControllerFactory& factory,
+                        const char* metricsPath) {
+    SeededRandom rng(seed);
+    ManualClock clock;
+    Game game(mode, mapType, difficulty, rng, clock);
+    unique_ptr<Controller> pilot = factory(game);
+    AnsiBackend ansi(watch ? stdout : NULL);
+    Renderer renderer(game, ansi);
+    double dt = game.getTickPeriodMs() / 1000.0;
+
+    atomic<bool> stop(false);
+    vector<thread> burners;
+    for (int i = 0; i < load; i++)
+        burners.emplace_back([&stop]() { while (!stop.load(memory_order_relaxed)) {} });
+
+    InputReader keys;
+    TurnCoalescer turns;
+    LatencyStats latency;
+    int64_t unshown = 0;
+    BellSink bell;
+    AudioQueue audio(bell);
+    if (human) {
+        keys.start();
+        audio.start();
+    }
+
+    Metrics metrics;
+    unique_ptr<MetricsSession> session;
+    if (metricsPath) session.reset(new MetricsSession(metrics));
+
+    if (watch) fputs("\x1b[2J\x1b[?25l", stdout);
+    TickScheduler scheduler(dt, fps);
+    scheduler.run(
+        [&]() {
+            Direction turn;
+            if (human) {
+                SNAKE_PHASE(PHASE_INPUT);
+                turns.begin(game.getSnake()->getDirection());
+                KeyEvent e;
+                while (keys.poll(e)) turns.add(e);
+                if (turns.quitRequested()) { game.quit(); return false; }
+                turn = turns.turn();
+                if (turn != STOP && !unshown) unshown = turns.turnStamp();
+            } else {
+                turn = pilot->decide(game);
+            }
+            clock.advance(dt);
+            StepResult r = game.step(turn);
+            if (human && r.ateFood) audio.post(SOUND_FOOD);
+            if (human && r.died) audio.post(SOUND_GAMEOVER);
+            return !game.isOver() && game.getTicks() < maxTicks;
+        },
+        [&]() {
+            drawHud(renderer, game);
+            renderer.present(game);
+            if (unshown) { latency.add((steadyNanos() - unshown) / 1e9); unshown = 0; }
+        });
+    keys.stop();
+    audio.stop();
+    session.reset();
+    stop = true;
+    for (auto& t : burners) t.join();
+
+    if (watch) printf("\x1b[0m\x1b[?25h\x1b[%d;1H", renderer.getRows() + 1);
+    cout << "score: " << game.getScore() << "  ticks: " << game.getTicks() << "\n";
+    printTiming(scheduler.getStats(), dt);
+    if (human)
+        cout << "latency:    avg " << latency.avg() * 1e3 << " ms, max " << latency.max * 1e3 << " ms over "
+             << latency.count << " turns (" << keys.getDropped() << " keys dropped)\n";
+    return metricsPath ? reportMetrics(metrics, metricsPath) : 0;
+}
+
+static int playReplay(const char* path, long long seekTo, bool watch) {
+    ReplayPlayer player(path);
+    if (!player.isOpen()) { cerr << "cannot read replay " << path << "\n"; return 1; }
+    const ReplayHeader& h = player.getHeader();
+    Game& game = player.getGame();
+
+    if (watch) {
+        AnsiBackend ansi(stdout);
+        Renderer renderer(game, ansi);
+        if (seekTo > 0) player.seek(seekTo);
+        fputs("\x1b[2J\x1b[?25l", stdout);
+        TickScheduler scheduler(game.getTickPeriodMs() / 1000.0, 0);
+        scheduler.run([&]() { return player.step(); },
+                      [&]() {
+                          drawHud(renderer, game);
+                          renderer.present(game);
+                      });
+        printf("\x1b[0m\x1b[?25h\x1b[%d;1H", renderer.getRows() + 1);
+        cout << "score: " << game.getScore() << "  ticks: " << game.getTicks() << "\n";
+        return 0;
+    }
+
+    // Straight playback, keeping a state every few ticks to seek back to
+    vector<GameState> samples;
+    int every = max(1, h.interval / 3);
+    auto t0 = chrono::steady_clock::now();
+    do {
+        if (game.getTicks() % every == 0) {
+            samples.push_back(GameState());
+            game.saveState(samples.back());
+        }
+    } while (player.step());
+    double playSecs = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    long long ticks = game.getTicks();
+    int score = game.getScore();
+    DeathCause cause = game.getDeathCause();
+
+    int mismatches = 0;
+    GameState got;
+    t0 = chrono::steady_clock::now();
+    for (size_t i = samples.size(); i-- > 0;) {
+        player.seek(samples[i].ticks);
+        game.saveState(got);
+        if (!sameState(got, samples[i])) mismatches++;
+    }
+    double seekSecs = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    cout << "seed:       " << h.seed << " (map " << h.map << ", difficulty " << h.difficulty
+         << ", mode " << h.mode << ")\n";
+    cout << "file:       " << player.getFileBytes() << " bytes, " << player.getKeyframes() << " keyframes\n";
+    cout << "ticks:      " << ticks << " (recorded " << player.getEndTick() << ")\n";
+    cout << "score:      " << score << "\n";
+    cout << "cause:      " << causeName(cause) << " (recorded " << causeName(player.getEndCause()) << ")\n";
+    cout << "playback:   " << (long long)(playSecs > 0 ? ticks / playSecs : 0) << " ticks/sec\n";
+    cout << "seeks:      " << samples.size() << ", " << (samples.empty() ? 0 : seekSecs * 1e6 / samples.size())
+         << " us each, " << mismatches << " mismatches\n";
+    if (seekTo > 0) {
+        bool ok = player.seek(seekTo);
+        cout << "at tick " << game.getTicks() << (ok ? "" : " (end)") << ": score " << game.getScore()
+             << ", length " << game.getSnake()->getLength() << "\n";
+    }
+    return mismatches ? 2 : 0;
+}
+
+int main(int argc, char** argv) {
+    long long games = 1000;
+    uint32_t seed = 1;
+    int mapArg = RECTANGLE;
+    int difficulty = 2;
+    int threads = 0;
+    GameMode mode = CLASSIC;
+    long long maxTicks = 0; // Default depends on the mode
+    bool render = false, renderFull = false, watch = false, realtime = false, human = false;
+    double fps = 60;
+    int load = 0;
+    const char* recordPath = NULL;
+    const char* replayPath = NULL;
+    long long seekTo = 0;
+    bool autopilot = false;
+    double budgetMicros = 1000;
+    const char* metricsPath = NULL;
+    bool arena = false;
+    const char* mapFile = NULL;
+    const char* genMapPath = NULL;
+    double density = 0.1;
+    bool world = false;
+    WorldConfig worldCfg;
+    bool checkRewinds = false, checkAllocs = false, checkSound = false, checkThreadCounts = false;
+    long long rewindDepth = 300;
+    ArenaConfig arenaCfg;
+    double tickMs = 50;
+    const char* servePath = NULL;
+    const char* connectPath = NULL;
+    bool checkServers = false;
+    int sessions = -1; // Bots; the default depends on the mode
+    double seconds = 10;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--games" && hasValue) games = atoll(argv[++i]);
+        else if (arg == "--seed" && hasValue) seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+        else if (arg == "--map" && hasValue) mapArg = parseMap(argv[++i]);
+        else if (arg == "--map-file" && hasValue) mapFile = argv[++i];
+        else if (arg == "--gen-map" && hasValue) genMapPath = argv[++i];
+        else if (arg == "--density" && hasValue) density = atof(argv[++i]);
+        else if (arg == "--difficulty" && hasValue) difficulty = atoi(argv[++i]); // "all" parses as 0
+        else if (arg == "--threads" && hasValue) threads = atoi(argv[++i]);
+        else if (arg == "--mode" && hasValue) mode = (string(argv[++i]) == "time") ? TIME_ATTACK : CLASSIC;
+        else if (arg == "--max-ticks" && hasValue) maxTicks = atoll(argv[++i]);
+        else if (arg == "--render") render = true;
+        else if (arg == "--render-full") render = renderFull = true;
+        else if (arg == "--watch") watch = true;
+        else if (arg == "--realtime") realtime = true;
+        else if (arg == "--play") watch = human = true;
+        else if (arg == "--fps" && hasValue) fps = atof(argv[++i]);
+        else if (arg == "--load" && hasValue) load = atoi(argv[++i]);
+        else if (arg == "--record" && hasValue) recordPath = argv[++i];
+        else if (arg == "--replay" && hasValue) replayPath = argv[++i];
+        else if (arg == "--seek" && hasValue) seekTo = atoll(argv[++i]);
+        else if (arg == "--policy" && hasValue) autopilot = string(argv[++i]) == "auto";
+        else if (arg == "--budget-us" && hasValue) budgetMicros = atof(argv[++i]);
+        else if (arg == "--metrics" && hasValue) metricsPath = argv[++i];
+        else if (arg == "--check-rewind") checkRewinds = true;
+        else if (arg == "--check-alloc") checkAllocs = true;
+        else if (arg == "--check-audio") checkSound = true;
+        else if (arg == "--check-threads") checkThreadCounts = true;
+        else if (arg == "--rewind" && hasValue) rewindDepth = max(1LL, atoll(argv[++i]));
+        else if (arg == "--arena") arena = true;
+        else if (arg == "--world") world = true;
+        else if (arg == "--cache" && hasValue) worldCfg.cacheChunks = atoi(argv[++i]);
+        else if (arg == "--prefetch") worldCfg.prefetch = true;
+        else if (arg == "--snakes" && hasValue) arenaCfg.snakes = atoi(argv[++i]);
+        else if (arg == "--size" && hasValue) arenaCfg.width = arenaCfg.height = atoi(argv[++i]);
+        else if (arg == "--food" && hasValue) arenaCfg.food = atoi(argv[++i]);
+        else if (arg == "--tick-ms" && hasValue) tickMs = atof(argv[++i]);
+        else if (arg == "--serve" && hasValue) servePath = argv[++i];
+        else if (arg == "--connect" && hasValue) connectPath = argv[++i];
+        else if (arg == "--check-server") checkServers = true;
+        else if (arg == "--sessions" && hasValue) sessions = atoi(argv[++i]);
+        else if (arg == "--seconds" && hasValue) seconds = atof(argv[++i]);
+        else {
+            cerr << "usage: " << argv[0] << " [--games N] [--seed S] [--map rect|circle|triangle|all]"
+                 << " [--difficulty 1-3|all] [--mode classic|time] [--max-ticks T]"
+                 << " [--threads N] [--render] [--render-full] [--watch | --realtime | --play [--fps F] [--load N]]"
+                 << " [--record FILE] [--replay FILE [--seek T]] [--policy greedy|auto] [--budget-us U] [--metrics FILE]"
+                 << " [--check-rewind [--rewind T]] [--check-alloc] [--check-audio] [--check-threads] [--map-file FILE] [--gen-map FILE [--density D]] [--world [--cache C] [--prefetch]] [--arena [--snakes N] [--size S] [--food F] [--tick-ms M]]"
+                 << " [--serve PATH|- [--sessions N] [--seconds S]] [--connect PATH] [--check-server [--sessions N]]\n";
+            return 1;
+        }
+    }
+
+    if (!maxTicks) maxTicks = arena ? 1000 : checkSound ? 3000 : checkServers ? 60 : 100000;
+    if (servePath) games = max(0, sessions);
+    if (genMapPath) return generateMapFile(genMapPath, (MapType)(mapArg ? mapArg : RECTANGLE), arenaCfg.width, density, seed);
+    if (world) {
+        worldCfg.seed = seed;
+        return playWorld(worldCfg, maxTicks, watch, human, fps);
+    }
+    if (arena) {
+        arenaCfg.seed = seed;
+        arenaCfg.obstacles = arenaCfg.width * arenaCfg.height / 1000;
+        return playArena(arenaCfg, tickMs, maxTicks, threads);
+    }
+
+    MapData layout;
+    if (mapFile) {
+        string error;
+        long long sealed = 0;
+        if (!loadMapFile(mapFile, layout, error, &sealed)) {
+            cerr << mapFile << ": " << error << "\n";
+            return 1;
+        }
+        if (recordPath || replayPath || checkRewinds || checkSound || watch || realtime || connectPath || checkServers) {
+            cerr << "--map-file plays batches, --render, --check-alloc, --check-threads and --serve bots only\n";
+            return 1;
+        }
+        if (sealed) cerr << mapFile << ": filled " << sealed << " floor cells cut off from the spawn\n";
+    }
+
+    vector<GameSpec> specs;
+    for (long long g = 0; g < games; g++) {
+        GameSpec spec;
+        spec.seed = seed + (uint32_t)g;
+        spec.map = mapFile ? CUSTOM : (MapType)(mapArg ? mapArg : 1 + g % 3);
+        spec.layout = mapFile ? &layout : NULL;
+        spec.difficulty = difficulty ? difficulty : 1 + (int)(g / 3 % 3);
+        spec.mode = mode;
+        specs.push_back(spec);
+    }
+    MapType mapType = specs.empty() ? RECTANGLE : specs[0].map;
+    if (difficulty == 0) difficulty = specs.empty() ? 2 : specs[0].difficulty;
+
+    ControllerFactory factory = makeFactory(autopilot, budgetMicros);
+    if (servePath) return serveSessions(strcmp(servePath, "-") ? servePath : NULL, specs, seconds, threads, factory);
+    if (connectPath) {
+        GameSpec spec;
+        spec.seed = seed;
+        spec.map = mapType;
+        spec.difficulty = difficulty;
+        spec.mode = mode;
+        return playClient(connectPath, spec, maxTicks, watch, human);
+    }
+    if (checkServers) return checkServer(seed, sessions < 0 ? 200 : sessions, 8, maxTicks, factory);
+    if (replayPath) return playReplay(replayPath, seekTo, watch);
+    if (recordPath) return recordGame(recordPath, seed, mode, mapType, difficulty, maxTicks, factory);
+
+    if (checkRewinds) return checkRewind(seed, mode, mapType, difficulty, maxTicks, rewindDepth, factory);
+    if (checkAllocs) return checkAllocations(specs, maxTicks, factory);
+    if (checkThreadCounts) {
+        arenaCfg.seed = seed;
+        return checkThreads(specs, maxTicks, factory, arenaCfg);
+    }
+    if (checkSound) return checkAudio(seed, mode, mapType, difficulty, maxTicks, factory);
+    if (watch || realtime)
+        return playRealtime(seed, mode, mapType, difficulty, maxTicks, watch, human, fps, load, factory,
+                            metricsPath);
+
+    if (!render) {
+        BatchRunner runner(specs, factory, maxTicks, threads);
+        runner.setMetrics(metricsPath != NULL);
+        BatchStats st = runner.run();
+        double secs = runner.getElapsed();
+
+        cout << "threads:    " << runner.getThreads() << " (" << st.steals << " steals)\n";
+        cout << "games:      " << st.games << "\n";
+        cout << "ticks:      " << st.ticks << "\n";
+        cout << "elapsed:    " << secs << " s\n";
+        cout << "games/sec:  " << (long long)(secs > 0 ? st.games / secs : 0) << "\n";
+        cout << "ticks/sec:  " << (long long)(secs > 0 ? st.ticks / secs : 0) << "\n";
+        cout << "avg score:  " << (st.games > 0 ? double(st.scoreSum) / st.games : 0) << "\n";
+        cout << "avg length: " << (st.games > 0 ? double(st.lengthSum) / st.games : 0) << "\n";
+        cout << "best score: " << st.bestScore << "\n";
+        for (int c = 0; c <= WON; c++)
+            if (st.deaths[c]) cout << "  " << causeName(c) << ": " << st.deaths[c] << "\n";
+        static const char* mapNames[] = {"", "rect", "circle", "triangle", "custom"};
+        for (int m = RECTANGLE; m <= CUSTOM; m++) {
+            if (!st.mapGames[m]) continue;
+            cout << "win rate:   " << mapNames[m] << " " << 100.0 * st.mapWins[m] / st.mapGames[m] << "% ("
+                 << st.mapWins[m] << "/" << st.mapGames[m] << ")";
+            const Histogram& h = st.decideNanos[m];
+            if (h.count())
+                cout << ", decide p50 " << h.percentile(0.50) / 1e3 << " us, p90 " << h.percentile(0.90) / 1e3
+                     << " us, p99 " << h.percentile(0.99) / 1e3 << " us, max " << h.max() / 1e3 << " us";
+            cout << "\n";
+        }
+        if (autopilot)
+            cout << "planning:   " << st.plans << " searches, " << st.planReuses << " ticks from cache, "
+                 << st.fallbacks << " fallbacks, " << st.overBudget << " over budget\n";
+        return metricsPath ? reportMetrics(st.metrics, metricsPath) : 0;
+    }
+
+    // Rendering runs serially so the frame counters are not shared
+    long long totalTicks = 0;
+    long long totalScore = 0;
+    int bestScore = 0;
+    long long frames = 0;
+    double frameBytes = 0, frameNanos = 0;
+
+    auto start = chrono::steady_clock::now();
+    for (const GameSpec& spec : specs) {
+        SeededRandom rng(spec.seed);
+        ManualClock clock;
+        unique_ptr<Game> owned(newGame(spec, rng, clock));
+        Game& game = *owned;
+        unique_ptr<Controller> pilot = factory(game);
+        double dt = game.getTickPeriodMs() / 1000.0;
+
+        AnsiBackend nullSink(NULL);
+        Renderer renderer(game, nullSink);
+        while (!game.isOver() && game.getTicks() < maxTicks) {
+            clock.advance(dt);
+            game.step(pilot->decide(game));
+            if (renderFull) renderer.invalidate();
+            drawHud(renderer, game);
+            renderer.present(game);
+        }
+        frames += renderer.getFrames();
+        frameBytes += renderer.getAvgFrameBytes() * renderer.getFrames();
+        frameNanos += renderer.getAvgFrameNanos() * renderer.getFrames();
+
+        totalTicks += game.getTicks();
+        totalScore += game.getScore();
+        if (game.getScore() > bestScore) bestScore = game.getScore();
+    }
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "games:      " << games << "\n";
+    cout << "ticks:      " << totalTicks << "\n";
+    cout << "elapsed:    " << secs << " s\n";
+    cout << "ticks/sec:  " << (long long)(secs > 0 ? totalTicks / secs : 0) << "\n";
+    cout << "avg score:  " << (games > 0 ? double(totalScore) / games : 0) << "\n";
+    cout << "best score: " << bestScore << "\n";
+    cout << "frames:     " << frames << "\n";
+    cout << "bytes/frame: " << (frames ? frameBytes / frames : 0) << "\n";
+    cout << "ns/frame:   " << (frames ? frameNanos / frames : 0) << "\n";
+    return 0;
+}
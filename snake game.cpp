@@ -5,31 +5,32 @@
 #include <vector>
 #include <string>
 #include <queue>
-#include <stack>
-#include <cmath>
 #include <algorithm> // For find_if
+#include "engine.h"
+#include "render.h"
+#include "replay.h"
+#include "scheduler.h"
+#include "input.h"
+#include "autopilot.h"
+#include "leaderboard.h"
+#include "rewind.h"
+#include "audio.h"
+#include "world.h"
 
 using namespace std;
 
-// ==========================================
-//        DATA STRUCTURES & UTILS
-// ==========================================
-
-struct Point {
-    int x, y;
-    bool operator==(const Point& other) const { return x == other.x && y == other.y; }
-};
+const char* REPLAY_FILE = "last_game.replay";
+const char* METRICS_JSON = "last_game_metrics.json";
+const char* METRICS_CSV = "last_game_metrics.csv";
+const char* LEADERBOARD_BASE = "leaderboard"; // leaderboard.log + leaderboard.idx
+const char* SAVE_FILE = "saved_game.snap";     // 'p' saves here; the menu offers to resume it
+const double REWIND_SECONDS = 3;               // Taken back per 'b' press
 
-enum Direction { STOP = 0, LEFT, RIGHT, UP, DOWN };
-enum GameMode { CLASSIC = 1, TIME_ATTACK = 2 };
-enum MapType { RECTANGLE = 1, CIRCLE = 2, TRIANGLE = 3 };
-
-// ----- CONSOLE UTILS -----
-void moveCursorToTopLeft() {
-    COORD coord = {0, 0};
-    SetConsoleCursorPosition(GetStdHandle(STD_OUTPUT_HANDLE), coord);
-}
+SNAKE_DEFINE_ALLOCATION_COUNTER()
 
+// ==========================================
+//             CONSOLE UTILS
+// ==========================================
 void setColor(int color) {
     SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), color);
 }
@@ -48,451 +49,207 @@ void centerText(const string& text, int consoleWidth) {
     cout << string(padding, ' ') << text << "\n";
 }
 
-void playSound(const string& event) {
-    if (event == "food") Beep(1000, 100);
-    else if (event == "gameover") Beep(300, 400);
+// For "0 = random": the clock, which the generator's seeding stirs well
+uint32_t freshSeed() {
+    uint64_t ns = (uint64_t)chrono::steady_clock::now().time_since_epoch().count() ^ (uint64_t)time(0);
+    uint32_t seed = (uint32_t)(ns ^ (ns >> 32));
+    return seed ? seed : 1;
 }
 
-// ==========================================
-//    [DSA CONCEPT: LOOKUP TABLE] MAPS
-// ==========================================
-class GameMap {
-protected:
-    int width, height;
-    vector<vector<bool>> validArea; // The Lookup Table
-
-public:
-    GameMap(int w, int h) : width(w), height(h) {
-        validArea.resize(height, vector<bool>(width, false));
-    }
-    virtual void generateMap() = 0;
-    virtual string getName() = 0;
-
-    // O(1) Access
-    bool isValid(int x, int y) {
-        if (x < 0 || x >= width || y < 0 || y >= height) return false;
-        return validArea[y][x];
-    }
-    int getWidth() { return width; }
-    int getHeight() { return height; }
-};
-
-class RectangularMap : public GameMap {
-public:
-    RectangularMap(int w, int h) : GameMap(w, h) {}
-    void generateMap() override {
-        for(int y=1; y<height-1; y++)
-            for(int x=1; x<width-1; x++)
-                validArea[y][x] = true;
-    }
-    string getName() override { return "Classic Box"; }
-};
-
-class CircularMap : public GameMap {
-public:
-    CircularMap(int w, int h) : GameMap(w, h) {}
-    void generateMap() override {
-        double h_center = width / 2.0;
-        double k_center = height / 2.0;
-        double a = (width / 2.0) - 2; 
-        double b = (height / 2.0) - 1; 
-        
-        for(int y=0; y<height; y++) {
-            for(int x=0; x<width; x++) {
-                double val = (pow(x - h_center, 2) / pow(a, 2)) + (pow(y - k_center, 2) / pow(b, 2));
-                if (val <= 1.0) validArea[y][x] = true;
-            }
-        }
-    }
-    string getName() override { return " The Colosseum "; }
-};
-
-class TriangularMap : public GameMap {
-public:
-    TriangularMap(int w, int h) : GameMap(w, h) {}
-    void generateMap() override {
-        double x1 = width / 2.0, y1 = 1;         // Top
-        double x2 = 2, y2 = height - 2;          // Bottom Left
-        double x3 = width - 3, y3 = height - 2;  // Bottom Right
-
-        for(int y=0; y<height; y++) {
-            for(int x=0; x<width; x++) {
-                // Simple slope check for a upward pointing triangle
-                double slopeL = (y2 - y1) / (x2 - x1);
-                double slopeR = (y3 - y1) / (x3 - x1);
-                
-                bool leftCheck = x >= (x1 + (y - y1) / slopeL);
-                bool rightCheck = x <= (x1 + (y - y1) / slopeR);
-                bool bottomCheck = y <= y2;
-
-                if (leftCheck && rightCheck && bottomCheck && y > 0) 
-                    validArea[y][x] = true;
-            }
-        }
+// The same seed brings the same obstacles and food in the same order
+uint32_t askSeed() {
+    setColor(11);
+    cout << "\n Seed (0 = random): ";
+    unsigned long seed = 0;
+    if (!(cin >> seed)) {
+        cin.clear();
+        cin.ignore(1 << 16, '\n');
+        seed = 0;
     }
-    string getName() override { return "Pyramid of Doom"; }
-};
-
-// ==========================================
-//    [DSA CONCEPT: LINKED LIST] SNAKE
-// ==========================================
-class Segment {
-public:
-    int x, y;
-    Segment* next;
-    Segment(int x, int y) : x(x), y(y), next(NULL) {}
-};
+    return seed ? (uint32_t)seed : freshSeed();
+}
 
-class Snake {
+// Classic console backend: the bounding box of the changed cells goes
+// out in a single WriteConsoleOutputA call carrying per-cell attributes,
+// instead of a SetConsoleTextAttribute + cout pair for every cell.
+class Win32Backend : public RenderBackend {
 private:
-    Segment* head;
-    Direction dir;
-    int length;
-    // [DSA CONCEPT: STACK] Move History
-    stack<Direction> moveHistory; 
-
-public:
-    Snake(int x, int y) {
-        head = new Segment(x, y);
-        dir = STOP;
-        length = 1;
-        // Start with small body hanging down
-        Segment* curr = head;
-        for(int i=1; i<3; ++i) {
-            curr->next = new Segment(x, y+i);
-            curr = curr->next;
-            length++;
-        }
-    }
-
-    ~Snake() {
-        Segment* current = head;
-        while (current) {
-            Segment* next = current->next;
-            delete current;
-            current = next;
-        }
-    }
-
-    // --- FIX: Public accessor for the private stack size ---
-    int getMoveCount() {
-        return moveHistory.size();
-    }
-    // -----------------------------------------------------
-
-    void move() {
-        if (dir == STOP) return;
-        moveHistory.push(dir); // Store history
-
-        int newX = head->x;
-        int newY = head->y;
-        if (dir == LEFT) newX--;
-        if (dir == RIGHT) newX++;
-        if (dir == UP) newY--;
-        if (dir == DOWN) newY++;
-
-        // Add new head
-        Segment* newHead = new Segment(newX, newY);
-        newHead->next = head;
-        head = newHead;
-
-        // Remove tail
-        Segment* temp = head;
-        for (int i = 1; i < length; i++) temp = temp->next;
-        delete temp->next;
-        temp->next = NULL;
-    }
+    HANDLE out;
+    vector<CHAR_INFO> buf;
 
-    void grow() { length++; }
-
-    bool isCollidingWithSelf() {
-        Segment* temp = head->next;
-        while (temp) {
-            if (temp->x == head->x && temp->y == head->y) return true;
-            temp = temp->next;
-        }
-        return false;
-    }
-
-    void setDirection(Direction newDir) {
-        if ((dir == LEFT && newDir == RIGHT) || (dir == RIGHT && newDir == LEFT) ||
-            (dir == UP && newDir == DOWN) || (dir == DOWN && newDir == UP)) return;
-        dir = newDir;
-    }
-
-    Segment* getHead() { return head; }
-    
-    vector<Point> getBody() {
-        vector<Point> body;
-        Segment* t = head;
-        while(t) { body.push_back({t->x, t->y}); t=t->next; }
-        return body;
-    }
-};
-
-// ==========================================
-//    [DSA CONCEPT: GRAPH BFS] FOOD
-// ==========================================
-class Food {
 public:
-    int x, y;
-
-    // Checks if the food location is reachable from the snake's head
-    // BFS considers Map Walls, Obstacles, and Snake Body
-    bool isReachable(int startX, int startY, int targetX, int targetY, 
-                     GameMap* map, const vector<Point>& obstacles, const vector<Point>& body) {
-        
-        vector<vector<bool>> visited(map->getHeight(), vector<bool>(map->getWidth(), false));
-
-        // Mark obstacles/body as visited (blocked)
-        for(const auto& p : obstacles) if(p.y < map->getHeight() && p.x < map->getWidth()) visited[p.y][p.x] = true;
-        for(const auto& p : body) if(p.y < map->getHeight() && p.x < map->getWidth()) visited[p.y][p.x] = true;
-
-        if (visited[targetY][targetX]) return false; // Target is inside obstacle
-
-        queue<Point> q;
-        q.push({startX, startY});
-        visited[startY][startX] = true;
-
-        int dx[] = {0, 0, 1, -1};
-        int dy[] = {1, -1, 0, 0};
-
-        while (!q.empty()) {
-            Point curr = q.front(); q.pop();
-            if (curr.x == targetX && curr.y == targetY) return true;
-
-            for (int i = 0; i < 4; i++) {
-                int nx = curr.x + dx[i];
-                int ny = curr.y + dy[i];
-
-                if (map->isValid(nx, ny) && !visited[ny][nx]) {
-                    visited[ny][nx] = true;
-                    q.push({nx, ny});
-                }
-            }
+    Win32Backend() : out(GetStdHandle(STD_OUTPUT_HANDLE)) {}
+
+    void reserve(int cols, int rows) override { buf.reserve((size_t)cols * rows); }
+
+    size_t flush(const ScreenCell* cells, int cols, int rows, const int* dirty, int n) override {
+        (void)rows;
+        if (n == 0) return 0;
+        int top = dirty[0] / cols, bottom = dirty[n - 1] / cols;
+        int left = cols, right = 0;
+        for (int i = 0; i < n; i++) {
+            left = min(left, dirty[i] % cols);
+            right = max(right, dirty[i] % cols);
         }
-        return false;
-    }
-
-    void respawn(GameMap* map, Snake* snake, const vector<Point>& obstacles) {
-        bool valid = false;
-        int attempts = 0;
-        
-        while (!valid && attempts < 100) {
-            x = rand() % map->getWidth();
-            y = rand() % map->getHeight();
-            
-            // 1. Must be in valid map area
-            if (!map->isValid(x, y)) continue;
-
-            // 2. Must not be on obstacle
-            bool onObstacle = false;
-            for(auto& o : obstacles) if(o.x == x && o.y == y) onObstacle = true;
-            if(onObstacle) continue;
-
-            // 3. Must not be on snake
-            bool onSnake = false;
-            vector<Point> body = snake->getBody();
-            for(auto& b : body) if(b.x == x && b.y == y) onSnake = true;
-            if(onSnake) continue;
-
-            // 4. [DSA] BFS Check (Limit checks for performance)
-            if (attempts < 5) {
-                if(isReachable(snake->getHead()->x, snake->getHead()->y, x, y, map, obstacles, body))
-                    valid = true;
-            } else {
-                valid = true; // Fallback
+        int w = right - left + 1, h = bottom - top + 1;
+        buf.resize(w * h);
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                const ScreenCell& c = cells[(top + y) * cols + left + x];
+                buf[y * w + x].Char.AsciiChar = c.glyph;
+                buf[y * w + x].Attributes = c.color;
             }
-            attempts++;
         }
+        COORD size = {(short)w, (short)h};
+        COORD origin = {0, 0};
+        SMALL_RECT region = {(short)left, (short)top, (short)right, (short)bottom};
+        WriteConsoleOutputA(out, buf.data(), size, origin, &region);
+        return buf.size() * sizeof(CHAR_INFO);
     }
 };
 
 // ==========================================
-//           MAIN GAME ENGINE
+//      CONSOLE FRONTEND OVER THE ENGINE
 // ==========================================
-class Game {
+class ConsoleGame {
 private:
-    GameMap* map;
-    Snake* snake;
-    Food* food;
-    vector<Point> obstacles;
-    
-    // [DSA CONCEPT: QUEUE] Input Buffer
-    queue<int> inputQueue;
+    uint32_t seed;
+    SeededRandom rng;
+    ManualClock clock; // Game time: one tick period per tick
+    Game game;
+    ReplayWriter recorder; // Every game is saved to REPLAY_FILE
+    Rewinder rewinder;     // The last 20 seconds or so, for 'b'
+    bool suspended;        // Saved to SAVE_FILE with 'p' rather than over
+    BeepSink speaker;
+    AudioQueue audio;      // Beeps play on their own thread, off the tick
+    Win32Backend backend;
+    Renderer renderer;
+
+    // Keys come in on their own thread; each tick takes all of them
+    InputReader keys;
+    TurnCoalescer turns;
+    int64_t unshownInput; // Stamp of an applied key not yet on screen
+    LatencyStats latency;
+
+    // Set when the A* autopilot steers instead of the keys (x still quits)
+    bool autoplay;
+    Autopilot pilot;
 
-    GameMode mode;
     string playerName;
-    bool gameOver;
-    int score;
-    double timeLeft;
-    clock_t lastTime;
-    int difficultySpeed;
-
-    void generateObstacles(int count) {
-        obstacles.clear();
-        int placed = 0;
-        int attempts = 0;
-        while(placed < count && attempts < 1000) {
-            int ox = rand() % map->getWidth();
-            int oy = rand() % map->getHeight();
-            
-            // Obstacle must be inside valid map area
-            // And not too close to center (where snake spawns)
-            if(map->isValid(ox, oy) && (abs(ox - map->getWidth()/2) > 5 || abs(oy - map->getHeight()/2) > 5)) {
-                obstacles.push_back({ox, oy});
-                placed++;
-            }
-            attempts++;
-        }
-    }
+    TimingStats timing;
+    Metrics metrics; // Phase timings and counters for this game
 
 public:
-    Game(string name, GameMode gm, MapType mt, int diff) 
-        : playerName(name), mode(gm) {
-        
-        int w = 50, h = 25;
-        if (mt == RECTANGLE) map = new RectangularMap(w, h);
-        else if (mt == CIRCLE) map = new CircularMap(w, h);
-        else map = new TriangularMap(w, h);
-        
-        map->generateMap();
-        snake = new Snake(w/2, h/2);
-        
-        // Difficulty controls speed and obstacle count
-        difficultySpeed = (diff == 1) ? 100 : (diff == 2) ? 60 : 30;
-        int obsCount = (diff == 1) ? 5 : (diff == 2) ? 15 : 25;
-        generateObstacles(obsCount);
-
-        food = new Food();
-        food->respawn(map, snake, obstacles);
-
-        score = 0;
-        gameOver = false;
-        timeLeft = (mode == TIME_ATTACK) ? 20.0 : 0.0;
-        lastTime = clock();
+    // `resume` continues a saved session (its settings must match) and
+    // brings its own seed; one that does not fit the board starts afresh
+    ConsoleGame(string name, GameMode gm, MapType mt, int diff, bool autoplay, uint32_t seed,
+                const Snapshot* resume = NULL)
+        : seed(resume ? resume->seed : seed), rng(this->seed),
+          game(gm, mt, diff, rng, clock), recorder(REPLAY_FILE, game, rng, seed),
+          rewinder(game, rng, (size_t)(20000 / game.getTickPeriodMs())), suspended(false), audio(speaker),
+          renderer(game, backend), unshownInput(0), autoplay(autoplay), pilot(game, 1000), playerName(name) {
+        if (resume && restoreSnapshot(game, rng, *resume)) recorder.resync();
     }
 
-    ~Game() { delete map; delete snake; delete food; }
-
     void draw() {
-        moveCursorToTopLeft();
-        
         // --- HUD ---
-        setColor(14); // Yellow
-        cout << " PLAYER: " << playerName << " | SCORE: " << score << " ";
-        if (mode == TIME_ATTACK) {
-            setColor(timeLeft < 5.0 ? 12 : 11); // Red if low time
-            cout << "| TIME: " << (int)timeLeft << "s  ";
-        }
-        cout << "\n";
-        setColor(8); cout << " --------------------------------------------------\n";
-
-        // --- MAP RENDERING ---
-        for(int y=0; y<map->getHeight(); y++) {
-            cout << " "; // Margin
-            for(int x=0; x<map->getWidth(); x++) {
-                
-                // 1. Check Map Boundary (Lookup Table)
-                if(!map->isValid(x, y)) {
-                    setColor(8); cout << "."; // Void
-                    continue;
-                }
-
-                // 2. Check Objects
-                bool isObstacle = false;
-                for(auto& o : obstacles) if(o.x == x && o.y == y) { isObstacle=true; break; }
-                
-                if(isObstacle) {
-                    setColor(4); cout << "X"; // Red Obstacle
-                }
-                else if(x == snake->getHead()->x && y == snake->getHead()->y) {
-                    setColor(10); cout << "O"; // Green Head
-                }
-                else if(x == food->x && y == food->y) {
-                    setColor(13); cout << "@"; // Pink Food
-                }
-                else {
-                    bool isBody = false;
-                    vector<Point> body = snake->getBody();
-                    // Skip head
-                    for(size_t i=1; i<body.size(); i++) {
-                        if(body[i].x == x && body[i].y == y) { isBody = true; break; }
-                    }
-                    
-                    if(isBody) {
-                        setColor(2); cout << "o"; 
-                    } else {
-                        setColor(7); cout << " "; 
-                    }
-                }
-            }
-            cout << "\n";
+        // Pieced together in place: building strings here would allocate every frame
+        int col = renderer.putText(0, 0, " PLAYER: ", 14); // Yellow
+        col = renderer.putText(col, 0, autoplay ? "AUTOPILOT" : playerName.c_str(), 14);
+        col = renderer.putNumber(renderer.putText(col, 0, " | SCORE: ", 14), 0, game.getScore(), 14);
+        col = renderer.putText(col, 0, " ", 14);
+        if (game.getMode() == TIME_ATTACK) {
+            int color = game.getTimeLeft() < 5.0 ? 12 : 11; // Red if low time
+            col = renderer.putNumber(renderer.putText(col, 0, "| TIME: ", color), 0, (int)game.getTimeLeft(), color);
+            col = renderer.putText(col, 0, "s", color);
         }
-    }
-
-    void input() {
-        if(_kbhit()) {
-            inputQueue.push(_getch());
+        if (!autoplay) col = renderer.putText(col, 0, "| B: REWIND  P: SAVE ", 8);
+        renderer.clearRow(col, 0);
+        renderer.putRun(renderer.putText(0, 1, " ", 8), 1, '-', game.getMap()->getWidth(), 8);
+
+        // --- MAP RENDERING (changed cells only) ---
+        renderer.present(game);
+        if (unshownInput) {
+            latency.add((steadyNanos() - unshownInput) / 1e9);
+            unshownInput = 0;
         }
     }
 
     void logic() {
-        // Timer
-        clock_t now = clock();
-        double elapsed = double(now - lastTime) / CLOCKS_PER_SEC;
-        lastTime = now;
-        
-        if(mode == TIME_ATTACK) {
-            timeLeft -= elapsed;
-            if(timeLeft <= 0) gameOver = true;
-        }
-
-        // Input Processing
-        if(!inputQueue.empty()) {
-            int k = inputQueue.front(); inputQueue.pop();
-            switch(k) {
-                case 'w': snake->setDirection(UP); break;
-                case 's': snake->setDirection(DOWN); break;
-                case 'a': snake->setDirection(LEFT); break;
-                case 'd': snake->setDirection(RIGHT); break;
-                case 'x': gameOver = true; break;
+        // Input Processing: every key since the last tick
+        Direction turn;
+        {
+            SNAKE_PHASE(PHASE_INPUT);
+            turns.begin(game.getSnake()->getDirection());
+            KeyEvent e;
+            while (keys.poll(e)) turns.add(e);
+            if (turns.quitRequested()) { game.quit(); return; }
+            if (turns.saveRequested()) {
+                Snapshot snap;
+                takeSnapshot(game, rng, seed, snap);
+                suspended = saveSnapshot(SAVE_FILE, snap);
+                game.quit();
+                return;
+            }
+            if (int n = turns.rewindsRequested()) {
+                // The whole tick goes on stepping back
+                rewinder.rewind((long long)(n * REWIND_SECONDS * 1000 / game.getTickPeriodMs()));
+                pilot.forget();
+                recorder.resync();
+                return;
             }
+            turn = turns.turn();
+            if (autoplay) turn = pilot.decide(game);
+            else if (turn != STOP && !unshownInput) unshownInput = turns.turnStamp();
         }
 
-        snake->move();
-
-        Segment* h = snake->getHead();
-
-        // Check Map Collision
-        if(!map->isValid(h->x, h->y)) gameOver = true;
-        
-        // Check Self Collision
-        if(snake->isCollidingWithSelf()) gameOver = true;
-
-        // Check Obstacle Collision
-        for(auto& o : obstacles) if(o.x == h->x && o.y == h->y) gameOver = true;
-
-        if(gameOver) return;
-
-        // Eat Food
-        if(h->x == food->x && h->y == food->y) {
-            playSound("food");
-            score += 10;
-            snake->grow();
-            if(mode == TIME_ATTACK) timeLeft += 3.0; // Bonus time
-            food->respawn(map, snake, obstacles);
-        }
+        StepResult r = rewinder.step(turn);
+        recorder.record();
+        if(r.ateFood) audio.post(SOUND_FOOD);
     }
 
+    // Fixed-rate ticks; the screen is drawn at 60 fps in between,
+    // independent of the difficulty's tick rate
     void run() {
-        while(!gameOver) {
-            draw();
-            input();
-            logic();
-            Sleep(difficultySpeed);
+        keys.start();
+        audio.start();
+        TickScheduler scheduler(game.getTickPeriodMs() / 1000.0, 60);
+        {
+            MetricsSession session(metrics);
+            scheduler.run(
+                [this]() {
+                    clock.advance(game.getTickPeriodMs() / 1000.0);
+                    logic();
+                    return !game.isOver();
+                },
+                [this]() { draw(); });
         }
-        showGameOver();
+        keys.stop();
+        timing = scheduler.getStats();
+        recorder.finish();
+        metrics.writeJson(METRICS_JSON);
+        metrics.writeCsv(METRICS_CSV);
+        if (suspended) showSaved();
+        else showGameOver();
+    }
+
+    void showSaved() {
+        system("cls");
+        setColor(10); // Green
+        centerText("GAME SAVED AT SCORE " + to_string(game.getScore()), 60);
+        setColor(7);
+        centerText("Enter your name next time to resume it.", 60);
+        centerText("Press ANY KEY to return to Menu...", 60);
+        _getch();
+    }
+
+    // "p50 12.3 | p99 45.6 | max 78.9 us" for one phase
+    string phaseLine(Phase p) {
+        const Histogram& h = metrics.phases[p];
+        char buf[96];
+        snprintf(buf, sizeof(buf), "p50 %.1f | p99 %.1f | max %.1f us", h.percentile(0.50) / 1e3,
+                 h.percentile(0.99) / 1e3, h.max() / 1e3);
+        return buf;
     }
 
     string getRank(int s) {
@@ -504,7 +261,7 @@ public:
     }
 
     void showGameOver() {
-        playSound("gameover");
+        audio.post(SOUND_GAMEOVER); // Plays over the pause and the screen
         Sleep(500); // Dramatic pause
         system("cls");
         
@@ -513,10 +270,18 @@ public:
 
         int cw = 60; // Center width referencing
 
-        // --- FIX: Use the public function accessor instead of private variable ---
-        int totalMoves = snake->getMoveCount(); 
+        long long totalMoves = game.getSnake()->getMoveCount();
+        int score = game.getScore();
         string rank = getRank(score);
 
+        // 1. FILE THE SCORE (autopilot games under their own name)
+        Leaderboard board(LEADERBOARD_BASE);
+        GameMode mode = game.getMode();
+        MapType mapType = game.getMapType();
+        int diff = game.getDifficulty();
+        board.add(autoplay ? "AUTOPILOT" : playerName, mode, mapType, diff, score);
+        Standing standing = board.standing(mode, mapType, diff, score);
+
         // 2. DRAW THE TOMBSTONE (ASCII ART)
         setColor(8); // Gray for stone
         cout << "\n\n";
@@ -543,19 +308,42 @@ public:
         centerText("-----------------------------", cw);
         centerText(" FINAL SCORE: " + to_string(score), cw);
         centerText(" SURVIVAL RANK: " + rank, cw);
+        centerText(" SEED: " + to_string(seed), cw);
+        if (board.isOpen())
+            centerText(" LEADERBOARD: #" + to_string(standing.rank) + " of " + to_string(standing.total) +
+                       " (percentile " + to_string((int)standing.percentile) + ")", cw);
         centerText("-----------------------------", cw);
+        vector<LeaderboardEntry> best = board.top(mode, mapType, diff, 5);
+        for (size_t i = 0; i < best.size(); i++)
+            centerText(to_string(i + 1) + ". " + string(best[i].name) + "  " + to_string(best[i].score), cw);
         cout << "\n";
 
         // 4. DSA INSIGHTS
         setColor(11); // Cyan
         centerText("[ MEMORY DUMP ]", cw);
-        centerText("Moves Stack Size: " + to_string(totalMoves), cw);
-        centerText("Map Lookup Cycles: " + to_string(totalMoves * 1), cw); // O(1) per move
+        centerText("Moves Made: " + to_string(totalMoves), cw);
+        centerText("Input: " + phaseLine(PHASE_INPUT), cw);
+        centerText("Tick Logic: " + phaseLine(PHASE_LOGIC), cw);
+        centerText("Food Respawn: " + phaseLine(PHASE_RESPAWN), cw);
+        centerText("BFS: " + phaseLine(PHASE_BFS), cw);
+        centerText("Draw: " + phaseLine(PHASE_DRAW), cw);
+        centerText("Allocations: " + to_string(metrics.counters[COUNT_ALLOCATIONS]) + " | BFS Nodes: " +
+                   to_string(metrics.counters[COUNT_BFS_NODES]) + " | Console Bytes: " +
+                   to_string(metrics.counters[COUNT_CONSOLE_BYTES]), cw);
+        centerText("Tick Jitter: avg " + to_string((int)(timing.avgJitter() * 1e6)) + " us, max " +
+                   to_string((int)(timing.maxJitter * 1e6)) + " us", cw);
+        centerText("Input Latency: avg " + to_string((int)(latency.avg() * 1e3)) + " ms, max " +
+                   to_string((int)(latency.max * 1e3)) + " ms", cw);
+        centerText("Late Ticks: " + to_string(timing.overruns) + " (" + to_string(timing.dropped) + " dropped)", cw);
+        centerText("(full numbers in " + string(METRICS_JSON) + ")", cw);
         
         // 5. DRAMATIC FOOTER
         cout << "\n";
         setColor(12); // Red
-        if (mode == TIME_ATTACK && timeLeft <= 0) {
+        if (game.getDeathCause() == WON) {
+            setColor(10); // Green
+            centerText("THE SNAKE FILLS THE MAP: YOU WIN", cw);
+        } else if (game.getDeathCause() == TIME_OUT) {
             centerText("CAUSE OF DEATH: TIME RAN OUT", cw);
         } else {
             centerText("CAUSE OF DEATH: COLLISION", cw);
@@ -597,6 +385,96 @@ void showStylishIntro() {
     _getch();
 }
 
+// Play REPLAY_FILE back at game speed. Any key stops it.
+void watchReplay() {
+    ReplayPlayer player(REPLAY_FILE);
+    if (!player.isOpen()) return;
+    system("cls");
+    Game& game = player.getGame();
+    Win32Backend backend;
+    Renderer renderer(game, backend);
+    TickScheduler scheduler(game.getTickPeriodMs() / 1000.0, 0);
+    scheduler.run(
+        [&]() {
+            if (_kbhit()) { _getch(); return false; }
+            return player.step();
+        },
+        [&]() {
+            string hud = " REPLAY | SCORE: " + to_string(game.getScore()) + " | TICK: " + to_string(game.getTicks()) + " ";
+            renderer.clearRow(renderer.putText(0, 0, hud, 14), 0);
+            renderer.putText(0, 1, " " + string(game.getMap()->getWidth(), '-'), 8);
+            renderer.present(game);
+        });
+    Sleep(1000);
+}
+
+// The endless map: chunks stream in around the snake and the oldest
+// ones are dropped, so it can go on for as long as the player does
+void playOpenWorld(const string& name, int diff, uint32_t seed) {
+    WorldConfig cfg;
+    cfg.seed = seed;
+    cfg.prefetch = true;
+    World world(cfg);
+    Win32Backend backend;
+    WorldView view(backend, 78, 22);
+    InputReader keys;
+    TurnCoalescer turns;
+    BeepSink speaker;
+    AudioQueue audio(speaker);
+
+    keys.start();
+    audio.start();
+    int periodMs = (diff == 1) ? 100 : (diff == 2) ? 60 : 30;
+    TickScheduler scheduler(periodMs / 1000.0, 60);
+    scheduler.run(
+        [&]() {
+            turns.begin(world.getDirection());
+            KeyEvent e;
+            while (keys.poll(e)) turns.add(e);
+            if (turns.quitRequested()) { world.quit(); return false; }
+            if (world.step(turns.turn()).ateFood) audio.post(SOUND_FOOD);
+            return !world.isOver();
+        },
+        [&]() {
+            int col = view.putText(0, 0, " PLAYER: ", 14);
+            col = view.putText(col, 0, name.c_str(), 14);
+            col = view.putNumber(view.putText(col, 0, " | SCORE: ", 14), 0, world.getScore(), 14);
+            col = view.putNumber(view.putText(col, 0, " | AT ", 14), 0, world.getHead().x, 14);
+            col = view.putNumber(view.putText(col, 0, ",", 14), 0, world.getHead().y, 14);
+            view.clearRow(col, 0);
+            view.putRun(view.putText(0, 1, " ", 8), 1, '-', 78, 8);
+            view.present(world);
+        });
+    keys.stop();
+
+    if (world.getDeathCause() != QUIT) audio.post(SOUND_GAMEOVER);
+    Sleep(500);
+    system("cls");
+    int cw = 60;
+    const WorldStats& st = world.getStats();
+    cout << "\n\n";
+    setColor(12); // Red
+    centerText("THE WILDS CLAIM " + name, cw);
+    cout << "\n";
+    setColor(14); // Yellow
+    centerText("-----------------------------", cw);
+    centerText(" FINAL SCORE: " + to_string(world.getScore()), cw);
+    centerText(" FARTHEST FROM HOME: " + to_string(st.farthest) + " cells", cw);
+    centerText(" SEED: " + to_string(seed), cw);
+    centerText("-----------------------------", cw);
+    cout << "\n";
+    setColor(11); // Cyan
+    centerText("[ CHUNK CACHE ]", cw);
+    centerText("Generated: " + to_string(st.generated) + " | Prefetched: " + to_string(st.prefetched) +
+               " | Evicted: " + to_string(st.evictions), cw);
+    centerText("Resident: " + to_string(st.peakChunks) + " chunks at most, " +
+               to_string(world.memoryBytes() / 1024) + " KB", cw);
+    cout << "\n\n";
+    setColor(7); // White
+    centerText("Press ANY KEY to return to Menu...", cw);
+    _getch();
+}
+
 int showMenu(string title, vector<string> opts) {
     system("cls");
     setColor(13); // Magenta
@@ -610,8 +488,16 @@ int showMenu(string title, vector<string> opts) {
     return c;
 }
 
+// Whether a loaded save restores into a game of its settings; tried on
+// a scratch game so a bad one is caught before anything is built
+bool canResume(const Snapshot& s) {
+    SeededRandom rng(s.seed);
+    ManualClock clock;
+    Game probe(s.mode, s.map, s.difficulty, rng, clock);
+    return restoreSnapshot(probe, rng, s);
+}
+
 int main() {
-    srand(time(0));
     hideCursor();
     showStylishIntro();
 
@@ -622,27 +508,87 @@ int main() {
         cout << "\n Enter Player Name: "; 
         cin >> name;
 
+        // A session saved with 'p' can pick up where it stopped. The file
+        // goes once it is resumed; declined, it stays for next time.
+        Snapshot saved;
+        FILE* saveFile = fopen(SAVE_FILE, "rb");
+        if (saveFile) fclose(saveFile);
+        bool resumable = saveFile && loadSnapshot(SAVE_FILE, saved) && canResume(saved);
+        if (saveFile && !resumable) {
+            setColor(12); // Red
+            cout << "\n The saved game in " << SAVE_FILE << " is damaged and cannot be resumed.";
+            setColor(7);
+            cout << "\n Press ANY KEY to continue...";
+            _getch();
+        }
+        if (resumable) {
+            char yn;
+            cout << "\n Resume saved game? (y/n): ";
+            cin >> yn;
+            if (yn == 'y' || yn == 'Y') {
+                system("cls");
+                ConsoleGame game(name, saved.mode, saved.map, saved.difficulty, false, saved.seed, &saved);
+                remove(SAVE_FILE); // Pressing 'p' again writes a new one
+                game.run();
+                system("cls");
+                setColor(14);
+                cout << "\n Play Again? (y/n): ";
+                char again;
+                cin >> again;
+                if (again == 'n' || again == 'N') break;
+                continue;
+            }
+        }
+
         // 1. Select Mode
-        int m = showMenu("SELECT MODE", {"Classic Survival", "Time Attack (Race Against Clock)"});
+        int m = showMenu("SELECT MODE", {"Classic Survival", "Time Attack (Race Against Clock)", "Open World (Endless)"});
         GameMode mode = (m == 2) ? TIME_ATTACK : CLASSIC;
 
+        // The open world has no map shape, autopilot or leaderboard
+        if (m == 3) {
+            int d = showMenu("SELECT DIFFICULTY", {"Easy (Slow)", "Medium (Normal)", "Hard (Fast)"});
+            uint32_t seed = askSeed();
+            system("cls");
+            playOpenWorld(name, d, seed);
+            system("cls");
+            setColor(14);
+            cout << "\n Play Again? (y/n): ";
+            char again;
+            cin >> again;
+            if (again == 'n' || again == 'N') break;
+            continue;
+        }
+
         // 2. Select Map
         int mp = showMenu("SELECT MAP SHAPE", {"Classic Box", "The Colosseum (Circle)", "Pyramid (Triangle)"});
         MapType mapType = (mp == 2) ? CIRCLE : (mp == 3) ? TRIANGLE : RECTANGLE;
 
         // 3. Select Difficulty
         int d = showMenu("SELECT DIFFICULTY", {"Easy (Slow, Few Obstacles)", "Medium (Normal)", "Hard (Fast, Many Obstacles)"});
-        
+
+        // 4. Select Player
+        int who = showMenu("WHO PLAYS?", {"You", "Autopilot (A* Solver)"});
+
+        // 5. Seed
+        uint32_t seed = askSeed();
+
         // Run Game
         system("cls");
-        Game game(name, mode, mapType, d);
+        ConsoleGame game(name, mode, mapType, d, who == 2, seed);
         game.run();
 
         // Replay?
         system("cls");
         setColor(14);
-        cout << "\n Play Again? (y/n): ";
-        char r; cin >> r;
+        char r;
+        while(true) {
+            cout << "\n Play Again? (y/n, r = watch replay): ";
+            cin >> r;
+            if(r != 'r' && r != 'R') break;
+            watchReplay();
+            system("cls");
+            setColor(14);
+        }
         if(r == 'n' || r == 'N') break;
     }
 
@@ -0,0 +1,256 @@
+#pragma once
+
+// ==========================================
+//   VECTORIZED ENVIRONMENT (TRAINING API)
+// ==========================================
+// K independent games stepped in lockstep for reinforcement learning:
+// reset(seeds) starts them, step(actions, rewards, dones) moves each by
+// one tick. Observations go straight into a buffer the caller owns (an
+// array, a tensor's storage, or a SharedObservations segment another
+// process maps), laid out [env][plane][y][x], one byte per cell, 1 where
+// the plane's feature is:
+//   PLANE_WALL      off the map shape
+//   PLANE_OBSTACLE  an obstacle
+//   PLANE_BODY      the snake, head included
+//   PLANE_HEAD      the head
+//   PLANE_FOOD      the food
+// Only the cells the Board reports as retagged (plus the old and new
+// head) are rewritten each step, so the caller must not write to the
+// buffer; refresh() redraws it whole.
+//
+// Rewards: +1 for food, -1 for dying, 0 otherwise. dones[k] is 0 while
+// env k runs, 1 when its game ended (death, time out, filling the map)
+// and 2 when it hit maxTicks. An env that is done restarts in the same
+// step and its observation is already the new episode's first; the
+// restart keeps the map and obstacles and carries on the env's random
+// stream, so food falls differently each episode. Call reset() for new
+// maps. Once warmed up, step() makes no heap allocations, restarts
+// included; bench_vecenv counts them and expects 0.
+//
+// Actions are Direction values: STOP keeps going, anything above DOWN
+// counts as STOP.
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include "engine.h"
+#include "pool.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+struct EnvConfig {
+    GameMode mode = CLASSIC;
+    MapType map = RECTANGLE;
+    int difficulty = 2;
+    int width = Game::DEFAULT_WIDTH, height = Game::DEFAULT_HEIGHT;
+    long long maxTicks = 10000; // Episode cut-off (dones = 2); 0 for none
+};
+
+class VecEnv {
+public:
+    enum Plane { PLANE_WALL = 0, PLANE_OBSTACLE, PLANE_BODY, PLANE_HEAD, PLANE_FOOD, PLANE_COUNT };
+
+    // Bytes the observation buffer needs for `count` envs
+    static size_t observationBytes(int count, const EnvConfig& cfg) {
+        return (size_t)count * PLANE_COUNT * cfg.width * cfg.height;
+    }
+
+private:
+    struct Env {
+        SeededRandom rng;
+        ManualClock clock;
+        std::unique_ptr<Game> game;
+        GameState start; // Restored on an automatic restart
+        int head;        // Cell marked in PLANE_HEAD, -1 for none
+        uint8_t* obs;
+        long long episodes;
+        int lastScore;   // Score of the last finished episode
+
+        Env() : rng(1), head(-1), obs(NULL), episodes(0), lastScore(0) {}
+    };
+
+    EnvConfig cfg;
+    size_t planeSize;
+    std::vector<Env> envs;
+    uint8_t* observations;
+    PhasePool pool;
+    int chunks;
+
+    // The arguments of the step in progress, so the task lambda only
+    // captures `this` (small enough for std::function not to allocate)
+    const uint8_t* stepActions;
+    float* stepRewards;
+    uint8_t* stepDones;
+
+    void writeCell(Env& e, int i) {
+        Cell c = e.game->getBoard()->at(i % cfg.width, i / cfg.width);
+        uint8_t* o = e.obs + i;
+        o[PLANE_WALL * planeSize] = c == CELL_VOID;
+        o[PLANE_OBSTACLE * planeSize] = c == CELL_OBSTACLE;
+        o[PLANE_BODY * planeSize] = c == CELL_BODY;
+        o[PLANE_FOOD * planeSize] = c == CELL_FOOD;
+    }
+
+    void moveHead(Env& e) {
+        uint8_t* plane = e.obs + PLANE_HEAD * planeSize;
+        if (e.head >= 0) plane[e.head] = 0;
+        const Point& h = e.game->getSnake()->getHead();
+        e.head = (unsigned)h.x < (unsigned)cfg.width && (unsigned)h.y < (unsigned)cfg.height ? h.y * cfg.width + h.x : -1;
+        if (e.head >= 0) plane[e.head] = 1;
+    }
+
+    void redraw(Env& e) {
+        memset(e.obs, 0, PLANE_COUNT * planeSize);
+        for (int i = 0; i < (int)planeSize; i++) writeCell(e, i);
+        e.head = -1;
+        moveHead(e);
+        e.game->getBoard()->clearDirty();
+    }
+
+    void flushDirty(Env& e) {
+        Board* board = e.game->getBoard();
+        for (int i : board->getDirty()) writeCell(e, i);
+        board->clearDirty();
+        moveHead(e);
+    }
+
+    void stepOne(int k) {
+        Env& e = envs[k];
+        Game& game = *e.game;
+        int a = stepActions[k];
+        e.clock.advance(game.getTickPeriodMs() / 1000.0);
+        StepResult r = game.step(a <= DOWN ? (Direction)a : STOP);
+        stepRewards[k] = r.ateFood ? 1.0f : r.died ? -1.0f : 0.0f;
+        uint8_t done = game.isOver() ? 1 : cfg.maxTicks && game.getTicks() >= cfg.maxTicks ? 2 : 0;
+        stepDones[k] = done;
+        if (done) {
+            e.lastScore = game.getScore();
+            e.episodes++;
+            game.loadState(e.start);
+        }
+        flushDirty(e);
+    }
+
+public:
+    // `observations` must hold observationBytes(count, cfg) bytes and
+    // outlive the VecEnv. threads <= 0 means one per hardware thread.
+    VecEnv(int count, const EnvConfig& config, uint8_t* observations, int threads)
+        : cfg(config), planeSize((size_t)config.width * config.height), envs(std::max(count, 0)),
+          observations(observations), pool(threads), stepActions(NULL), stepRewards(NULL), stepDones(NULL) {
+        for (size_t k = 0; k < envs.size(); k++) envs[k].obs = observations + k * PLANE_COUNT * planeSize;
+        // A few chunks per thread keeps them busy when some envs restart
+        chunks = std::max(1, std::min((int)envs.size(), 4 * pool.getThreads()));
+    }
+
+    VecEnv(const VecEnv&) = delete;
+    VecEnv& operator=(const VecEnv&) = delete;
+
+    // Start env k afresh from seeds[k]: new obstacles, new snake
+    void reset(const uint32_t* seeds) {
+        pool.run(chunks, [this, seeds](int c) {
+            size_t lo = envs.size() * c / chunks, hi = envs.size() * (c + 1) / chunks;
+            for (size_t k = lo; k < hi; k++) {
+                Env& e = envs[k];
+                e.game.reset();
+                e.rng = SeededRandom(seeds[k]);
+                e.clock = ManualClock();
+                e.game.reset(new Game(cfg.mode, cfg.map, cfg.difficulty, e.rng, e.clock, cfg.width, cfg.height));
+                e.game->saveState(e.start);
+                redraw(e);
+            }
+        });
+    }
+
+    // One tick of every env. `actions`, `rewards` and `dones` hold one
+    // entry per env.
+    void step(const uint8_t* actions, float* rewards, uint8_t* dones) {
+        stepActions = actions;
+        stepRewards = rewards;
+        stepDones = dones;
+        pool.run(chunks, [this](int c) {
+            size_t lo = envs.size() * c / chunks, hi = envs.size() * (c + 1) / chunks;
+            for (size_t k = lo; k < hi; k++) stepOne((int)k);
+        });
+    }
+
+    // Rewrite every observation from the games
+    void refresh() {
+        for (Env& e : envs)
+            if (e.game) redraw(e);
+    }
+
+    int getCount() { return (int)envs.size(); }
+    uint8_t* getObservations() { return observations; }
+    int getThreads() { return pool.getThreads(); }
+    Game* getGame(int k) { return envs[k].game.get(); }
+    long long getEpisodes(int k) { return envs[k].episodes; }
+    int getLastScore(int k) { return envs[k].lastScore; }
+};
+
+// A named POSIX shared memory segment for the observations, so a trainer
+// in another process can map the same bytes (shm_open with the same
+// name). The creator unlinks it on destruction. Without POSIX shared
+// memory (Windows) it is plain process memory.
+class SharedObservations {
+private:
+    uint8_t* bytes;
+    size_t length;
+#ifdef _WIN32
+    std::vector<uint8_t> copy;
+#else
+    std::string name;
+    bool owner;
+#endif
+
+public:
+    // `create` makes (or truncates) the segment; otherwise an existing
+    // one of at least `size` bytes is opened
+    SharedObservations(const char* segment, size_t size, bool create) : bytes(NULL), length(0) {
+#ifdef _WIN32
+        (void)segment;
+        (void)create;
+        copy.assign(size, 0);
+        bytes = copy.data();
+        length = size;
+#else
+        name = segment;
+        owner = false;
+        int fd = shm_open(segment, create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR, 0600);
+        if (fd < 0) return;
+        struct stat st;
+        bool sized = create ? ftruncate(fd, (off_t)size) == 0 : fstat(fd, &st) == 0 && (size_t)st.st_size >= size;
+        if (sized) {
+            void* mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (mapping != MAP_FAILED) {
+                bytes = (uint8_t*)mapping;
+                length = size;
+                owner = create;
+            }
+        }
+        close(fd);
+        if (!bytes && create) shm_unlink(segment);
+#endif
+    }
+
+    ~SharedObservations() {
+#ifndef _WIN32
+        if (bytes) munmap(bytes, length);
+        if (owner) shm_unlink(name.c_str());
+#endif
+    }
+
+    SharedObservations(const SharedObservations&) = delete;
+    SharedObservations& operator=(const SharedObservations&) = delete;
+
+    bool isOpen() { return bytes != NULL; }
+    uint8_t* data() { return bytes; }
+    size_t size() { return length; }
+};
@@ -0,0 +1,499 @@
+#pragma once
+
+// ==========================================
+//     [DSA CONCEPT: LRU CACHE] OPEN WORLD
+// ==========================================
+// A map with no edges. The plane is cut into CHUNK x CHUNK chunks, and
+// each one is generated from (seed, chunk x, chunk y) alone: a few wall
+// runs, clusters of obstacles and some food. Only the chunks in a
+// fixed-size cache exist. A hash table finds a chunk by its
+// coordinates; an intrusive list keeps the slots in use order. When a
+// new chunk needs a slot, the least recently used chunk that holds no
+// part of the snake is evicted. Memory therefore stays the same however
+// far the snake travels. An evicted chunk comes back as it was
+// generated, so food eaten there grows back.
+//
+// Entering a chunk touches the chunks within `keepRadius` of it, which
+// keeps the neighbourhood warm. With prefetching on, a worker thread
+// generates the chunks just beyond that radius, ahead of the snake,
+// from a request ring. It hands them back through a second ring into a
+// small staging area, and the tick takes a chunk from there instead of
+// generating it. The cache only ever changes on the tick, in the same
+// order with or without the worker, so a run is identical either way.
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include "engine.h"
+#include "ring.h"
+#include "render.h"
+
+struct WorldConfig {
+    uint32_t seed = 1;
+    int cacheChunks = 128; // Resident chunks (32x32 cells each)
+    int keepRadius = 2;    // Chunks kept warm around the head's chunk
+    bool prefetch = false; // Generate chunks ahead on a worker thread
+};
+
+struct WorldStats {
+    long long ticks = 0;
+    long long generated = 0;  // Chunks generated on the tick
+    long long prefetched = 0; // Chunks taken from the worker instead
+    long long evictions = 0;
+    long long lookups = 0, misses = 0;
+    int peakChunks = 0;       // Most chunks resident at once
+    long long farthest = 0;   // Largest |x| + |y| the head reached
+};
+
+class World {
+public:
+    enum { CHUNK_SHIFT = 5, CHUNK = 1 << CHUNK_SHIFT, CHUNK_CELLS = CHUNK * CHUNK };
+    enum { SPAWN_CLEAR = 8 }; // Cells around the origin left open for the start
+
+    struct Chunk {
+        int cx, cy;
+        int pins;         // Body cells in here; a pinned chunk stays
+        int prev, next;   // Use order, most recent first
+        uint8_t cells[CHUNK_CELLS]; // Cell values, row-major
+    };
+
+    // A chunk's cells: a pure function of the seed and its coordinates
+    static void generate(uint32_t seed, int cx, int cy, uint8_t* cells) {
+        SeededRandom rng((uint32_t)mix(keyOf(cx, cy) ^ ((uint64_t)seed << 17)) | 1);
+        memset(cells, CELL_FREE, CHUNK_CELLS);
+        // Wall runs
+        for (int n = rng.next(3); n > 0; n--) {
+            int x = rng.next(CHUNK), y = rng.next(CHUNK), len = 4 + rng.next(CHUNK / 2);
+            int dx = rng.next(2), dy = 1 - dx;
+            for (int i = 0; i < len && x < CHUNK && y < CHUNK; i++, x += dx, y += dy) cells[y * CHUNK + x] = CELL_OBSTACLE;
+        }
+        // Obstacle clusters: short random walks
+        for (int n = rng.next(4); n > 0; n--) {
+            int x = rng.next(CHUNK), y = rng.next(CHUNK);
+            for (int i = 1 + rng.next(6); i > 0; i--) {
+                cells[y * CHUNK + x] = CELL_OBSTACLE;
+                int d = rng.next(4);
+                x = std::min(std::max(x + (d == 0) - (d == 1), 0), CHUNK - 1);
+                y = std::min(std::max(y + (d == 2) - (d == 3), 0), CHUNK - 1);
+            }
+        }
+        // Food on free cells
+        for (int n = 2 + rng.next(3); n > 0; n--) {
+            int i = rng.next(CHUNK_CELLS);
+            if (cells[i] == CELL_FREE) cells[i] = CELL_FOOD;
+        }
+        // The start area is open whatever the seed
+        for (int y = 0; y < CHUNK; y++) {
+            for (int x = 0; x < CHUNK; x++) {
+                int wx = cx * CHUNK + x, wy = cy * CHUNK + y;
+                if (std::abs(wx) <= SPAWN_CLEAR && std::abs(wy) <= SPAWN_CLEAR) cells[y * CHUNK + x] = CELL_FREE;
+            }
+        }
+    }
+
+private:
+    enum { STAGED = 16, NONE = -1 };
+
+    struct Generated {
+        int cx, cy;
+        uint8_t cells[CHUNK_CELLS];
+    };
+
+    WorldConfig cfg;
+    WorldStats stats;
+
+    // Slots and their use order
+    std::vector<Chunk> slots;
+    int used;         // Slots handed out so far
+    int newest, oldest;
+
+    // Open addressing, linear probing, backward-shift delete; the table
+    // stays at most half full
+    std::vector<uint64_t> keys;
+    std::vector<int> values; // Slot, NONE when empty
+    uint64_t mask;
+
+    // The snake: a ring of world cells that doubles when full
+    std::vector<Point> ring;
+    int head, count, length;
+    Direction dir;
+    int score;
+    bool over;
+    DeathCause cause;
+    int headCx, headCy; // Chunk the head is in
+
+    // Prefetching
+    SpscRing<uint64_t, 64> requests;
+    SpscRing<Generated, STAGED> results;
+    Generated staged[STAGED];
+    uint64_t stagedKey[STAGED];
+    bool stagedFull[STAGED];
+    int stagedNext;
+    std::thread worker;
+    std::atomic<bool> running;
+
+    static uint64_t keyOf(int cx, int cy) { return ((uint64_t)(uint32_t)cx << 32) | (uint32_t)cy; }
+
+    static uint64_t mix(uint64_t k) {
+        k ^= k >> 33; k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33; k *= 0xc4ceb9fe1a85ec53ULL;
+        return k ^ (k >> 33);
+    }
+
+    // --- Hash table ---
+
+    int find(uint64_t key) {
+        for (uint64_t i = mix(key) & mask;; i = (i + 1) & mask) {
+            if (values[i] == NONE) return NONE;
+            if (keys[i] == key) return values[i];
+        }
+    }
+
+    void insert(uint64_t key, int slot) {
+        uint64_t i = mix(key) & mask;
+        while (values[i] != NONE) i = (i + 1) & mask;
+        keys[i] = key;
+        values[i] = slot;
+    }
+
+    void erase(uint64_t key) {
+        uint64_t i = mix(key) & mask;
+        while (keys[i] != key || values[i] == NONE) i = (i + 1) & mask;
+        // Pull later entries of the probe run back over the hole
+        for (uint64_t j = (i + 1) & mask; values[j] != NONE; j = (j + 1) & mask) {
+            uint64_t home = mix(keys[j]) & mask;
+            if (((j - home) & mask) >= ((j - i) & mask)) {
+                keys[i] = keys[j];
+                values[i] = values[j];
+                i = j;
+            }
+        }
+        values[i] = NONE;
+    }
+
+    void rebuildTable(size_t size) {
+        keys.assign(size, 0);
+        values.assign(size, NONE);
+        mask = size - 1;
+        for (int s = 0; s < used; s++) insert(keyOf(slots[s].cx, slots[s].cy), s);
+    }
+
+    // --- Use order ---
+
+    void unlink(int s) {
+        Chunk& c = slots[s];
+        if (c.prev != NONE) slots[c.prev].next = c.next; else newest = c.next;
+        if (c.next != NONE) slots[c.next].prev = c.prev; else oldest = c.prev;
+    }
+
+    void pushFront(int s) {
+        slots[s].prev = NONE;
+        slots[s].next = newest;
+        if (newest != NONE) slots[newest].prev = s;
+        newest = s;
+        if (oldest == NONE) oldest = s;
+    }
+
+    void touch(int s) {
+        if (s == newest) return;
+        unlink(s);
+        pushFront(s);
+    }
+
+    // A slot for a new chunk: a fresh one, else the least recently used
+    // unpinned one. Only when every chunk holds part of the snake does
+    // the cache grow past its size.
+    int takeSlot() {
+        if (used < (int)slots.size()) return used++;
+        for (int s = oldest; s != NONE; s = slots[s].prev) {
+            if (slots[s].pins) continue;
+            unlink(s);
+            erase(keyOf(slots[s].cx, slots[s].cy));
+            stats.evictions++;
+            return s;
+        }
+        slots.resize(slots.size() + 1);
+        if ((size_t)(used + 1) * 2 > keys.size()) rebuildTable(keys.size() * 2);
+        return used++;
+    }
+
+    // --- Prefetching ---
+
+    void workerLoop() {
+        Generated g;
+        while (running.load(std::memory_order_relaxed)) {
+            uint64_t key;
+            if (!requests.pop(key)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            g.cx = (int)(int32_t)(key >> 32);
+            g.cy = (int)(int32_t)(uint32_t)key;
+            generate(cfg.seed, g.cx, g.cy, g.cells);
+            while (!results.push(g) && running.load(std::memory_order_relaxed))
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    // Move finished chunks from the worker into staging, oldest out
+    void collect() {
+        while (results.pop(staged[stagedNext])) {
+            const Generated& g = staged[stagedNext];
+            stagedKey[stagedNext] = keyOf(g.cx, g.cy);
+            stagedFull[stagedNext] = true;
+            stagedNext = (stagedNext + 1) % STAGED;
+        }
+    }
+
+    bool takeStaged(int cx, int cy, uint8_t* cells) {
+        uint64_t key = keyOf(cx, cy);
+        for (int i = 0; i < STAGED; i++) {
+            if (!stagedFull[i] || stagedKey[i] != key) continue;
+            memcpy(cells, staged[i].cells, CHUNK_CELLS);
+            stagedFull[i] = false;
+            return true;
+        }
+        return false;
+    }
+
+    bool isStaged(uint64_t key) {
+        for (int i = 0; i < STAGED; i++)
+            if (stagedFull[i] && stagedKey[i] == key) return true;
+        return false;
+    }
+
+    // Ask for the chunks one step past the kept radius, ahead of the head
+    void requestAhead() {
+        int dx = dir == RIGHT ? 1 : dir == LEFT ? -1 : 0;
+        int dy = dir == DOWN ? 1 : dir == UP ? -1 : 0;
+        if (!dx && !dy) return;
+        int r = cfg.keepRadius + 1;
+        for (int k = -cfg.keepRadius; k <= cfg.keepRadius; k++) {
+            int cx = headCx + (dx ? dx * r : k), cy = headCy + (dy ? dy * r : k);
+            uint64_t key = keyOf(cx, cy);
+            if (find(key) == NONE && !isStaged(key)) requests.push(key);
+        }
+    }
+
+    // --- Chunk access ---
+
+    Chunk& load(int cx, int cy) {
+        stats.lookups++;
+        int s = find(keyOf(cx, cy));
+        if (s != NONE) { touch(s); return slots[s]; }
+        stats.misses++;
+        s = takeSlot();
+        Chunk& c = slots[s];
+        c.cx = cx;
+        c.cy = cy;
+        c.pins = 0;
+        if (cfg.prefetch && takeStaged(cx, cy, c.cells)) stats.prefetched++;
+        else { generate(cfg.seed, cx, cy, c.cells); stats.generated++; }
+        insert(keyOf(cx, cy), s);
+        pushFront(s);
+        stats.peakChunks = std::max(stats.peakChunks, used);
+        return c;
+    }
+
+    uint8_t& cellAt(const Point& p) {
+        Chunk& c = load(p.x >> CHUNK_SHIFT, p.y >> CHUNK_SHIFT);
+        return c.cells[(p.y & (CHUNK - 1)) * CHUNK + (p.x & (CHUNK - 1))];
+    }
+
+    void pin(const Point& p, int by) { load(p.x >> CHUNK_SHIFT, p.y >> CHUNK_SHIFT).pins += by; }
+
+    void warmAround() {
+        for (int dy = -cfg.keepRadius; dy <= cfg.keepRadius; dy++)
+            for (int dx = -cfg.keepRadius; dx <= cfg.keepRadius; dx++) load(headCx + dx, headCy + dy);
+    }
+
+    const Point& at(int k) const { return ring[(head + k) % ring.size()]; }
+
+public:
+    explicit World(const WorldConfig& config)
+        : cfg(config), used(0), newest(NONE), oldest(NONE), head(0), count(0), length(3), dir(RIGHT), score(0),
+          over(false), cause(ALIVE), stagedNext(0), running(false) {
+        int needed = (2 * cfg.keepRadius + 1) * (2 * cfg.keepRadius + 1) + 1;
+        cfg.cacheChunks = std::max(cfg.cacheChunks, needed);
+        slots.resize(cfg.cacheChunks);
+        size_t size = 16;
+        while (size < (size_t)cfg.cacheChunks * 2) size *= 2;
+        rebuildTable(size);
+        for (int i = 0; i < STAGED; i++) stagedFull[i] = false;
+
+        ring.resize(64);
+        ring[0] = {0, 0};
+        count = 1;
+        cellAt(ring[0]) = CELL_BODY;
+        pin(ring[0], 1);
+        headCx = headCy = 0;
+        warmAround();
+        if (cfg.prefetch) {
+            running = true;
+            worker = std::thread(&World::workerLoop, this);
+        }
+    }
+
+    ~World() {
+        if (running) {
+            running = false;
+            worker.join();
+        }
+    }
+
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    // What is at a world cell (generating its chunk if need be)
+    Cell cell(int x, int y) { return (Cell)cellAt({x, y}); }
+
+    // A resident chunk, or NULL. Leaves the use order alone, so looking
+    // (drawing) never changes what the tick will evict.
+    const Chunk* peek(int cx, int cy) {
+        int s = find(keyOf(cx, cy));
+        return s == NONE ? NULL : &slots[s];
+    }
+
+    StepResult step(Direction turn) {
+        StepResult result = {false, false};
+        if (over) return result;
+        stats.ticks++;
+        if (cfg.prefetch) collect();
+        if (turn != STOP && !((dir == LEFT && turn == RIGHT) || (dir == RIGHT && turn == LEFT) ||
+                              (dir == UP && turn == DOWN) || (dir == DOWN && turn == UP)))
+            dir = turn;
+
+        Point next = at(0);
+        if (dir == LEFT) next.x--;
+        if (dir == RIGHT) next.x++;
+        if (dir == UP) next.y--;
+        if (dir == DOWN) next.y++;
+
+        // The tail leaves first, so following it is not a collision
+        bool growing = count < length;
+        if (!growing) {
+            const Point& tail = at(count - 1);
+            cellAt(tail) = CELL_FREE;
+            pin(tail, -1);
+        }
+        Cell hit = (Cell)cellAt(next);
+        if (hit == CELL_OBSTACLE || hit == CELL_BODY) {
+            // Put the tail back: the snake dies where it stood
+            if (!growing) {
+                cellAt(at(count - 1)) = CELL_BODY;
+                pin(at(count - 1), 1);
+            }
+            over = true;
+            cause = hit == CELL_OBSTACLE ? HIT_OBSTACLE : HIT_SELF;
+            result.died = true;
+            return result;
+        }
+        if (hit == CELL_FOOD) {
+            score += 10;
+            length++;
+            result.ateFood = true;
+        }
+
+        if (growing) {
+            if (count == (int)ring.size()) {
+                // Double, unrolling the ring so the head is at slot 0
+                std::vector<Point> bigger(ring.size() * 2);
+                for (int k = 0; k < count; k++) bigger[k] = at(k);
+                ring.swap(bigger);
+                head = 0;
+            }
+            count++;
+        }
+        head = (head == 0 ? (int)ring.size() : head) - 1;
+        ring[head] = next;
+        cellAt(next) = CELL_BODY;
+        pin(next, 1);
+
+        stats.farthest = std::max(stats.farthest, (long long)std::abs(next.x) + std::abs(next.y));
+        int cx = next.x >> CHUNK_SHIFT, cy = next.y >> CHUNK_SHIFT;
+        if (cx != headCx || cy != headCy) {
+            headCx = cx;
+            headCy = cy;
+            warmAround();
+            if (cfg.prefetch) requestAhead();
+        }
+        return result;
+    }
+
+    void quit() {
+        if (!over) { over = true; cause = QUIT; }
+    }
+
+    const Point& getHead() const { return at(0); }
+    Direction getDirection() const { return dir; }
+    int getLength() const { return length; }
+    int getScore() const { return score; }
+    bool isOver() const { return over; }
+    DeathCause getDeathCause() const { return cause; }
+    const WorldStats& getStats() const { return stats; }
+    uint32_t getSeed() const { return cfg.seed; }
+    int getResident() const { return used; }
+
+    // Cache memory: chunk slots plus the hash table
+    size_t memoryBytes() const { return slots.capacity() * sizeof(Chunk) + keys.capacity() * (sizeof(uint64_t) + sizeof(int)); }
+};
+
+// Draws the world around the head under a two-row HUD. The view stays
+// put until the head nears its edge, then re-centres on it, so a frame
+// normally changes a few cells, not the whole screen. Only the chunks
+// the view overlaps are read, a row of cells at a time; a chunk that is
+// not resident is generated into scratch, never into the cache.
+class WorldView : public Screen {
+private:
+    int viewW, viewH;
+    int left, top; // World cell at the view's top-left
+    bool placed;
+    uint8_t scratch[World::CHUNK_CELLS];
+
+    static ScreenCell glyphOf(uint8_t c) {
+        switch (c) {
+            case CELL_OBSTACLE: return {'X', 4};
+            case CELL_BODY: return {'o', 2};
+            case CELL_FOOD: return {'@', 13};
+        }
+        return {' ', 7};
+    }
+
+public:
+    WorldView(RenderBackend& backend, int viewW, int viewH)
+        : Screen(backend, std::max(1 + viewW, 80), 2 + viewH), viewW(viewW), viewH(viewH), left(0), top(0), placed(false) {}
+
+    void present(World& world) {
+        SNAKE_PHASE(PHASE_DRAW);
+        auto t0 = std::chrono::steady_clock::now();
+        const Point& h = world.getHead();
+        int mx = viewW / 4, my = viewH / 4;
+        if (!placed || h.x < left + mx || h.x >= left + viewW - mx || h.y < top + my || h.y >= top + viewH - my) {
+            left = h.x - viewW / 2;
+            top = h.y - viewH / 2;
+            placed = true;
+        }
+        const int S = World::CHUNK_SHIFT, C = World::CHUNK;
+        for (int cy = top >> S; cy <= (top + viewH - 1) >> S; cy++) {
+            for (int cx = left >> S; cx <= (left + viewW - 1) >> S; cx++) {
+                const World::Chunk* chunk = world.peek(cx, cy);
+                const uint8_t* cells = chunk ? chunk->cells : scratch;
+                if (!chunk) World::generate(world.getSeed(), cx, cy, scratch);
+                int x0 = std::max(left, cx * C), x1 = std::min(left + viewW, (cx + 1) * C);
+                int y0 = std::max(top, cy * C), y1 = std::min(top + viewH, (cy + 1) * C);
+                for (int y = y0; y < y1; y++) {
+                    const uint8_t* row = cells + (y - cy * C) * C - cx * C;
+                    for (int x = x0; x < x1; x++) {
+                        ScreenCell g = (x == h.x && y == h.y) ? ScreenCell{'O', 10} : glyphOf(row[x]);
+                        put(1 + x - left, 2 + y - top, g.glyph, g.color);
+                    }
+                }
+            }
+        }
+        flushFrame(t0);
+    }
+};